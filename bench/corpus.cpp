@@ -0,0 +1,548 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-07
+ */
+
+#include "corpus.hpp"
+
+#include <random>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+/**
+ * What a value can be used for. Integer values, including booleans and
+ * characters, can be operands of every operator, floating point values
+ * cannot be operands of `%`, `~` and the bitwise and shift operators, and
+ * strings can only be assigned
+ */
+enum class Kind { Integer, Float, String };
+
+struct TypeName {
+    std::string_view name;
+    Kind kind;
+};
+
+constexpr std::string_view UnaryOperators[] = {"-", "!", "~"};
+constexpr std::string_view IntegerOperators[] = {
+    "+", "-", "*", "**", "&", "|", "^", "<<", ">>"};
+constexpr std::string_view FloatOperators[] = {"+", "-", "*", "**"};
+constexpr std::string_view DivisionOperators[] = {"/", "%"};
+constexpr std::string_view ComparisonOperators[] = {
+    "==", "!=", "<", ">", "<=", ">=", "&&", "||"};
+constexpr std::string_view IntegerAssignOperators[] = {
+    "=", "+=", "-=", "*=", "<<=", ">>=", "&=", "|=", "^=", "/=", "%="};
+constexpr std::string_view FloatAssignOperators[] = {
+    "=", "+=", "-=", "*=", "/="};
+constexpr TypeName Types[] = {{"i8", Kind::Integer},
+                              {"i16", Kind::Integer},
+                              {"i32", Kind::Integer},
+                              {"i64", Kind::Integer},
+                              {"u32", Kind::Integer},
+                              {"f32", Kind::Float},
+                              {"f64", Kind::Float},
+                              {"string", Kind::String}};
+constexpr std::string_view Words[] = {"alpha",
+                                      "beta",
+                                      "gamma",
+                                      "value",
+                                      "result",
+                                      "counter",
+                                      "with a few spaces",
+                                      "tab\\tseparated",
+                                      "quote \\\" inside",
+                                      "unicode \\u00e9"};
+
+constexpr unsigned MAX_EXPR_DEPTH = 3;
+constexpr unsigned MAX_BLOCK_DEPTH = 3;
+constexpr unsigned MAX_MISSES = 8;
+
+struct Variable {
+    std::string name;
+    Kind kind;
+    bool isMutable;
+};
+
+class CorpusWriter {
+public:
+    CorpusWriter(std::size_t size, std::uint32_t seed, bool lowerable)
+        : _size{size}, _rng{seed}, _lowerable{lowerable}
+    {
+        _out.reserve(size + 1024);
+        _scopes.emplace_back();
+    }
+
+    std::string generate()
+    {
+        // declarations that would exceed the size are dropped, a few
+        // smaller ones are tried before giving up
+        for (auto misses = 0u; misses < MAX_MISSES;) {
+            auto size = _out.size();
+            auto globals = _scopes.back().size();
+            if (chance(4))
+                globalVariable();
+            else
+                function();
+            _out += '\n';
+
+            if (_out.size() <= _size or size == 0)
+                continue;
+            _out.resize(size);
+            _scopes.back().resize(globals);
+            misses++;
+        }
+        return std::move(_out);
+    }
+
+private:
+    unsigned pick(unsigned n) { return unsigned(_rng() % n); }
+    bool chance(unsigned oneIn) { return pick(oneIn) == 0; }
+
+    template <typename T, std::size_t N>
+    const T &pick(const T (&items)[N])
+    {
+        return items[pick(N)];
+    }
+
+    std::string fresh(char prefix)
+    {
+        return prefix + std::to_string(_counter++);
+    }
+
+    void indent() { _out.append(_indent * 4, ' '); }
+
+    void define(std::string name, Kind kind, bool isMutable)
+    {
+        _scopes.back().push_back({std::move(name), kind, isMutable});
+    }
+
+    /**
+     * @return a variable in scope whose value can be used as a value of
+     * the given kind, integers can be used as floating point values
+     */
+    const Variable *variable(Kind kind, bool mutableOnly = false)
+    {
+        // prefer the innermost scopes, they are the most likely to be used
+        for (auto it = _scopes.rbegin(); it != _scopes.rend(); it++) {
+            if (it->empty() or chance(4))
+                continue;
+            auto &var = (*it)[pick(unsigned(it->size()))];
+            auto matches = var.kind == kind or
+                           (kind == Kind::Float and var.kind == Kind::Integer);
+            if (matches and (!mutableOnly or var.isMutable))
+                return &var;
+        }
+        return nullptr;
+    }
+
+    /**
+     * Writes an integer literal that is never zero, so that it can be
+     * a divisor
+     */
+    void integerLiteral()
+    {
+        switch (pick(6)) {
+        case 0:
+            _out += "0x";
+            _out += std::to_string(1 + _rng() % 0xFFFF);
+            break;
+        case 1:
+            _out += "0b101";
+            _out += std::to_string(pick(2));
+            break;
+        case 2:
+            _out += '0';
+            _out += std::to_string(1 + pick(7));
+            break;
+        case 3:
+            _out += '\'';
+            _out += char('a' + pick(26));
+            _out += '\'';
+            break;
+        default:
+            _out += std::to_string(1 + _rng() % 100000);
+            break;
+        }
+    }
+
+    void floatLiteral()
+    {
+        _out += std::to_string(1 + pick(1000));
+        _out += '.';
+        _out += std::to_string(pick(100));
+    }
+
+    void literal(Kind kind)
+    {
+        if (kind == Kind::Float and chance(2))
+            floatLiteral();
+        else if (chance(8))
+            _out += (chance(2) ? "true" : "false");
+        else
+            integerLiteral();
+    }
+
+    void primary(Kind kind)
+    {
+        if (auto var = variable(kind); var and !chance(3))
+            _out += var->name;
+        else
+            literal(kind);
+    }
+
+    /**
+     * Writes an expression whose value has the given kind, binary
+     * operations are grouped so that precedence cannot mix operands of
+     * different kinds
+     */
+    void expression(Kind kind, unsigned depth = 0)
+    {
+        if (depth >= MAX_EXPR_DEPTH) {
+            primary(kind);
+            return;
+        }
+
+        switch (pick(11)) {
+        case 0:
+            _out += '(';
+            expression(kind, depth + 1);
+            _out += ')';
+            break;
+        case 1:
+            if (kind == Kind::Integer)
+                _out += pick(UnaryOperators);
+            else
+                _out += '-';
+            primary(kind);
+            break;
+        case 2:
+            // the ternary and coalescing operators bind loosely, keep them
+            // grouped so that they can appear anywhere
+            _out += '(';
+            expression(Kind::Float, depth + 1);
+            _out += " ? ";
+            expression(kind, depth + 1);
+            _out += " : ";
+            expression(kind, depth + 1);
+            _out += ')';
+            break;
+        case 3:
+            _out += '(';
+            primary(kind);
+            _out += " ?? ";
+            primary(kind);
+            _out += ')';
+            break;
+        case 4:
+        case 5:
+            primary(kind);
+            break;
+        case 6:
+            // comparisons accept any number and yield a boolean
+            _out += '(';
+            expression(Kind::Float, depth + 1);
+            _out += ' ';
+            _out += pick(ComparisonOperators);
+            _out += ' ';
+            expression(Kind::Float, depth + 1);
+            _out += ')';
+            break;
+        case 7:
+            // divisors are literals, constant divisions by zero are
+            // diagnosed when folding
+            _out += '(';
+            expression(kind, depth + 1);
+            if (kind == Kind::Integer) {
+                _out += ' ';
+                _out += pick(DivisionOperators);
+                _out += ' ';
+                integerLiteral();
+            }
+            else {
+                _out += " / ";
+                floatLiteral();
+            }
+            _out += ')';
+            break;
+        default:
+            _out += '(';
+            expression(kind, depth + 1);
+            _out += ' ';
+            if (kind == Kind::Integer)
+                _out += pick(IntegerOperators);
+            else
+                _out += pick(FloatOperators);
+            _out += ' ';
+            expression(kind, depth + 1);
+            _out += ')';
+            break;
+        }
+    }
+
+    void string()
+    {
+        _out += '"';
+        _out += pick(Words);
+        _out += ' ';
+        _out += pick(Words);
+        _out += '"';
+    }
+
+    /**
+     * Writes a string expression interpolating numbers
+     */
+    void stringExpression()
+    {
+        _out += "f\"";
+        _out += pick(Words);
+        for (auto i = 0u, n = 1 + pick(3); i < n; i++) {
+            _out += " ${";
+            expression(Kind::Float, MAX_EXPR_DEPTH - 1);
+            _out += "} ";
+            _out += pick(Words);
+        }
+        _out += '"';
+    }
+
+    void value(Kind kind)
+    {
+        if (kind != Kind::String)
+            expression(kind);
+        else if (!_lowerable and chance(2))
+            stringExpression();
+        else
+            string();
+    }
+
+    void comment()
+    {
+        indent();
+        if (chance(3)) {
+            _out += "/* ";
+            _out += pick(Words);
+            _out += "\n";
+            indent();
+            _out += " * /* nested */ ";
+            _out += pick(Words);
+            _out += "\n";
+            indent();
+            _out += " */\n";
+        }
+        else {
+            _out += "// ";
+            _out += pick(Words);
+            _out += ' ';
+            _out += pick(Words);
+            _out += '\n';
+        }
+    }
+
+    void variableDecl()
+    {
+        auto isMutable = !chance(3);
+        auto name = fresh('v');
+        auto &type = pick(Types);
+        indent();
+        _out += (isMutable ? "mut " : "imm ");
+        _out += name;
+        if (chance(2)) {
+            _out += ": ";
+            _out += type.name;
+        }
+        _out += " = ";
+        value(type.kind);
+        _out += ";\n";
+        define(std::move(name), type.kind, isMutable);
+    }
+
+    void assignment()
+    {
+        auto var = variable(pick(Types).kind, true);
+        if (var == nullptr) {
+            variableDecl();
+            return;
+        }
+        indent();
+        _out += var->name;
+        _out += ' ';
+        std::string_view op = "=";
+        if (var->kind == Kind::Integer)
+            op = pick(IntegerAssignOperators);
+        else if (var->kind == Kind::Float)
+            op = pick(FloatAssignOperators);
+        _out += op;
+        _out += ' ';
+        if (op == "/=" or op == "%=") {
+            if (var->kind == Kind::Integer)
+                integerLiteral();
+            else
+                floatLiteral();
+        }
+        else {
+            value(var->kind);
+        }
+        _out += ";\n";
+    }
+
+    void block(unsigned depth)
+    {
+        _out += "{\n";
+        _indent++;
+        _scopes.emplace_back();
+        for (auto i = 0u, n = 2 + pick(5); i < n; i++)
+            statement(depth + 1);
+        _scopes.pop_back();
+        _indent--;
+        indent();
+        _out += '}';
+    }
+
+    void ifStmt(unsigned depth)
+    {
+        indent();
+        _out += "if (";
+        expression(Kind::Float, 1);
+        _out += ") ";
+        block(depth);
+        if (chance(2)) {
+            _out += " else ";
+            block(depth);
+        }
+        _out += '\n';
+    }
+
+    void whileStmt(unsigned depth)
+    {
+        indent();
+        _out += "while (";
+        expression(Kind::Float, 1);
+        _out += ") ";
+        block(depth);
+        _out += '\n';
+    }
+
+    void forStmt(unsigned depth)
+    {
+        auto name = fresh('i');
+        indent();
+        _out += "for (mut " + name + " = 0; " + name + " < ";
+        _out += std::to_string(1 + pick(100));
+        _out += "; " + name + "++) ";
+        _scopes.emplace_back();
+        define(std::move(name), Kind::Integer, true);
+        block(depth);
+        _scopes.pop_back();
+        _out += '\n';
+    }
+
+    void statement(unsigned depth)
+    {
+        auto nested = depth < MAX_BLOCK_DEPTH;
+        switch (pick(nested ? 12 : 8)) {
+        case 0:
+            comment();
+            break;
+        case 1:
+        case 2:
+        case 3:
+            variableDecl();
+            break;
+        case 4:
+        case 5:
+        case 6:
+            assignment();
+            break;
+        case 7:
+            indent();
+            expression(Kind::Float);
+            _out += ";\n";
+            break;
+        case 8:
+        case 9:
+            ifStmt(depth);
+            break;
+        case 10:
+            whileStmt(depth);
+            break;
+        default:
+            forStmt(depth);
+            break;
+        }
+    }
+
+    void globalVariable()
+    {
+        // globals are initialized with literals
+        if (chance(2))
+            comment();
+        auto isMutable = !chance(3);
+        auto name = fresh('g');
+        auto &type = pick(Types);
+        _out += (isMutable ? "mut " : "imm ");
+        _out += name;
+        if (chance(2)) {
+            _out += ": ";
+            _out += type.name;
+        }
+        _out += " = ";
+        if (type.kind == Kind::String)
+            string();
+        else
+            literal(type.kind);
+        _out += ";\n";
+        define(std::move(name), type.kind, isMutable);
+    }
+
+    void function()
+    {
+        if (chance(2))
+            comment();
+        _out += "func ";
+        _out += fresh('f');
+        _out += '(';
+        _scopes.emplace_back();
+        for (auto i = 0u, n = pick(4); i < n; i++) {
+            auto name = fresh('a');
+            // parameters are numbers
+            auto &type = Types[pick(std::size(Types) - 1)];
+            if (i)
+                _out += ", ";
+            _out += name;
+            _out += ": ";
+            _out += type.name;
+            define(std::move(name), type.kind, true);
+        }
+        _out += ") ";
+        block(0);
+        _scopes.pop_back();
+        _out += '\n';
+    }
+
+    std::size_t _size;
+    std::mt19937 _rng;
+    /** string expressions are not generated, the lowering rejects them */
+    bool _lowerable;
+    std::string _out{};
+    std::vector<std::vector<Variable>> _scopes{};
+    unsigned _counter{0};
+    unsigned _indent{0};
+};
+
+} // namespace
+
+namespace cstar::bench {
+
+std::string generateCorpus(std::size_t size,
+                           std::uint32_t seed,
+                           bool lowerable)
+{
+    return CorpusWriter(size, seed, lowerable).generate();
+}
+
+} // namespace cstar::bench
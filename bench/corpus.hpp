@@ -0,0 +1,36 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-07
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace cstar::bench {
+
+/**
+ * Generates a syntactically and semantically valid cstar program of at
+ * most `size` bytes, unless a single declaration is larger. The program is
+ * made of global declarations and functions with nested control flow,
+ * string literals, string expressions, numeric literals of every base and
+ * both kinds of comments. Every operation is applied to values of a type
+ * supporting it, so the program can be folded.
+ *
+ * A `lowerable` program has no string expressions, so that it can be
+ * compiled by every backend.
+ *
+ * The generator only depends on `seed`, the same seed always yields the
+ * same program so that results can be compared between releases.
+ */
+std::string generateCorpus(std::size_t size,
+                           std::uint32_t seed = 1,
+                           bool lowerable = false);
+
+} // namespace cstar::bench
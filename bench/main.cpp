@@ -0,0 +1,320 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-07
+ */
+
+#include "corpus.hpp"
+
+#include "compiler/ast.hpp"
+#include "compiler/codegen.hpp"
+#include "compiler/lexer.hpp"
+#include "compiler/parser.hpp"
+#include "compiler/scan.hpp"
+#include "compiler/source.hpp"
+#include "compiler/symbol.hpp"
+#include "compiler/writer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#ifndef CSTAR_VERSION
+#define CSTAR_VERSION "unknown"
+#endif
+
+using namespace cstar;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::vector<std::size_t> sizes{1024, 64 * 1024, 1024 * 1024};
+    std::uint32_t seed{1};
+    unsigned iterations{3};
+    std::size_t jobs{1};
+    bool lowerable{false};
+    std::string emit{};
+};
+
+struct Result {
+    std::size_t size{0};
+    std::size_t bytes{0};
+    std::size_t tokens{0};
+    std::size_t nodes{0};
+    std::size_t output{0};
+    double lexer{0};
+    double parser{0};
+    double codegen{0};
+};
+
+[[noreturn]] void usage(const char *prog, int status)
+{
+    auto &os = status ? std::cerr : std::cout;
+    os << "usage: " << prog << " [options]\n"
+       << "\n"
+       << "Measures the throughput of the lexer, parser and code generator\n"
+       << "on synthetic sources and prints the results as JSON.\n"
+       << "\n"
+       << "  --sizes <list>       comma separated corpus sizes, with an\n"
+       << "                       optional K, M or G suffix (default\n"
+       << "                       1K,64K,1M)\n"
+       << "  --seed <n>           corpus generator seed (default 1)\n"
+       << "  --iterations <n>     runs per phase, the fastest is reported\n"
+       << "                       (default 3)\n"
+       << "  --jobs <n>           threads lexing each corpus (default 1)\n"
+       << "  --lowerable          generate no string expressions, so that\n"
+       << "                       every backend can compile the corpus\n"
+       << "  --emit <file>        write the corpus of the first size to\n"
+       << "                       the given file and exit\n";
+    exit(status);
+}
+
+std::size_t parseSize(std::string_view str)
+{
+    std::size_t multiplier = 1;
+    switch (str.empty() ? '\0' : str.back()) {
+    case 'k':
+    case 'K':
+        multiplier = 1024;
+        break;
+    case 'm':
+    case 'M':
+        multiplier = 1024 * 1024;
+        break;
+    case 'g':
+    case 'G':
+        multiplier = 1024 * 1024 * 1024;
+        break;
+    default:
+        break;
+    }
+    if (multiplier != 1)
+        str.remove_suffix(1);
+    return std::stoull(std::string{str}) * multiplier;
+}
+
+Options parseOptions(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg{argv[i]};
+        if (arg == "-h" or arg == "--help")
+            usage(argv[0], EXIT_SUCCESS);
+        if (arg == "--lowerable") {
+            options.lowerable = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+            usage(argv[0], EXIT_FAILURE);
+
+        std::string_view value{argv[++i]};
+        if (arg == "--sizes") {
+            options.sizes.clear();
+            while (!value.empty()) {
+                auto comma = value.find(',');
+                options.sizes.push_back(parseSize(value.substr(0, comma)));
+                value.remove_prefix(
+                    comma == std::string_view::npos ? value.size() : comma + 1);
+            }
+        }
+        else if (arg == "--seed")
+            options.seed = std::uint32_t(std::stoul(std::string{value}));
+        else if (arg == "--iterations")
+            options.iterations =
+                std::max(1u, unsigned(std::stoul(std::string{value})));
+        else if (arg == "--jobs")
+            options.jobs = std::max<std::size_t>(
+                1, std::stoull(std::string{value}));
+        else if (arg == "--emit")
+            options.emit = value;
+        else
+            usage(argv[0], EXIT_FAILURE);
+    }
+
+    if (options.sizes.empty())
+        usage(argv[0], EXIT_FAILURE);
+    return options;
+}
+
+std::size_t countNodes(const Node &root)
+{
+    std::size_t count = 0;
+    std::vector<const Node *> work{&root};
+    while (!work.empty()) {
+        auto node = work.back();
+        work.pop_back();
+        count++;
+        if (auto container = dyn_cast<ContainerNode>(node)) {
+            for (auto &child : container->all()) {
+                if (child)
+                    work.push_back(child);
+            }
+        }
+    }
+    return count;
+}
+
+/**
+ * Runs the given phase `iterations` times and returns the fastest run in
+ * seconds, `prepare` is run before each iteration and is not timed
+ */
+template <typename Prepare, typename Run>
+double measure(unsigned iterations, Prepare prepare, Run run)
+{
+    auto best = std::numeric_limits<double>::max();
+    for (auto i = 0u; i < iterations; i++) {
+        auto state = prepare();
+        auto start = Clock::now();
+        run(*state);
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+struct Pipeline {
+    Pipeline(Source &src, std::size_t jobs)
+        : lexer{L, src, gflLexerSkipComments},
+          symbols{std::make_shared<SymbolTable>()},
+          jobs{jobs}
+    {
+    }
+
+    void tokenize()
+    {
+        if (!lexer.tokenizeParallel(jobs))
+            abortCompiler(L);
+    }
+
+    /**
+     * Parses the tokens lexed up front, or pulls them from the lexer like
+     * the compiler does when the source was not lexed yet
+     */
+    void parse()
+    {
+        Parser parser(L, lexer, symbols);
+        if (!parser.parse(program))
+            abortCompiler(L);
+    }
+
+    Log L{};
+    Lexer lexer;
+    SymbolTable::Ptr symbols;
+    std::size_t jobs;
+    Program program{};
+};
+
+Result run(const Options &options, std::size_t size)
+{
+    Result result{.size = size};
+    Source src{"corpus-" + std::to_string(size) + ".cstr",
+               bench::generateCorpus(size, options.seed, options.lowerable)};
+    result.bytes = src.size();
+
+    result.lexer = measure(
+        options.iterations,
+        [&] { return std::make_unique<Pipeline>(src, options.jobs); },
+        [&](Pipeline &p) {
+            p.tokenize();
+            result.tokens = p.lexer.tokens().size();
+        });
+
+    result.parser = measure(
+        options.iterations,
+        [&] {
+            auto p = std::make_unique<Pipeline>(src, options.jobs);
+            p->tokenize();
+            return p;
+        },
+        [&](Pipeline &p) { p.parse(); });
+
+    std::unique_ptr<Pipeline> parsed;
+    result.codegen = measure(
+        options.iterations,
+        [&] {
+            if (parsed == nullptr) {
+                parsed = std::make_unique<Pipeline>(src, options.jobs);
+                parsed->parse();
+                result.nodes = countNodes(parsed->program);
+            }
+            return std::make_unique<CodeWriter>();
+        },
+        [&](CodeWriter &out) {
+            Codegen codegen(out);
+            codegen.generate(parsed->program);
+            result.output = out.size();
+        });
+
+    return result;
+}
+
+double perSecond(double count, double seconds)
+{
+    return seconds > 0 ? count / seconds : 0;
+}
+
+void report(std::ostream &os,
+            const Options &options,
+            const std::vector<Result> &results)
+{
+    constexpr double MB = 1024 * 1024;
+    os << std::fixed << std::setprecision(6);
+    os << "{\n"
+       << "  \"version\": \"" << CSTAR_VERSION << "\",\n"
+       << "  \"isa\": \"" << scan::toString(scan::isa()) << "\",\n"
+       << "  \"seed\": " << options.seed << ",\n"
+       << "  \"iterations\": " << options.iterations << ",\n"
+       << "  \"jobs\": " << options.jobs << ",\n"
+       << "  \"results\": [";
+
+    for (std::size_t i = 0; i < results.size(); i++) {
+        auto &r = results[i];
+        os << (i ? "," : "") << "\n    {\n"
+           << "      \"size\": " << r.size << ",\n"
+           << "      \"bytes\": " << r.bytes << ",\n"
+           << "      \"tokens\": " << r.tokens << ",\n"
+           << "      \"nodes\": " << r.nodes << ",\n"
+           << "      \"lexer\": {\"seconds\": " << r.lexer
+           << ", \"mbPerSec\": " << perSecond(r.bytes / MB, r.lexer)
+           << ", \"tokensPerSec\": " << perSecond(r.tokens, r.lexer) << "},\n"
+           << "      \"parser\": {\"seconds\": " << r.parser
+           << ", \"nodesPerSec\": " << perSecond(r.nodes, r.parser) << "},\n"
+           << "      \"codegen\": {\"seconds\": " << r.codegen
+           << ", \"bytes\": " << r.output
+           << ", \"bytesPerSec\": " << perSecond(r.output, r.codegen) << "}\n"
+           << "    }";
+    }
+    os << "\n  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    auto options = parseOptions(argc, argv);
+
+    if (!options.emit.empty()) {
+        std::ofstream out(options.emit, std::ios::binary);
+        out << bench::generateCorpus(
+            options.sizes.front(), options.seed, options.lowerable);
+        return out ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    std::vector<Result> results;
+    for (auto size : options.sizes)
+        results.push_back(run(options, size));
+
+    report(std::cout, options, results);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-05
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cstar {
+
+/**
+ * A bump allocator handing out memory from large blocks. Individual
+ * allocations are never freed, everything allocated from the arena is
+ * released at once when the arena is reset or destroyed.
+ */
+class Arena {
+public:
+    static constexpr std::size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    explicit Arena(std::size_t blockSize = DEFAULT_BLOCK_SIZE)
+        : _blockSize{blockSize}
+    {
+    }
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    void *allocate(std::size_t size,
+                   std::size_t align = alignof(std::max_align_t))
+    {
+        auto p = (std::uintptr_t(_cursor) + align - 1) & ~(align - 1);
+        if (_cursor == nullptr or p + size > std::uintptr_t(_end))
+            return grow(size, align);
+
+        _cursor = reinterpret_cast<char *>(p + size);
+        _allocated += size;
+        return reinterpret_cast<void *>(p);
+    }
+
+    /**
+     * Constructs a `T` in the arena, since the arena never runs
+     * destructors `T` must be trivially destructible
+     */
+    template <typename T, typename... Args>
+    T *make(Args &&...args)
+    {
+        static_assert(std::is_trivially_destructible_v<T>,
+                      "arena objects are never destroyed");
+        return new (allocate(sizeof(T), alignof(T)))
+            T(std::forward<Args>(args)...);
+    }
+
+    /**
+     * Copies the given string into the arena
+     */
+    std::string_view copy(std::string_view str);
+
+    /**
+     * Takes ownership of everything allocated from the given arena,
+     * leaving it empty
+     */
+    void merge(Arena &&other);
+
+    /**
+     * @return the number of bytes handed out by the arena
+     */
+    std::size_t allocated() const { return _allocated; }
+
+    /**
+     * Releases everything allocated from the arena
+     */
+    void reset();
+
+private:
+    void *grow(std::size_t size, std::size_t align);
+
+    std::vector<std::unique_ptr<char[]>> _blocks{};
+    char *_cursor{nullptr};
+    char *_end{nullptr};
+    std::size_t _blockSize{DEFAULT_BLOCK_SIZE};
+    std::size_t _allocated{0};
+};
+
+} // namespace cstar
@@ -10,130 +10,181 @@
 
 #pragma once
 
+#include <compiler/strings.hpp>
 #include <compiler/token.hpp>
 #include <compiler/types.hpp>
 #include <compiler/vistor.hpp>
 
+#include <cstdint>
+#include <vector>
+
 namespace cstar {
 
 class Program final : public ContainerNode {
 public:
-    using ContainerNode::ContainerNode;
+    CSTAR_NODE_KIND(Program);
+
+    Program(Range range = {}) : ContainerNode(Kind, std::move(range)) {}
+
     CYN_CONTAINER_NODE_VIEW(0, statements);
+
+    /**
+     * @return the arena owning all the nodes of the program
+     */
+    AstArena &arena() { return _arena; }
+
+private:
+    AstArena _arena{};
 };
 
 struct Expr : public ContainerNode {
 public:
-    CSTAR_PTR(Expr);
-
-    Expr(Range range = {});
-    Expr(Type::Ptr type, Range range = {});
+    CSTAR_NODE_PTR(Expr);
 
     CYN_CONTAINER_NODE_MEMBER(Type, 0, type);
+
+    static bool classof(NodeKind kind)
+    {
+        switch (kind) {
+#define XX(N) case NodeKind::N##Expr:
+            NODE_EXPR_LIST(XX)
+#undef XX
+            return true;
+        default:
+            return false;
+        }
+    }
+
+protected:
+    Expr(NodeKind kind, std::span<Node::Ptr> slots, Range range = {});
+    Expr(NodeKind kind,
+         std::span<Node::Ptr> slots,
+         Type::Ptr type,
+         Range range = {});
 };
 
 struct Stmt : public ContainerNode {
 public:
-    CSTAR_PTR(Stmt);
+    CSTAR_NODE_PTR(Stmt);
 
+    static bool classof(NodeKind kind)
+    {
+        switch (kind) {
+        case NodeKind::Block:
+#define XX(N) case NodeKind::N##Decl:
+            NODE_DECL_LIST(XX)
+#undef XX
+#define XX(N) case NodeKind::N##Stmt:
+            NODE_STMT_LIST(XX)
+#undef XX
+            return true;
+        default:
+            return false;
+        }
+    }
+
+protected:
     using ContainerNode::ContainerNode;
 };
 
 struct Block : public Stmt {
 public:
-    CSTAR_PTR(Block);
+    CSTAR_NODE_PTR(Block);
+    CSTAR_NODE_KIND(Block);
 
-    using Stmt::Stmt;
+    Block(Range range = {}) : Stmt(Kind, std::move(range)) {}
 
-    VisitableNode();
+    void add(AstArena &arena, Stmt::Ptr stmt) { insert(arena, stmt); }
 };
 
 struct StatementList : public ContainerNode {
 public:
-    CSTAR_PTR(StatementList);
+    CSTAR_NODE_PTR(StatementList);
+    CSTAR_NODE_KIND(StatementList);
 
 public:
-    using ContainerNode::ContainerNode;
+    StatementList(Range range = {}) : ContainerNode(Kind, std::move(range)) {}
 
     CYN_CONTAINER_NODE_VIEW(0, stmts);
 
-    void add(Stmt::Ptr stmts) { push(std::move(stmts)); }
-
-    VisitableNode()
+    void add(AstArena &arena, Stmt::Ptr stmt) { insert(arena, stmt); }
 };
 
-struct FunctionDecl : public Stmt {
+struct FunctionDecl : private NodeSlots<3>, public Stmt {
 public:
-    CSTAR_PTR(FunctionDecl);
+    CSTAR_NODE_PTR(FunctionDecl);
+    CSTAR_NODE_KIND(FunctionDecl);
 
     CYN_CONTAINER_NODE_MEMBER(Type, 0, returnType);
     CYN_CONTAINER_NODE_MEMBER(StatementList, 1, params);
     CYN_CONTAINER_NODE_MEMBER(Stmt, 2, body);
 
-    explicit FunctionDecl(std::string_view name, Range range = {});
+    explicit FunctionDecl(Strings::Id name, Range range = {});
 
-    VisitableNode();
+    /** the spelling of the interned name, for printing */
+    std::string_view text() const { return Strings::get(name); }
 
-    std::string_view name{};
+    Strings::Id name{0};
 };
 
-struct VariableExpr : public Expr {
+struct VariableExpr : private NodeSlots<1>, public Expr {
 public:
-    CSTAR_PTR(VariableExpr);
+    CSTAR_NODE_PTR(VariableExpr);
+    CSTAR_NODE_KIND(VariableExpr);
 
 public:
-    explicit VariableExpr(std::string_view name, Range range = {})
-        : Expr(std::move(range)), name{name}
+    explicit VariableExpr(Strings::Id name, Range range = {})
+        : Expr(Kind, slots(), std::move(range)), name{name}
     {
     }
 
-    VisitableNode();
+    /** the spelling of the interned name, for printing */
+    std::string_view text() const { return Strings::get(name); }
 
-    std::string_view name{};
+    Strings::Id name{0};
 };
 
-struct AssignmentExpr : public Expr {
+struct AssignmentExpr : private NodeSlots<3>, public Expr {
 public:
-    CSTAR_PTR(AssignmentExpr);
+    CSTAR_NODE_PTR(AssignmentExpr);
+    CSTAR_NODE_KIND(AssignmentExpr);
 
     AssignmentExpr(Expr::Ptr assignee, Expr::Ptr value, Range range = {});
 
     CYN_CONTAINER_NODE_MEMBER(Expr, 1, assignee);
     CYN_CONTAINER_NODE_MEMBER(Expr, 2, value);
-
-    VisitableNode()
 };
 
-struct NullishCoalescingExpr : public Expr {
+struct NullishCoalescingExpr : private NodeSlots<3>, public Expr {
 public:
-    CSTAR_PTR(NullishCoalescingExpr);
+    CSTAR_NODE_PTR(NullishCoalescingExpr);
+    CSTAR_NODE_KIND(NullishCoalescingExpr);
 
     NullishCoalescingExpr(Expr::Ptr lhs, Expr::Ptr rhs, Range range = {});
 
     CYN_CONTAINER_NODE_MEMBER(Expr, 1, lhs);
     CYN_CONTAINER_NODE_MEMBER(Expr, 2, rhs);
-
-    VisitableNode()
 };
 
-struct StringExpressionExpr : public Expr {
+struct StringExpressionExpr : private NodeSlots<1>, public Expr {
 public:
-    CSTAR_PTR(StringExpressionExpr);
+    CSTAR_NODE_PTR(StringExpressionExpr);
+    CSTAR_NODE_KIND(StringExpressionExpr);
 
-    using Expr::Expr;
+    explicit StringExpressionExpr(Range range = {})
+        : Expr(Kind, slots(), std::move(range))
+    {
+    }
 
     CYN_CONTAINER_NODE_VIEW(1, parts);
 
-    void addPart(Expr::Ptr node) { push(std::move(node)); }
-
-    VisitableNode()
+    void addPart(AstArena &arena, Expr::Ptr part) { insert(arena, part); }
 };
 
-struct TernaryExpr : public Expr {
+struct TernaryExpr : private NodeSlots<4>, public Expr {
 public:
-    CSTAR_PTR(TernaryExpr);
-
-    using Expr::Expr;
+    CSTAR_NODE_PTR(TernaryExpr);
+    CSTAR_NODE_KIND(TernaryExpr);
 
     TernaryExpr(Expr::Ptr cond,
                 Expr::Ptr iTrue,
@@ -143,15 +194,12 @@ public:
     CYN_CONTAINER_NODE_MEMBER(Expr, 1, condition);
     CYN_CONTAINER_NODE_MEMBER(Expr, 2, ifTrue);
     CYN_CONTAINER_NODE_MEMBER(Expr, 3, ifFalse);
-
-    VisitableNode()
 };
 
-struct BinaryExpr : public Expr {
+struct BinaryExpr : private NodeSlots<3>, public Expr {
 public:
-    CSTAR_PTR(BinaryExpr);
-
-    using Expr::Expr;
+    CSTAR_NODE_PTR(BinaryExpr);
+    CSTAR_NODE_KIND(BinaryExpr);
 
     BinaryExpr(Expr::Ptr left,
                Token::Kind op,
@@ -161,239 +209,347 @@ public:
     CYN_CONTAINER_NODE_MEMBER(Expr, 1, left);
     CYN_CONTAINER_NODE_MEMBER(Expr, 2, right);
 
-    VisitableNode();
-
     Token::Kind op{};
 };
 
-struct PrefixExpr : public Expr {
+struct PrefixExpr : private NodeSlots<2>, public Expr {
 public:
-    CSTAR_PTR(PrefixExpr);
+    CSTAR_NODE_PTR(PrefixExpr);
+    CSTAR_NODE_KIND(PrefixExpr);
 
     PrefixExpr(Token::Kind op, Expr::Ptr operand, Range range = {});
 
     CYN_CONTAINER_NODE_MEMBER(Expr, 1, operand);
 
-    VisitableNode();
-
     Token::Kind op{};
 };
 
-struct PostfixExpr : public Expr {
+struct PostfixExpr : private NodeSlots<2>, public Expr {
 public:
-    CSTAR_PTR(PostfixExpr);
+    CSTAR_NODE_PTR(PostfixExpr);
+    CSTAR_NODE_KIND(PostfixExpr);
 
     PostfixExpr(Token::Kind op, Expr::Ptr operand, Range range = {});
 
     CYN_CONTAINER_NODE_MEMBER(Expr, 1, operand);
 
-    VisitableNode();
-
     Token::Kind op{};
 };
 
-struct UnaryExpr : public Expr {
+struct UnaryExpr : private NodeSlots<2>, public Expr {
 public:
-    CSTAR_PTR(UnaryExpr);
-
-    using Expr::Expr;
+    CSTAR_NODE_PTR(UnaryExpr);
+    CSTAR_NODE_KIND(UnaryExpr);
 
     UnaryExpr(Token::Kind op, Expr::Ptr operand, Range range = {});
 
     CYN_CONTAINER_NODE_MEMBER(Expr, 1, operand);
 
-    VisitableNode();
-
     Token::Kind op{};
 };
 
 struct LiteralExpr : public Expr {
 public:
-    CSTAR_PTR(LiteralExpr);
+    CSTAR_NODE_PTR(LiteralExpr);
 
-    using Expr::Expr;
+    static bool classof(NodeKind kind)
+    {
+        switch (kind) {
+        case NodeKind::BoolExpr:
+        case NodeKind::CharExpr:
+        case NodeKind::IntegerExpr:
+        case NodeKind::FloatExpr:
+        case NodeKind::StringExpr:
+            return true;
+        default:
+            return false;
+        }
+    }
 
-    VisitableNode()
+protected:
+    using Expr::Expr;
 };
 
-struct BoolExpr : public LiteralExpr {
+struct BoolExpr : private NodeSlots<1>, public LiteralExpr {
 public:
-    CSTAR_PTR(BoolExpr);
-
-    using LiteralExpr::LiteralExpr;
+    CSTAR_NODE_PTR(BoolExpr);
+    CSTAR_NODE_KIND(BoolExpr);
 
     explicit BoolExpr(bool value, Range range = {});
 
-    VisitableNode();
-
     bool value{};
 };
 
-struct CharExpr : public LiteralExpr {
+struct CharExpr : private NodeSlots<1>, public LiteralExpr {
 public:
-    CSTAR_PTR(CharExpr);
-
-    using LiteralExpr::LiteralExpr;
+    CSTAR_NODE_PTR(CharExpr);
+    CSTAR_NODE_KIND(CharExpr);
 
     explicit CharExpr(uint32_t value, Range range = {});
 
-    VisitableNode();
-
     uint32_t value{};
 };
 
-struct IntegerExpr : public LiteralExpr {
+struct IntegerExpr : private NodeSlots<1>, public LiteralExpr {
 public:
-    CSTAR_PTR(IntegerExpr);
+    CSTAR_NODE_PTR(IntegerExpr);
+    CSTAR_NODE_KIND(IntegerExpr);
 
 public:
-    using LiteralExpr::LiteralExpr;
-
     explicit IntegerExpr(int64_t value, Range range = {});
 
-    VisitableNode();
-
     int64_t value{};
 };
 
-struct FloatExpr : public LiteralExpr {
+struct FloatExpr : private NodeSlots<1>, public LiteralExpr {
 public:
-    CSTAR_PTR(FloatExpr);
-
-    using LiteralExpr::LiteralExpr;
+    CSTAR_NODE_PTR(FloatExpr);
+    CSTAR_NODE_KIND(FloatExpr);
 
     explicit FloatExpr(double value, Range range = {});
 
-    VisitableNode();
-
     double value{};
 };
 
-struct StringExpr : public LiteralExpr {
+struct StringExpr : private NodeSlots<1>, public LiteralExpr {
 public:
-    CSTAR_PTR(StringExpr);
-
-    using LiteralExpr::LiteralExpr;
+    CSTAR_NODE_PTR(StringExpr);
+    CSTAR_NODE_KIND(StringExpr);
 
     StringExpr(std::string_view value, Range range = {});
 
-    VisitableNode();
-
     std::string_view value{};
 };
 
-struct GroupingExpr : public Expr {
+struct GroupingExpr : private NodeSlots<2>, public Expr {
 public:
-    CSTAR_PTR(GroupingExpr);
+    CSTAR_NODE_PTR(GroupingExpr);
+    CSTAR_NODE_KIND(GroupingExpr);
 
 public:
-    using Expr::Expr;
     GroupingExpr(Expr::Ptr expr, Range range = {});
 
     CYN_CONTAINER_NODE_MEMBER(Expr, 1, expr);
-
-    VisitableNode()
 };
 
 struct ExpressionList : public ContainerNode {
 public:
-    CSTAR_PTR(ExpressionList);
+    CSTAR_NODE_PTR(ExpressionList);
+    CSTAR_NODE_KIND(ExpressionList);
 
 public:
-    using ContainerNode::ContainerNode;
+    ExpressionList(Range range = {}) : ContainerNode(Kind, std::move(range))
+    {
+    }
 
     CYN_CONTAINER_NODE_VIEW(0, exprs);
 
-    void add(Expr::Ptr expr) { push(std::move(expr)); }
-
-    VisitableNode()
+    void add(AstArena &arena, Expr::Ptr expr) { insert(arena, expr); }
 };
 
-struct CallExpr : public Expr {
+struct CallExpr : private NodeSlots<3>, public Expr {
 public:
-    CSTAR_PTR(CallExpr);
+    CSTAR_NODE_PTR(CallExpr);
+    CSTAR_NODE_KIND(CallExpr);
 
 public:
-    using Expr::Expr;
     CallExpr(Expr::Ptr callee, Range range = {});
 
     CYN_CONTAINER_NODE_MEMBER(Expr, 1, callee);
     CYN_CONTAINER_NODE_MEMBER(ExpressionList, 2, arguments);
-
-    VisitableNode()
 };
 
-class ExpressionStmt : public Stmt {
+class ExpressionStmt : private NodeSlots<1>, public Stmt {
 public:
-    CSTAR_PTR(ExpressionStmt);
-    using Stmt::Stmt;
+    CSTAR_NODE_PTR(ExpressionStmt);
+    CSTAR_NODE_KIND(ExpressionStmt);
 
     ExpressionStmt(Expr::Ptr expr, Range range = {});
 
     CYN_CONTAINER_NODE_MEMBER(Expr, 0, expr);
-
-    VisitableNode();
 };
 
-class DeclarationStmt : public Stmt {
+class DeclarationStmt : private NodeSlots<2>, public Stmt {
 public:
-    CSTAR_PTR(DeclarationStmt);
-    using Stmt::Stmt;
-    DeclarationStmt(std::string_view name, bool imm, Range range = {});
+    CSTAR_NODE_PTR(DeclarationStmt);
+    static constexpr NodeKind Kind = NodeKind::DeclarationStmt;
+
+    DeclarationStmt(Strings::Id name, bool imm, Range range = {});
 
     CYN_CONTAINER_NODE_MEMBER(Type, 0, type);
     CYN_CONTAINER_NODE_MEMBER(Expr, 1, value);
 
-    VisitableNode();
+    static bool classof(NodeKind kind)
+    {
+        return kind == Kind or kind == NodeKind::ParameterStmt;
+    }
+
+    /** the spelling of the interned name, for printing */
+    std::string_view text() const { return Strings::get(name); }
+
+    Strings::Id name{0};
 
-    std::string_view name{};
+protected:
+    DeclarationStmt(NodeKind kind,
+                    Strings::Id name,
+                    bool imm,
+                    Range range = {});
 };
 
 class ParameterStmt : public DeclarationStmt {
 public:
-    CSTAR_PTR(ParameterStmt);
-    using DeclarationStmt::DeclarationStmt;
-    ParameterStmt(std::string_view name, Range range = {});
-
-    VisitableNode();
+    CSTAR_NODE_PTR(ParameterStmt);
+    CSTAR_NODE_KIND(ParameterStmt);
+    ParameterStmt(Strings::Id name, Range range = {});
 };
 
-class IfStmt : public Stmt {
+class IfStmt : private NodeSlots<3>, public Stmt {
 public:
-    CSTAR_PTR(IfStmt);
-    using Stmt::Stmt;
+    CSTAR_NODE_PTR(IfStmt);
+    CSTAR_NODE_KIND(IfStmt);
     IfStmt(Expr::Ptr cond, Range range = {});
 
     CYN_CONTAINER_NODE_MEMBER(Expr, 0, condition);
     CYN_CONTAINER_NODE_MEMBER(Stmt, 1, then);
     CYN_CONTAINER_NODE_MEMBER(Stmt, 2, otherwise);
-
-    VisitableNode();
 };
 
-class WhileStmt : public Stmt {
+class WhileStmt : private NodeSlots<2>, public Stmt {
 public:
-    CSTAR_PTR(WhileStmt);
-    using Stmt::Stmt;
+    CSTAR_NODE_PTR(WhileStmt);
+    CSTAR_NODE_KIND(WhileStmt);
     WhileStmt(Expr::Ptr cond, Range range = {});
 
     CYN_CONTAINER_NODE_MEMBER(Expr, 0, condition);
     CYN_CONTAINER_NODE_MEMBER(Stmt, 1, body);
-
-    VisitableNode();
 };
 
-class ForStmt : public Stmt {
+class ForStmt : private NodeSlots<4>, public Stmt {
 public:
-    CSTAR_PTR(ForStmt);
+    CSTAR_NODE_PTR(ForStmt);
+    CSTAR_NODE_KIND(ForStmt);
     ForStmt(Range range = {});
 
     CYN_CONTAINER_NODE_MEMBER(Stmt, 0, init);
     CYN_CONTAINER_NODE_MEMBER(Expr, 1, condition);
     CYN_CONTAINER_NODE_MEMBER(Expr, 2, update);
     CYN_CONTAINER_NODE_MEMBER(Stmt, 3, body);
+};
+
+/**
+ * Base class of the compiler passes. `dispatch` switches on the kind of a
+ * node and calls the `visit` overload of `Derived` that best matches the
+ * class of the node, there are no virtual calls and the handlers can be
+ * inlined into the dispatch.
+ *
+ * Trees are walked with an explicit worklist rather than the native stack
+ * so that arbitrarily deep programs can be visited. A handler is called
+ * with step 0 when its node is entered, it can `descend` into a child and
+ * return `true` to be resumed with the next step once that child has been
+ * visited. Returning `false` finishes the node.
+ *
+ * Passes only define the overloads they handle and bring the defaults,
+ * which do nothing, into scope with `using StaticVisitor<Derived>::visit`
+ */
+template <typename Derived>
+class StaticVisitor {
+public:
+    using Step = std::uint32_t;
+
+    void dispatch(Node &node)
+    {
+        const auto base = _frames.size();
+        _frames.push_back({&node, 0});
+        while (_frames.size() > base) {
+            auto [current, step] = _frames.back();
+            _frames.back().step++;
+            _next = nullptr;
+            if (!resume(*current, step))
+                _frames.pop_back();
+            if (_next != nullptr)
+                _frames.push_back({_next, 0});
+        }
+    }
+
+#define XX(N)                                                                  \
+    bool visit(N &, Step) { return false; }
+    NODE_LIST(XX)
+#undef XX
+
+#define XX(N)                                                                  \
+    bool visit(N##Type &, Step) { return false; }
+    NODE_TYPE_LIST(XX)
+#undef XX
+
+#define XX(N)                                                                  \
+    bool visit(N##Decl &, Step) { return false; }
+    NODE_DECL_LIST(XX)
+#undef XX
+
+#define XX(N)                                                                  \
+    bool visit(N##Stmt &, Step) { return false; }
+    NODE_STMT_LIST(XX)
+#undef XX
+
+#define XX(N)                                                                  \
+    bool visit(N##Expr &, Step) { return false; }
+    NODE_EXPR_LIST(XX)
+#undef XX
+
+protected:
+    /**
+     * Visits `child` before the current node is resumed, null children
+     * are skipped
+     */
+    bool descend(Node *child)
+    {
+        _next = child;
+        return true;
+    }
+
+private:
+    bool resume(Node &node, Step step)
+    {
+        auto &self = static_cast<Derived &>(*this);
+        switch (node.kind()) {
+#define XX(N)                                                                  \
+    case NodeKind::N:                                                          \
+        return self.visit(static_cast<N &>(node), step);
+            NODE_LIST(XX)
+            XX(Program)
+            XX(Type)
+#undef XX
+#define XX(N)                                                                  \
+    case NodeKind::N##Type:                                                    \
+        return self.visit(static_cast<N##Type &>(node), step);
+            NODE_TYPE_LIST(XX)
+#undef XX
+#define XX(N)                                                                  \
+    case NodeKind::N##Decl:                                                    \
+        return self.visit(static_cast<N##Decl &>(node), step);
+            NODE_DECL_LIST(XX)
+#undef XX
+#define XX(N)                                                                  \
+    case NodeKind::N##Stmt:                                                    \
+        return self.visit(static_cast<N##Stmt &>(node), step);
+            NODE_STMT_LIST(XX)
+#undef XX
+#define XX(N)                                                                  \
+    case NodeKind::N##Expr:                                                    \
+        return self.visit(static_cast<N##Expr &>(node), step);
+            NODE_EXPR_LIST(XX)
+#undef XX
+        }
+        return false;
+    }
+
+    struct Frame {
+        Node *node;
+        Step step;
+    };
 
-    VisitableNode();
+    std::vector<Frame> _frames{};
+    Node *_next{nullptr};
 };
 
 } // namespace cstar
\ No newline at end of file
@@ -10,58 +10,67 @@
 
 #pragma once
 
-#include "compiler/vistor.hpp"
+#include "compiler/ast.hpp"
+#include "compiler/writer.hpp"
 
-#include <sstream>
+#include <algorithm>
 
 namespace cstar {
 
-class Program;
-
-class Codegen : public Visitor {
+class Codegen : public StaticVisitor<Codegen> {
 public:
-    Codegen(std::ostream &os);
+    Codegen(CodeWriter &out);
     void generate(Program &p);
 
-    void visit(ContainerNode &node) override;
-    void visit(ExpressionList &node) override;
-    void visit(FunctionDecl &node) override;
-    void visit(Block &node) override;
-    void visit(UnaryExpr &node) override;
-    void visit(BinaryExpr &node) override;
-    void visit(GroupingExpr &node) override;
-    void visit(BoolExpr &node) override;
-    void visit(CharExpr &node) override;
-    void visit(IntegerExpr &node) override;
-    void visit(FloatExpr &node) override;
-    void visit(StringExpr &node) override;
-    void visit(VariableExpr &node) override;
-    void visit(AssignmentExpr &node) override;
-    void visit(CallExpr &node) override;
+    using StaticVisitor<Codegen>::visit;
+
+    bool visit(ContainerNode &node, Step step);
+    bool visit(ExpressionList &node, Step step);
+    bool visit(FunctionDecl &node, Step step);
+    bool visit(Block &node, Step step);
+    bool visit(UnaryExpr &node, Step step);
+    bool visit(BinaryExpr &node, Step step);
+    bool visit(GroupingExpr &node, Step step);
+    bool visit(BoolExpr &node, Step step);
+    bool visit(CharExpr &node, Step step);
+    bool visit(IntegerExpr &node, Step step);
+    bool visit(FloatExpr &node, Step step);
+    bool visit(StringExpr &node, Step step);
+    bool visit(VariableExpr &node, Step step);
+    bool visit(AssignmentExpr &node, Step step);
+    bool visit(CallExpr &node, Step step);
 
-    void visit(DeclarationStmt &node) override;
-    void visit(ExpressionStmt &node) override;
-    void visit(IfStmt &node) override;
-    void visit(WhileStmt &node) override;
-    void visit(ForStmt &node) override;
+    bool visit(DeclarationStmt &node, Step step);
+    bool visit(ExpressionStmt &node, Step step);
+    bool visit(IfStmt &node, Step step);
+    bool visit(WhileStmt &node, Step step);
+    bool visit(ForStmt &node, Step step);
 
 private:
     template <typename... Args>
     void AppendNl(Args &&...args)
     {
-        (_os << ... << args) << std::endl;
+        (_out << ... << args) << '\n';
     }
 
     template <typename... Args>
     void Append(Args &&...args)
     {
-        (_os << ... << args);
+        (_out << ... << args);
     }
 
-    void Tab() { _os << std::string(std::size_t(_level), ' '); }
-    void Nl() { _os << std::endl; }
+    /**
+     * Statements nested deeper than this are written at the same
+     * indentation, so that the output stays linear in the source
+     */
+    static constexpr int MAX_LEVEL = 64;
+
+    void Tab() { _out.indent(std::size_t(std::min(_level, MAX_LEVEL))); }
+    void Nl() { _out << '\n'; }
 
     int _level{0};
-    std::ostream &_os;
+    /** for loop initializers are written inline, without indentation */
+    int _inlineLevel{0};
+    CodeWriter &_out;
 };
 } // namespace cstar
\ No newline at end of file
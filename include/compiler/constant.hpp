@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-14
+ */
+
+#pragma once
+
+#include "compiler/token.hpp"
+#include "compiler/types.hpp"
+
+#include <cstdint>
+#include <optional>
+
+namespace cstar {
+
+bool isFloat(Type::Ptr type);
+bool isIntegral(Type::Ptr type);
+bool isSigned(Type::Ptr type);
+
+/**
+ * @return the type integral values are promoted to before an operation,
+ * as done in C
+ */
+Type::Ptr promoted(Type::Ptr type);
+
+/**
+ * @return the type of a binary operation on values of the given types,
+ * following the usual arithmetic conversions. Literals, which have no type
+ * in the source, take the type of the other operand.
+ */
+Type::Ptr arithmeticType(Type::Ptr lhs,
+                         bool lhsLiteral,
+                         Type::Ptr rhs,
+                         bool rhsLiteral);
+
+/**
+ * Wraps an integer to the range of the given integral type
+ */
+std::int64_t wrap(std::int64_t value, Type::Ptr type);
+
+/**
+ * Truncates a floating point number towards zero, like a conversion to
+ * an integer, numbers out of range are converted to 0
+ */
+std::int64_t truncate(double value, Type::Ptr type);
+
+/**
+ * A value of a boolean, character, integer or floating point type known at
+ * compile time. Integral values are wrapped to their type and kept in 64
+ * bits, unsigned 64-bit values as their bits.
+ */
+struct Constant {
+    Type::Ptr type{nullptr};
+    union {
+        std::int64_t integer{0};
+        double real;
+    };
+    /**
+     * Whether the value has the type of the expression it was computed
+     * from, the value of a literal takes the type of the other operand
+     */
+    bool typed{false};
+
+    /**
+     * @return the value of the constant as a condition
+     */
+    bool truthy() const { return isFloat(type) ? real != 0 : integer != 0; }
+};
+
+/**
+ * Converts a constant to the given boolean, character, integer or floating
+ * point type, the result is typed
+ */
+Constant convert(const Constant &value, Type::Ptr type);
+
+/**
+ * Evaluates a unary operator, the result is typed if the operand is
+ *
+ * @return nothing if the operation is invalid
+ */
+std::optional<Constant> evaluate(Token::Kind op, const Constant &operand);
+
+/**
+ * Evaluates a binary operator like the code generated for it does. The
+ * integer operations wrap, and shift counts are masked by the machine.
+ *
+ * @return nothing if the operation is invalid, if it traps at run time,
+ * like a division by zero, or if its result is not a finite number
+ */
+std::optional<Constant> evaluate(Token::Kind op,
+                                 const Constant &lhs,
+                                 const Constant &rhs);
+
+} // namespace cstar
@@ -10,32 +10,32 @@
 
 #pragma once
 
-#include "compiler/vistor.hpp"
+#include "compiler/ast.hpp"
 #include <cstdint>
 
 namespace cstar {
 
-    class AstDump final : public Visitor {
+    class AstDump final : public StaticVisitor<AstDump> {
     public:
         void dump(Program& program);
 
-#define OVERRIDE_VISIT(XX)  void visit(XX &node) override;
+#define OVERRIDE_VISIT(XX)  bool visit(XX &node, Step step);
         NODE_LIST(OVERRIDE_VISIT)
 #undef OVERRIDE_VISIT
 
-#define OVERRIDE_VISIT(XX)  void visit(XX##Type &node) override;
+#define OVERRIDE_VISIT(XX)  bool visit(XX##Type &node, Step step);
         NODE_TYPE_LIST(OVERRIDE_VISIT)
 #undef OVERRIDE_VISIT
 
-#define OVERRIDE_VISIT(XX)  void visit(XX##Expr &node) override;
+#define OVERRIDE_VISIT(XX)  bool visit(XX##Expr &node, Step step);
         NODE_EXPR_LIST(OVERRIDE_VISIT)
 #undef OVERRIDE_VISIT
 
-#define OVERRIDE_VISIT(XX)  void visit(XX##Stmt &node) override;
+#define OVERRIDE_VISIT(XX)  bool visit(XX##Stmt &node, Step step);
         NODE_STMT_LIST(OVERRIDE_VISIT)
 #undef OVERRIDE_VISIT
 
-#define OVERRIDE_VISIT(XX)  void visit(XX##Decl &node) override;
+#define OVERRIDE_VISIT(XX)  bool visit(XX##Decl &node, Step step);
         NODE_DECL_LIST(OVERRIDE_VISIT)
 #undef OVERRIDE_VISIT
 
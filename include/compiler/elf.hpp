@@ -0,0 +1,90 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-13
+ */
+
+#pragma once
+
+#include "compiler/writer.hpp"
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace cstar {
+
+/**
+ * A relocatable ELF object for x86-64 with a text and a data section, as
+ * written by an assembler. Symbols are added on first reference and
+ * defined later, those left undefined are resolved by the linker.
+ */
+class ElfObject {
+public:
+    enum class Section : std::uint8_t { Undefined, Text, Data };
+
+    /** the relocations of x86-64 used by the backend */
+    typedef enum : std::uint32_t {
+        R_X86_64_64 = 1,
+        R_X86_64_PC32 = 2,
+        R_X86_64_PLT32 = 4
+    } Relocation;
+
+    /**
+     * @return the id of the symbol with the given name, which must
+     * outlive the object
+     */
+    std::uint32_t symbol(std::string_view name);
+
+    void define(std::uint32_t symbol,
+                Section section,
+                std::uint64_t value,
+                std::uint64_t size,
+                bool global,
+                bool function);
+
+    void relocate(Section section,
+                  std::uint64_t offset,
+                  std::uint32_t symbol,
+                  Relocation type,
+                  std::int64_t addend);
+
+    std::vector<std::uint8_t> &text() { return _text; }
+    std::vector<std::uint8_t> &data() { return _data; }
+
+    /**
+     * Writes the object file, with its symbol and relocation tables
+     */
+    void write(CodeWriter &out) const;
+
+private:
+    struct Symbol {
+        std::string_view name{};
+        Section section{Section::Undefined};
+        bool global{false};
+        bool function{false};
+        std::uint64_t value{0};
+        std::uint64_t size{0};
+    };
+
+    struct Rela {
+        std::uint64_t offset{0};
+        std::uint32_t symbol{0};
+        Relocation type{R_X86_64_64};
+        std::int64_t addend{0};
+    };
+
+    std::vector<std::uint8_t> _text{};
+    std::vector<std::uint8_t> _data{};
+    std::vector<Symbol> _symbols{};
+    std::unordered_map<std::string_view, std::uint32_t> _index{};
+    std::vector<Rela> _textRelocations{};
+    std::vector<Rela> _dataRelocations{};
+};
+
+} // namespace cstar
@@ -11,6 +11,7 @@
 #pragma once
 
 #include <ostream>
+#include <string>
 #include <string_view>
 
 #include <compiler/utils.hpp>
@@ -20,7 +21,16 @@ namespace cstar {
     std::pair<std::uint32_t, std::uint32_t> readRune(Log& L, const Range& range);
     void toUtf16(std::ostream& os, Log& L, const Range& range);
     void toUtf32(std::ostream& os, Log& L, const Range& range);
+    /**
+     * Encodes the given code point in `c`
+     * @return the number of bytes used, 0 if the code point is invalid
+     */
+    std::uint32_t encodeUtf8(char (&c)[4],
+                             Log* L,
+                             const Range& range,
+                             uint32_t chr);
     void writeUtf8(std::ostream& os, Log* L, const Range& range, uint32_t chr);
+    void writeUtf8(std::string& str, Log* L, const Range& range, uint32_t chr);
     inline void writeUtf8(std::ostream& os, uint32_t chr) {
         writeUtf8(os, nullptr, {}, chr);
     }
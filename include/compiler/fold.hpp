@@ -0,0 +1,150 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-14
+ */
+
+#pragma once
+
+#include "compiler/ast.hpp"
+#include "compiler/constant.hpp"
+#include "compiler/log.hpp"
+#include "compiler/strings.hpp"
+
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace cstar {
+
+/**
+ * Folds the constant expressions of a program into literals before it is
+ * lowered, evaluating them the way the generated code does. Immutable
+ * variables initialized with a constant are replaced by their value, and
+ * `if` and `while` statements whose condition is constant are replaced by
+ * the statements that can run.
+ *
+ * A folded literal has the type of the expression it replaces, literals
+ * written in the source keep the `auto` type.
+ */
+class Folding : public StaticVisitor<Folding> {
+public:
+    explicit Folding(Log &L);
+
+    /**
+     * @return false if the program assigns immutable variables
+     */
+    bool fold(Program &program);
+
+    using StaticVisitor<Folding>::visit;
+
+    bool visit(Program &node, Step step);
+    bool visit(Block &node, Step step);
+    bool visit(StatementList &node, Step step);
+    bool visit(ExpressionList &node, Step step);
+    bool visit(FunctionDecl &node, Step step);
+
+    bool visit(BoolExpr &node, Step step);
+    bool visit(CharExpr &node, Step step);
+    bool visit(IntegerExpr &node, Step step);
+    bool visit(FloatExpr &node, Step step);
+    bool visit(VariableExpr &node, Step step);
+    bool visit(GroupingExpr &node, Step step);
+    bool visit(UnaryExpr &node, Step step);
+    bool visit(PrefixExpr &node, Step step);
+    bool visit(PostfixExpr &node, Step step);
+    bool visit(BinaryExpr &node, Step step);
+    bool visit(AssignmentExpr &node, Step step);
+    bool visit(CallExpr &node, Step step);
+    bool visit(TernaryExpr &node, Step step);
+    bool visit(NullishCoalescingExpr &node, Step step);
+    bool visit(StringExpressionExpr &node, Step step);
+
+    bool visit(DeclarationStmt &node, Step step);
+    bool visit(ParameterStmt &node, Step step);
+    bool visit(ExpressionStmt &node, Step step);
+    bool visit(IfStmt &node, Step step);
+    bool visit(WhileStmt &node, Step step);
+    bool visit(ForStmt &node, Step step);
+
+private:
+    /**
+     * A variable in scope, shadowing the variables of the enclosing
+     * scopes with the same name
+     */
+    struct Binding {
+        Strings::Id name{0};
+        /** the value of an immutable variable initialized with a constant */
+        std::optional<Constant> value{};
+        bool immutable{false};
+        /** the binding hidden by this one, NONE if there is none */
+        std::uint32_t shadowed{NONE};
+    };
+
+    static constexpr std::uint32_t NONE = ~std::uint32_t(0);
+
+    /**
+     * The constant value of an expression that was just visited, or the
+     * statement replacing a statement that was just visited
+     */
+    struct Result {
+        Node *node{nullptr};
+        Constant value{};
+        Node *replacement{nullptr};
+    };
+
+    void bind(Strings::Id name,
+              std::optional<Constant> value = std::nullopt,
+              bool immutable = false);
+    const Binding *lookup(Strings::Id name) const;
+    void enter() { _scopes.push_back(std::uint32_t(_bindings.size())); }
+    void leave();
+
+    void checkAssignable(Expr &assignee);
+
+    void constant(Node &node, const Constant &value);
+    void replace(Node &node, Node *replacement);
+
+    /**
+     * @return the value of the given child if it is a constant expression
+     */
+    const Constant *peek(Node *child) const;
+    std::optional<Constant> take(Node *child);
+
+    /**
+     * @return the node replacing the given child, a literal if the child
+     * is a constant expression, or the child itself
+     */
+    Node *result(Node *child);
+    Node *result(Node *child, const std::optional<Constant> &value);
+
+    /**
+     * @return a literal with the given value, null if its type has no
+     * literal
+     */
+    Expr *literal(const Constant &value, const Range &range);
+
+    /**
+     * Visits the given nodes in order, replacing each with its result
+     */
+    bool children(std::span<Node::Ptr> nodes, Step step);
+
+    Log &L;
+    AstArena *_arena{nullptr};
+    /** the bindings in scope, in the order they were declared */
+    std::vector<Binding> _bindings{};
+    /** the index of the innermost binding of each name */
+    std::unordered_map<Strings::Id, std::uint32_t> _bound{};
+    /** the number of bindings when each enclosing scope was entered */
+    std::vector<std::uint32_t> _scopes{};
+    std::vector<Result> _results{};
+    /** parameter defaults are evaluated where functions are called */
+    bool _parameters{false};
+    bool _failed{false};
+};
+
+} // namespace cstar
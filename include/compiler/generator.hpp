@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-06
+ */
+
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <utility>
+
+namespace cstar {
+
+/**
+ * A lazily evaluated sequence of values produced by a coroutine. Values
+ * are pulled one at a time with `next()`, the coroutine only runs up to
+ * its next `co_yield`.
+ *
+ * A yielded value is referenced, not copied, so it is only valid until
+ * the next call to `next()`.
+ */
+template <typename T>
+class Generator {
+public:
+    struct promise_type {
+        Generator get_return_object()
+        {
+            return Generator{Handle::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+
+        std::suspend_always yield_value(const T &value) noexcept
+        {
+            _value = std::addressof(value);
+            return {};
+        }
+
+        void return_void() noexcept {}
+        void unhandled_exception() { _exception = std::current_exception(); }
+
+        const T *_value{nullptr};
+        std::exception_ptr _exception{};
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Generator() = default;
+    Generator(const Generator &) = delete;
+    Generator &operator=(const Generator &) = delete;
+    Generator(Generator &&other) noexcept
+        : _handle{std::exchange(other._handle, nullptr)}
+    {
+    }
+
+    Generator &operator=(Generator &&other) noexcept
+    {
+        if (this != &other) {
+            if (_handle)
+                _handle.destroy();
+            _handle = std::exchange(other._handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~Generator()
+    {
+        if (_handle)
+            _handle.destroy();
+    }
+
+    /**
+     * Resumes the coroutine until it yields the next value
+     *
+     * @return false if the sequence is exhausted
+     */
+    bool next()
+    {
+        if (!_handle or _handle.done())
+            return false;
+
+        _handle.resume();
+        if (auto ex = _handle.promise()._exception)
+            std::rethrow_exception(ex);
+        return !_handle.done();
+    }
+
+    const T &value() const { return *_handle.promise()._value; }
+
+private:
+    explicit Generator(Handle handle) : _handle{handle} {}
+
+    Handle _handle{nullptr};
+};
+
+} // namespace cstar
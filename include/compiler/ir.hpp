@@ -0,0 +1,288 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-12
+ */
+
+#pragma once
+
+#include "compiler/strings.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * The instructions of the intermediate representation, with the name of
+ * the matching QBE instruction. Comparisons are suffixed with the class of
+ * their operands in QBE, the other instructions with the class of their
+ * result.
+ */
+#define IR_OP_LIST(XX)                                                         \
+    XX(Add,     "add")                                                         \
+    XX(Sub,     "sub")                                                         \
+    XX(Mul,     "mul")                                                         \
+    XX(Div,     "div")                                                         \
+    XX(Udiv,    "udiv")                                                        \
+    XX(Rem,     "rem")                                                         \
+    XX(Urem,    "urem")                                                        \
+    XX(And,     "and")                                                         \
+    XX(Or,      "or")                                                          \
+    XX(Xor,     "xor")                                                         \
+    XX(Shl,     "shl")                                                         \
+    XX(Sar,     "sar")                                                         \
+    XX(Shr,     "shr")                                                         \
+    XX(Neg,     "neg")                                                         \
+    XX(Ceq,     "ceq")                                                         \
+    XX(Cne,     "cne")                                                         \
+    XX(Cslt,    "cslt")                                                        \
+    XX(Csle,    "csle")                                                        \
+    XX(Csgt,    "csgt")                                                        \
+    XX(Csge,    "csge")                                                        \
+    XX(Cult,    "cult")                                                        \
+    XX(Cule,    "cule")                                                        \
+    XX(Cugt,    "cugt")                                                        \
+    XX(Cuge,    "cuge")                                                        \
+    XX(Clt,     "clt")                                                         \
+    XX(Cle,     "cle")                                                         \
+    XX(Cgt,     "cgt")                                                         \
+    XX(Cge,     "cge")                                                         \
+    XX(Extsb,   "extsb")                                                       \
+    XX(Extub,   "extub")                                                       \
+    XX(Extsh,   "extsh")                                                       \
+    XX(Extuh,   "extuh")                                                       \
+    XX(Extsw,   "extsw")                                                       \
+    XX(Extuw,   "extuw")                                                       \
+    XX(Exts,    "exts")                                                        \
+    XX(Truncd,  "truncd")                                                      \
+    XX(Swtof,   "swtof")                                                       \
+    XX(Uwtof,   "uwtof")                                                       \
+    XX(Sltof,   "sltof")                                                       \
+    XX(Ultof,   "ultof")                                                       \
+    XX(Stosi,   "stosi")                                                       \
+    XX(Stoui,   "stoui")                                                       \
+    XX(Dtosi,   "dtosi")                                                       \
+    XX(Dtoui,   "dtoui")                                                       \
+    XX(Copy,    "copy")                                                        \
+    XX(Loadsb,  "loadsb")                                                      \
+    XX(Loadub,  "loadub")                                                      \
+    XX(Loadsh,  "loadsh")                                                      \
+    XX(Loaduh,  "loaduh")                                                      \
+    XX(Loadw,   "loadw")                                                       \
+    XX(Loadl,   "loadl")                                                       \
+    XX(Loads,   "loads")                                                       \
+    XX(Loadd,   "loadd")                                                       \
+    XX(Storeb,  "storeb")                                                      \
+    XX(Storeh,  "storeh")                                                      \
+    XX(Storew,  "storew")                                                      \
+    XX(Storel,  "storel")                                                      \
+    XX(Stores,  "stores")                                                      \
+    XX(Stored,  "stored")                                                      \
+    XX(Call,    "call")                                                        \
+    XX(Label,   "")                                                            \
+    XX(Jmp,     "jmp")                                                         \
+    XX(Jnz,     "jnz")                                                         \
+    XX(Ret,     "ret")
+
+namespace cstar::ir {
+
+/**
+ * The class of a value: a 32 or 64-bit integer, or a single or double
+ * precision floating point number. Addresses are 64-bit integers.
+ */
+enum class Cls : std::uint8_t { W, L, S, D };
+
+inline bool isFloat(Cls cls) { return cls == Cls::S or cls == Cls::D; }
+inline bool isWide(Cls cls) { return cls == Cls::L or cls == Cls::D; }
+
+enum class Op : std::uint8_t {
+#define XX(N, _) N,
+    IR_OP_LIST(XX)
+#undef XX
+};
+
+/**
+ * @return the name of the QBE instruction, without its class
+ */
+std::string_view toString(Op op);
+
+inline bool isComparison(Op op) { return op >= Op::Ceq and op <= Op::Cge; }
+inline bool isLoad(Op op) { return op >= Op::Loadsb and op <= Op::Loadd; }
+inline bool isStore(Op op) { return op >= Op::Storeb and op <= Op::Stored; }
+
+/**
+ * An operand: a temporary, a constant or the address of a symbol
+ */
+struct Ref {
+    typedef enum : std::uint8_t { NONE, TEMP, INTEGER, FLOAT, SYMBOL } Kind;
+
+    Kind kind{NONE};
+    Cls cls{Cls::W};
+    union {
+        /** the temporary, or the symbol in the module */
+        std::uint32_t id{0};
+        std::int64_t integer;
+        double real;
+    };
+
+    static Ref makeTemp(Cls cls, std::uint32_t id)
+    {
+        Ref ref;
+        ref.kind = TEMP;
+        ref.cls = cls;
+        ref.id = id;
+        return ref;
+    }
+
+    static Ref makeInteger(Cls cls, std::int64_t value)
+    {
+        Ref ref;
+        ref.kind = INTEGER;
+        ref.cls = cls;
+        ref.integer = value;
+        return ref;
+    }
+
+    static Ref makeFloat(Cls cls, double value)
+    {
+        Ref ref;
+        ref.kind = FLOAT;
+        ref.cls = cls;
+        ref.real = value;
+        return ref;
+    }
+
+    static Ref makeSymbol(std::uint32_t id)
+    {
+        Ref ref;
+        ref.kind = SYMBOL;
+        ref.cls = Cls::L;
+        ref.id = id;
+        return ref;
+    }
+
+    bool isTemp() const { return kind == TEMP; }
+    bool isConstant() const { return kind == INTEGER or kind == FLOAT; }
+};
+
+/**
+ * Instructions take at most two operands. Stores take the value and the
+ * address, loads the address and calls the callee.
+ */
+struct Instr {
+    Op op{Op::Label};
+    /** the class of the result, of the operands of comparisons */
+    Cls cls{Cls::W};
+    /** the temporary defined by the instruction, 0 if none */
+    std::uint32_t dst{0};
+    std::array<Ref, 2> args{};
+    /**
+     * The label of `Label`, the targets of jumps, the first argument of
+     * a call in `Function::callArgs` and the number of arguments
+     */
+    std::array<std::uint32_t, 2> aux{};
+};
+
+/**
+ * A stack slot, allocated on entry to the function
+ */
+struct Slot {
+    /** the temporary holding the address of the slot */
+    std::uint32_t temp{0};
+    std::uint32_t size{0};
+    std::uint32_t align{0};
+};
+
+/**
+ * The code of a function is a single list of instructions, blocks start
+ * with a `Label` and end with a jump or fall through to the next block.
+ * Temporaries can be assigned more than once, the code is not in SSA form.
+ */
+struct Function {
+    std::uint32_t symbol{0};
+    bool exported{true};
+    bool returns{false};
+    Cls ret{Cls::W};
+    /** the classes of the parameters, which are temporaries 1 to n */
+    std::vector<Cls> params{};
+    std::vector<Slot> slots{};
+    std::vector<Instr> code{};
+    std::vector<Ref> callArgs{};
+    /** the class of each temporary, temporary 0 does not exist */
+    std::vector<Cls> temps{Cls::W};
+    std::uint32_t labels{0};
+
+    Ref newTemp(Cls cls)
+    {
+        temps.push_back(cls);
+        return Ref::makeTemp(cls, std::uint32_t(temps.size() - 1));
+    }
+
+    std::uint32_t newLabel() { return labels++; }
+
+    void clear();
+};
+
+/**
+ * An item of a data definition: a value of the given type, one of
+ * b, h, w, l, s or d, a string of bytes or `z` bytes of zeroes
+ */
+struct DataItem {
+    char type{'b'};
+    /** the value, or the number of zeroes */
+    Ref value{};
+    std::string_view bytes{};
+};
+
+struct Data {
+    std::uint32_t symbol{0};
+    bool exported{false};
+    std::vector<DataItem> items{};
+};
+
+struct Symbol {
+    std::string_view name{};
+    bool isFunction{false};
+};
+
+/**
+ * The symbols referenced by the functions and data of a program
+ */
+class Module {
+public:
+    /**
+     * @return the id of the symbol with the given interned name, added on
+     * first use
+     */
+    std::uint32_t symbol(Strings::Id name, bool isFunction = false);
+
+    const Symbol &operator[](std::uint32_t id) const { return _symbols[id]; }
+    std::size_t size() const { return _symbols.size(); }
+
+private:
+    std::vector<Symbol> _symbols{};
+    std::unordered_map<Strings::Id, std::uint32_t> _index{};
+};
+
+/**
+ * Receives the program once it is lowered, one definition at a time. The
+ * function and data are only valid during the call.
+ */
+class Backend {
+public:
+    virtual ~Backend() = default;
+    virtual void data(const Module &m, const Data &data) = 0;
+    virtual void function(const Module &m, const Function &func) = 0;
+    /**
+     * Called once everything has been lowered, unless lowering failed
+     */
+    virtual void finish(const Module &) {}
+};
+
+} // namespace cstar::ir
@@ -10,41 +10,75 @@
 
 #pragma once
 
+#include "compiler/arena.hpp"
+#include "compiler/generator.hpp"
 #include "compiler/log.hpp"
+#include "compiler/source.hpp"
 #include "compiler/token.hpp"
 #include "compiler/utils.hpp"
 
-#include <functional>
-#include <list>
+#include <memory>
 #include <optional>
+#include <string>
+#include <vector>
 
 namespace cstar {
 
 class Lexer {
+    class Speculation : public std::exception {
+    public:
+        using std::exception::exception;
+    };
+
 public:
     Lexer(Log &log, Source &src, GenericFlags flags = {gflNone})
         : L{log}, _src{src}, _flags{flags}
     {
     }
 
-    std::list<Token> &tokens() { return _tokens; }
-    Token::Tange tange() { return {_tokens.begin(), _tokens.end()}; }
+    std::vector<Token> &tokens() { return _tokens; }
+    Token::Tange tange() const { return _tokens; }
+    Source &source() const { return _src; }
+    Range range(const Token &tok) const;
     bool tokenize();
 
+    /**
+     * Tokenizes large sources on up to `jobs` threads. The source is split
+     * into chunks at line boundaries which are lexed in parallel, chunks
+     * whose starting state was mispredicted (e.g they start inside a
+     * multiline comment) are lexed again. The result is identical to
+     * `tokenize()`.
+     */
+    bool tokenizeParallel(std::size_t jobs);
+
+    /**
+     * Lexes the source on demand, one token at a time, instead of storing
+     * every token. The stream ends with an `EoF` token unless lexing fails.
+     * If the source was already tokenized the stored tokens are replayed.
+     */
+    Generator<Token> stream();
+
 private:
     bool tokenize(char c);
-    void eatWhile(char c);
-    void eatWhileFunc(std::function<bool(char)> func);
-    void eatUntil(char c);
-    void eatUntilFunc(std::function<bool(char)> func);
+    bool lex(uint32_t limit);
+    [[noreturn]] void fatal();
     void eatWhitespace();
-    char peek(uint32_t n = 0);
+    void eatDigits();
+    /**
+     * Looks ahead without bounds checks, reading past the end of the
+     * source yields the source's `EOF` sentinel padding
+     */
+    char peek(uint32_t n = 0) const
+    {
+        csAssert(n < Source::PADDING);
+        return _src.data()[_idx + n];
+    }
     uint32_t advance(uint32_t n = 1);
     void tokCharacter();
     void tokNumber();
     void tokHexNumber();
     void tokBinaryNumber();
-    void tokFloatingPoint(const Position &start);
+    void tokFloatingPoint(uint32_t start);
     void tokDecimalNumber();
     void tokOctalNumber();
     void tokString();
@@ -54,16 +88,34 @@ private:
     uint32_t tokHexChar();
     uint32_t tokOctalChar(char c);
     uint32_t tokUniversalChar(uint32_t len);
-    void parseInteger(const Position &start, int base);
+    void parseInteger(uint32_t start, int base);
 
     Token mkToken(Token::Kind kind, uint32_t start, uint32_t end);
-    Token &addToken(Token::Kind kind, Position pos, uint32_t end);
+    Token &addToken(Token::Kind kind, uint32_t pos, uint32_t end);
+
+    inline uint32_t mark() const { return _idx; }
 
-    inline Position mark() { return {_idx, _pos}; }
+    /**
+     * Rough source bytes per token, used to reserve the token buffer
+     * up front so that large sources do not pay for repeated growth
+     */
+    static constexpr std::size_t BYTES_PER_TOKEN_ESTIMATE = 4;
+    /**
+     * Smallest chunk worth lexing on its own thread
+     */
+    static constexpr std::size_t MIN_CHUNK_SIZE = 1024 * 1024;
 
-    std::list<Token> _tokens{};
+    std::vector<Token> _tokens{};
+    /**
+     * Owns the values of string literal tokens, escape free literals
+     * reference the source while the others are decoded into the arena.
+     * Both must outlive any token or node referring to a string literal
+     */
+    Arena _literals{};
+    std::string _scratch{};
     bool _inStrExpr{false};
-    LineColumn _pos{};
+    bool _tokenized{false};
+    bool _speculative{false};
     uint32_t _idx{};
     Source &_src;
     Log &L;
@@ -11,49 +11,261 @@
 #pragma once
 
 #include <compiler/utils.hpp>
+#include <compiler/strings.hpp>
 #include <compiler/token.hpp>
 
+#include <array>
+#include <concepts>
 #include <cstdlib>
 #include <iostream>
+#include <limits>
 #include <list>
 #include <string>
 #include <vector>
 
+/**
+ * The messages of all diagnostics, `{}` is replaced with the diagnostic's
+ * arguments in order
+ */
+#define DIAGNOSTIC_LIST(XX)                                                    \
+    XX(TooManyErrors,               "too many errors emitted, stopping now")   \
+    XX(CannotOpenFile,              "could not open file '{}'")                \
+    XX(CannotReadFile,              "could not read file '{}'")                \
+                                                                               \
+    XX(TokenTooLong,                                                           \
+       "token too long, tokens are limited to {} bytes")                       \
+    XX(UnknownToken,                "unknown token")                           \
+    XX(UnknownEscape,               "unknown escape character: \\{}")          \
+    XX(HexEscapeWithoutDigits,                                                 \
+       "\\x is not followed by a hexadecimal literal")                         \
+    XX(InvalidUcnDigit,             "invalid character character: {}")         \
+    XX(InvalidUcn,                  "invalid character character")             \
+    XX(UnterminatedChar,            "unterminated character sequence")         \
+    XX(UnterminatedString,          "unterminated string literal")             \
+    XX(UnterminatedComment,         "unterminated multiline comment")          \
+    XX(InvalidBinaryDigit,          "invalid digit in a binary number '{}'")   \
+    XX(InvalidOctalDigit,           "'{}' is not a valid octal digit")         \
+    XX(IntegerTooBig,               "number too big parse")                    \
+    XX(FloatTooBig,                 "number too big parse: {}")                \
+    XX(ExponentWithoutDigits,       "'{}' exponent has no digits")             \
+    XX(InvalidUtf8Sequence,         "invalid UTF-8 character sequence")        \
+    XX(InvalidUtf8Continuation,     "invalid UTF-8 continuation byte")         \
+    XX(InvalidUtf8,                 "invalid UTF-8 sequence")                  \
+    XX(InvalidUcs,                  "invalid UCS character: \\U{}")            \
+                                                                               \
+    XX(ExpectedFunc,                                                           \
+       "expecting a 'func' keyword to start a function")                       \
+    XX(ExpectedFunctionName,        "expecting the name of the function")      \
+    XX(FunctionRedefined,                                                      \
+       "function '{}' already defined in current scope")                       \
+    XX(ExpectedLParen,              "expecting an opening paren '('")          \
+    XX(ExpectedRParen,              "expecting an closing paren ')'")          \
+    XX(ExpectedLBrace,              "expecting an opening brace '{'")          \
+    XX(ExpectedRBrace,              "expecting a closing brace '}'")           \
+    XX(ExpectedStatementSemicolon,                                             \
+       "expecting a semicolon ';' after a statement")                          \
+    XX(ExpectedIf,                  "expecting an 'if' statement")             \
+    XX(ExpectedIfLParen,                                                       \
+       "expecting an opening paren '(' after an 'if' keyword")                 \
+    XX(ExpectedIfRParen,                                                       \
+       "expect a closing paren ')' after an if condition")                     \
+    XX(ExpectedWhile,                                                          \
+       "expecting a 'while' keyword to start a while statement")               \
+    XX(ExpectedWhileLParen,                                                    \
+       "expecting an opening paren '(' after 'while' keyword")                 \
+    XX(ExpectedWhileRParen,                                                    \
+       "expecting an closing paren ')' after a 'while' statement condition")   \
+    XX(ExpectedFor,                                                            \
+       "expecting a 'for' keyword to start a 'for' statement")                 \
+    XX(ExpectedForLParen,                                                      \
+       "expecting an open paren ';' to start for loop clauses")                \
+    XX(ExpectedForSemicolon,                                                   \
+       "expecting a semicolon ';' after loop condition.")                      \
+    XX(ExpectedForRParen,                                                      \
+       "expecting a closing paren ')' to close for loop clauses.")             \
+    XX(ExpectedVariableName,        "expecting the name of the variable")      \
+    XX(VariableRedefined,                                                      \
+       "variable '{}' already defined in current scope")                       \
+    XX(UntypedUninitialized,                                                   \
+       "an explicit type must be assigned to an uninitialized variable")       \
+    XX(ExpectedDeclarationSemicolon,                                           \
+       "expecting a semicolon ';' after a variable declaration expression")    \
+    XX(VariadicNotLast,                                                        \
+       "parameter '{}' cannot be a variadic parameter, it is followed by "     \
+       "another parameter")                                                    \
+    XX(ExpectedParameterName,       "expecting the name of the parameter")     \
+    XX(VariadicAfterDefault,                                                   \
+       "variadiac parameter '{}' not allowed after parameters with default "   \
+       "arguments")                                                            \
+    XX(ParameterRedefined,                                                     \
+       "parameter '{}' already defined in the parameter list")                 \
+    XX(ExpectedParameterColon,                                                 \
+       "expecting a colon ':' after a parameter name and before the "          \
+       "parameter type")                                                       \
+    XX(VariadicWithDefault,                                                    \
+       "default parameter arguments cannot be assigned to variadiac "          \
+       "parameters")                                                           \
+    XX(MissingDefault,                                                         \
+       "default argument missing for parameter '{}'")                          \
+    XX(ExpectedTypeName,            "expecting a type name")                   \
+    XX(UnknownType,                                                            \
+       "unknown type name (TODO support custom types)")                        \
+    XX(ExpectedTernaryColon,                                                   \
+       "expecting a colon ':' to seperate a ternary expression.")              \
+    XX(ExpectedGroupingRParen,                                                 \
+       "expecting a closing ')' after expression.")                            \
+    XX(ExpectedArgumentsRParen,                                                \
+       "expecting a closing paren '(' to end function arguments")              \
+    XX(UndefinedVariable,           "accessing an undefined variable '{}'")    \
+    XX(ExpectedExpression,                                                     \
+       "unexpected token, expecting an expression")                            \
+    XX(ExpectedIdentifier,          "expecting an identifier")                 \
+                                                                               \
+    XX(UnsupportedConstruct,        "code generation does not support {}")     \
+    XX(UnsupportedType,                                                        \
+       "code generation does not support values of type '{}'")                 \
+    XX(NonConstantGlobal,                                                      \
+       "global variable '{}' must be initialized with a constant")             \
+    XX(VoidValue,                   "expression does not have a value")        \
+    XX(InvalidConversion,                                                      \
+       "cannot convert a value of type '{}' to '{}'")                          \
+    XX(InvalidOperation,                                                       \
+       "operator '{}' cannot be applied to values of type '{}'")               \
+    XX(ArgumentCount,                                                          \
+       "wrong number of arguments in call to function '{}'")                   \
+    XX(AssignToImmutable,                                                      \
+       "cannot assign to immutable variable '{}'")                             \
+    XX(DivisionByZero,              "division by zero")
 
 namespace cstar {
 
+    enum class Diag : std::uint16_t {
+#define XX(N, _) N,
+        DIAGNOSTIC_LIST(XX)
+#undef XX
+    };
+
+    /**
+     * An argument of a diagnostic. Strings are interned so that arguments
+     * are small and do not depend on the lifetime of what they refer to
+     */
+    struct DiagnosticArg {
+        typedef enum : std::uint8_t {
+            INTEGER,
+            UNSIGNED,
+            CHAR,
+            STRING
+        } Kind;
+
+        DiagnosticArg() = default;
+
+        template <std::integral T>
+        DiagnosticArg(T value)
+        {
+            if constexpr (std::is_same_v<T, char>) {
+                kind = CHAR;
+                chr = value;
+            }
+            else if constexpr (std::is_signed_v<T>) {
+                kind = INTEGER;
+                integer = value;
+            }
+            else {
+                kind = UNSIGNED;
+                uinteger = value;
+            }
+        }
+
+        DiagnosticArg(std::string_view str)
+            : kind{STRING}, str{Strings::id(str)}
+        {}
+
+        Kind kind{INTEGER};
+        union {
+            std::int64_t integer{0};
+            std::uint64_t uinteger;
+            char chr;
+            Strings::Id str;
+        };
+    };
+
+    /**
+     * A reported diagnostic, its message is only formatted when it is
+     * printed
+     */
     struct Diagnostic {
-        typedef enum {
+        static constexpr std::size_t MAX_ARGS = 2;
+
+        typedef enum : std::uint8_t {
             ERROR,
             WARNING
         } Kind;
 
         Kind kind{WARNING};
+        std::uint8_t argc{0};
+        Diag id{};
         Range range{};
-        std::string message{};
+        std::array<DiagnosticArg, MAX_ARGS> args{};
+
+        std::string message() const;
     };
 
+    /**
+     * Collects the diagnostics of a compilation. When an error limit is
+     * set, once `errorLimit()` errors have been reported further
+     * diagnostics are dropped and the compiler passes stop early. Errors
+     * reported at the location of the previous error are dropped as they
+     * are most likely caused by it.
+     */
     class Log {
     public:
-        void error(Range range, std::string msg) {
-            append(Diagnostic::ERROR, range, std::move(msg));
+        /**
+         * @param errorLimit the number of errors after which compilation
+         * stops, 0 for no limit
+         */
+        explicit Log(std::uint32_t errorLimit = 0)
+        {
+            this->errorLimit(errorLimit);
         }
 
         template<class... Args>
-        void error(Range range, Args... args) {
-            error(range, format(std::forward<Args>(args)...));
+        void error(Range range, Diag id, Args&&... args) {
+            add(make(Diagnostic::ERROR,
+                     range,
+                     id,
+                     std::forward<Args>(args)...));
         }
 
-        void warning(Range range, std::string msg) {
-            append(Diagnostic::WARNING, range, std::move(msg));
+        template<class... Args>
+        void warning(Range range, Diag id, Args&&... args) {
+            add(make(Diagnostic::WARNING,
+                     range,
+                     id,
+                     std::forward<Args>(args)...));
         }
 
-        template<class... Args>
-        void warning(Range range, Args... args) {
-            error(range, format(std::forward<Args>(args)...));
+        /**
+         * Moves the diagnostics of the given log to the end of this one
+         */
+        void append(Log&& other);
+
+        bool hasErrors() const { return _errors != 0; }
+
+        std::uint32_t errors() const { return _errors; }
+
+        std::uint32_t errorLimit() const {
+            return _errorLimit == NO_LIMIT ? 0 : _errorLimit;
         }
 
-        bool hasErrors() const;
+        void errorLimit(std::uint32_t limit) {
+            _errorLimit = limit == 0 ? NO_LIMIT : limit;
+        }
+
+        /**
+         * @return true once the error limit has been reached, compiler passes
+         * should stop as soon as possible
+         */
+        bool limitReached() const { return _errors >= _errorLimit; }
 
         std::string toString() const;
 
@@ -62,18 +274,30 @@ namespace cstar {
         const std::vector<Diagnostic>& diagnostics() const { return _diagnostics; }
 
     private:
+        static constexpr std::uint32_t NO_LIMIT =
+            std::numeric_limits<std::uint32_t>::max();
+
         template<typename... Args>
-        std::string format(Args... args) const
+        static Diagnostic make(Diagnostic::Kind kind,
+                               Range range,
+                               Diag id,
+                               Args&&... args)
         {
-            // efficient stream
-            std::stringstream ss;
-            (ss << ... << args);
-            return ss.str();
+            static_assert(sizeof...(Args) <= Diagnostic::MAX_ARGS,
+                          "too many diagnostic arguments");
+            return {kind,
+                    std::uint8_t(sizeof...(Args)),
+                    id,
+                    range,
+                    {DiagnosticArg(std::forward<Args>(args))...}};
         }
 
-        void append(Diagnostic::Kind kind, Range range, std::string msg);
+        void add(const Diagnostic& diagnostic);
 
         std::vector<Diagnostic> _diagnostics{};
+        std::uint32_t _errors{0};
+        std::uint32_t _errorLimit{NO_LIMIT};
+        SourceLocation _lastError{0};
     };
 
     [[noreturn]]
@@ -0,0 +1,202 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-12
+ */
+
+#pragma once
+
+#include "compiler/ast.hpp"
+#include "compiler/ir.hpp"
+#include "compiler/log.hpp"
+#include "compiler/strings.hpp"
+
+#include <unordered_map>
+
+namespace cstar {
+
+/**
+ * Lowers a program to the intermediate representation of `ir.hpp`, which
+ * is handed to a backend one function or data definition at a time.
+ *
+ * Variables live in stack slots which are loaded and stored around each
+ * use. Expressions leave their value on a stack that the enclosing node
+ * pops. Constructs without a lowering are reported to the log, the
+ * backend is then not asked to finish.
+ */
+class Lowering : public StaticVisitor<Lowering> {
+public:
+    Lowering(Log &L, ir::Backend &backend);
+
+    /**
+     * @return false if some of the program could not be lowered
+     */
+    bool lower(Program &p);
+
+    using StaticVisitor<Lowering>::visit;
+
+    bool visit(Program &node, Step step);
+    bool visit(Block &node, Step step);
+    bool visit(ExpressionList &node, Step step);
+    bool visit(FunctionDecl &node, Step step);
+
+    bool visit(BoolExpr &node, Step step);
+    bool visit(CharExpr &node, Step step);
+    bool visit(IntegerExpr &node, Step step);
+    bool visit(FloatExpr &node, Step step);
+    bool visit(StringExpr &node, Step step);
+    bool visit(VariableExpr &node, Step step);
+    bool visit(GroupingExpr &node, Step step);
+    bool visit(UnaryExpr &node, Step step);
+    bool visit(PrefixExpr &node, Step step);
+    bool visit(PostfixExpr &node, Step step);
+    bool visit(BinaryExpr &node, Step step);
+    bool visit(AssignmentExpr &node, Step step);
+    bool visit(CallExpr &node, Step step);
+    bool visit(TernaryExpr &node, Step step);
+    bool visit(NullishCoalescingExpr &node, Step step);
+    bool visit(StringExpressionExpr &node, Step step);
+
+    bool visit(DeclarationStmt &node, Step step);
+    bool visit(ExpressionStmt &node, Step step);
+    bool visit(IfStmt &node, Step step);
+    bool visit(WhileStmt &node, Step step);
+    bool visit(ForStmt &node, Step step);
+
+    /**
+     * @return the class of the values of the given type, `L` if they are
+     * not `supported`
+     */
+    static ir::Cls cls(Type::Ptr type);
+
+    /**
+     * @return true if values of the given type can be lowered
+     */
+    static bool supported(Type::Ptr type);
+
+private:
+    /**
+     * A typed operand, void values have no operand
+     */
+    struct Value {
+        Type::Ptr type{nullptr};
+        ir::Ref ref{};
+        /** whether a constant was folded from a value of its type */
+        bool typed{false};
+
+        ir::Ref::Kind kind() const { return ref.kind; }
+    };
+
+    /**
+     * A variable is a stack slot, or a data definition for globals
+     */
+    struct Variable {
+        Strings::Id name{0};
+        Type::Ptr type{nullptr};
+        /** the temporary holding the address of a local, 0 for globals */
+        std::uint32_t slot{0};
+        /** the symbol of a global */
+        std::uint32_t symbol{0};
+        /** the variable hidden by this one, NONE if there is none */
+        std::uint32_t shadowed{NONE};
+
+        ir::Ref address() const;
+    };
+
+    static constexpr std::uint32_t NONE = ~std::uint32_t(0);
+
+    void global(DeclarationStmt &node);
+    void declare(Strings::Id name, Type::Ptr type, const Value &init);
+    /**
+     * Makes the given variable the innermost one of its name until the
+     * enclosing scope is left
+     */
+    void bind(Variable var);
+    const Variable *lookup(Strings::Id name) const;
+    void enter() { _scopes.push_back(std::uint32_t(_variables.size())); }
+    void leave();
+
+    Value load(const Variable &var);
+    void store(const Variable &var, const Value &value);
+    Value increment(Expr &operand, Token::Kind op, bool prefix);
+
+    Value pop();
+    void push(Value value) { _values.push_back(value); }
+    Value temp(Type::Ptr type);
+    Value constant(Type::Ptr type, std::int64_t value);
+    Value literal(Expr &node, Type::Ptr type, std::int64_t value);
+
+    Type::Ptr common(const Value &lhs, const Value &rhs);
+    Value convert(const Value &value, Type::Ptr type, const Range &range);
+    Value condition(const Value &value, const Range &range);
+    Value arithmetic(Token::Kind op,
+                     const Value &lhs,
+                     const Value &rhs,
+                     const Range &range);
+    Value power(const Value &lhs, const Value &rhs);
+
+    std::uint32_t label() { return _fn.newLabel(); }
+    void startBlock(std::uint32_t id);
+    void jump(std::uint32_t id);
+    void branch(const Value &cond,
+                std::uint32_t then,
+                std::uint32_t otherwise);
+
+    void unsupported(const Node &node, std::string_view what);
+
+    /**
+     * Adds an instruction whose result is a new temporary of the given
+     * type
+     */
+    Value emit(Type::Ptr type,
+               ir::Op op,
+               const ir::Ref &a,
+               const ir::Ref &b = {});
+
+    /**
+     * Adds a comparison of two values of the given type
+     */
+    Value compare(ir::Op op,
+                  Type::Ptr type,
+                  const ir::Ref &a,
+                  const ir::Ref &b);
+
+    /**
+     * Adds an instruction assigning an existing temporary
+     */
+    void assign(const Value &dst,
+                ir::Op op,
+                const ir::Ref &a,
+                const ir::Ref &b = {});
+
+    ir::Instr &add(ir::Op op, ir::Cls cls = ir::Cls::W);
+
+    Log &L;
+    ir::Backend &_backend;
+    ir::Module _module{};
+    /** the function being lowered */
+    ir::Function _fn{};
+
+    std::unordered_map<Strings::Id, FunctionDecl *> _functions{};
+    /** the variables in scope, in the order they were declared */
+    std::vector<Variable> _variables{};
+    /** the index of the innermost variable of each name */
+    std::unordered_map<Strings::Id, std::uint32_t> _bound{};
+    /** the number of variables when each enclosing scope was entered */
+    std::vector<std::uint32_t> _scopes{};
+    std::vector<Value> _values{};
+    /** the labels of the statements and expressions being lowered */
+    std::vector<std::uint32_t> _labels{};
+    /** the results of the logical operators being lowered */
+    std::vector<Value> _results{};
+
+    FunctionDecl *_function{nullptr};
+    std::uint32_t _nextString{0};
+    bool _failed{false};
+};
+
+} // namespace cstar
@@ -10,71 +10,254 @@
 
 #pragma once
 
+#include <compiler/arena.hpp>
+#include <compiler/log.hpp>
 #include <compiler/token.hpp>
 #include <compiler/vistor.hpp>
 
+#include <algorithm>
 #include <ranges>
+#include <span>
+#include <type_traits>
 
 namespace cstar {
 
+/**
+ * Nodes are owned by the `AstArena` they were created in, node pointers
+ * are plain non-owning pointers
+ */
+#define CSTAR_NODE_PTR(T) using Ptr = T *
+
+/**
+ * The kind of every node class, generated from the node lists. Kinds of
+ * the same list are contiguous so that checking for a family of nodes is
+ * a range compare
+ */
+enum class NodeKind : std::uint8_t {
+#define XX(N) N,
+    NODE_LIST(XX)
+#undef XX
+    Program,
+    Type,
+#define XX(N) N##Type,
+    NODE_TYPE_LIST(XX)
+#undef XX
+#define XX(N) N##Decl,
+    NODE_DECL_LIST(XX)
+#undef XX
+#define XX(N) N##Stmt,
+    NODE_STMT_LIST(XX)
+#undef XX
+#define XX(N) N##Expr,
+    NODE_EXPR_LIST(XX)
+#undef XX
+};
+
+/**
+ * Declares the kind of a node class that has no subclasses
+ */
+#define CSTAR_NODE_KIND(K)                                                     \
+    static constexpr NodeKind Kind = NodeKind::K;                              \
+    static bool classof(NodeKind kind) { return kind == Kind; }
+
 struct Node {
-    CSTAR_PTR(Node);
+    CSTAR_NODE_PTR(Node);
 
-    Node(Range range = {}) : _range{std::move(range)} {}
+    Node(NodeKind kind, Range range = {})
+        : _range{std::move(range)}, _kind{kind}
+    {
+    }
 
     void range(Range range) { _range = std::move(range); }
 
     const Range &range() const { return _range; }
     Range &range() { return _range; }
 
-    virtual void accept(Visitor &visitor) { visitor.visit(*this); }
+    NodeKind kind() const { return _kind; }
+
+    static bool classof(NodeKind) { return true; }
 
     GenericFlags flags{gflNone};
 
 private:
     Range _range{};
+    NodeKind _kind{NodeKind::Node};
 };
 
+/**
+ * @return true if the given node is a `T`, false if it is not or is null
+ */
+template <typename T>
+bool isa(const Node *node)
+{
+    return node != nullptr and T::classof(node->kind());
+}
+
+/**
+ * Casts the given node to a `T`, the node must either be null or a `T`
+ */
+template <typename T>
+T *cast(Node *node)
+{
+    csAssert(node == nullptr or T::classof(node->kind()), "invalid node cast");
+    return static_cast<T *>(node);
+}
+
+template <typename T>
+const T *cast(const Node *node)
+{
+    csAssert(node == nullptr or T::classof(node->kind()), "invalid node cast");
+    return static_cast<const T *>(node);
+}
+
+/**
+ * Casts the given node to a `T` if it is one
+ *
+ * @return the node as a `T`, or null if it is not a `T` or is null
+ */
+template <typename T>
+T *dyn_cast(Node *node)
+{
+    return isa<T>(node) ? static_cast<T *>(node) : nullptr;
+}
+
+template <typename T>
+const T *dyn_cast(const Node *node)
+{
+    return isa<T>(node) ? static_cast<const T *>(node) : nullptr;
+}
+
+class AstArena;
+
+/**
+ * A node with child nodes. Nodes with a known number of children keep
+ * them in inline slots (see `NodeSlots`), nodes with a variable number of
+ * children start with their inline slots and grow into arrays allocated
+ * from the `AstArena` owning the node.
+ */
 class ContainerNode : public Node {
 public:
-    CSTAR_PTR(ContainerNode);
-    using Node::Node;
-    using iterator = std::vector<Node::Ptr>::iterator;
-    using const_iterator = std::vector<Node::Ptr>::const_iterator;
+    CSTAR_NODE_PTR(ContainerNode);
+    using iterator = Node::Ptr *;
+    using const_iterator = const Node::Ptr *;
+
+    ContainerNode(NodeKind kind, Range range = {})
+        : Node(kind, std::move(range))
+    {
+    }
+    ContainerNode(const ContainerNode &) = delete;
+    ContainerNode &operator=(const ContainerNode &) = delete;
 
 #define CYN_CONTAINER_NODE_MEMBER(T, idx, name)                                \
     typename T::Ptr name() const                                               \
     {                                                                          \
-        return std::dynamic_pointer_cast<T>(get(idx));                         \
+        return cast<T>(get(idx));                                              \
     }                                                                          \
-    typename T::Ptr name() { return std::dynamic_pointer_cast<T>(get(idx)); }  \
+    typename T::Ptr name() { return cast<T>(get(idx)); }                       \
     void name(Node::Ptr node) { set(idx, std::move(node)); }
 
 #define CYN_CONTAINER_NODE_VIEW(idx, name)                                     \
     auto name() { return std::ranges::drop_view{all(), idx}; }                 \
     auto name() const { return std::ranges::drop_view{all(), idx}; }
 
-    void insert(Node::Ptr node) { set(int(_children.size()), std::move(node)); }
+    /**
+     * Appends the given node to the children of this node, growing them
+     * into the given arena when the current slots are all used
+     */
+    void insert(AstArena &arena, Node::Ptr node);
 
-    template <typename T, typename... Args>
-    requires std::is_base_of_v<Node, T>
-    void create(Args &&...args)
+    std::span<Node::Ptr> all() { return {_children, _size}; }
+    std::span<const Node::Ptr> all() const { return {_children, _size}; }
+
+    static bool classof(NodeKind kind) { return kind != NodeKind::Node; }
+
+protected:
+    ContainerNode(NodeKind kind, std::span<Node::Ptr> slots, Range range = {})
+        : Node(kind, std::move(range)), _children{slots.data()},
+          _capacity{std::uint32_t(slots.size())}
+    {
+    }
+
+    Node::Ptr get(int i)
+    {
+        csAssert(i < int(_size), "index out of bounds");
+        return _children[i];
+    }
+
+    Node::Ptr get(int i) const
     {
-        insert(std::make_shared<T>(std::forward<Args>(args)...));
+        csAssert(i < int(_size), "index out of bounds");
+        return _children[i];
     }
 
-    vec<Node::Ptr> &all() { return _children; }
-    const vec<Node::Ptr> &all() const { return _children; }
+    void set(int i, Node::Ptr node)
+    {
+        csAssert(i < int(_capacity), "node has no slot at index");
+        _children[i] = node;
+        _size = std::max(_size, std::uint32_t(i + 1));
+    }
 
-    VisitableNode();
+private:
+    Node::Ptr *_children{nullptr};
+    std::uint32_t _size{0};
+    std::uint32_t _capacity{0};
+};
 
+/**
+ * Inline storage for the children of a node, it is inherited before the
+ * node class so that the slots exist by the time the node is constructed
+ *
+ * @code
+ * struct BinaryExpr : private NodeSlots<3>, public Expr {
+ *     BinaryExpr() : Expr(Kind, slots()) {}
+ * };
+ * @endcode
+ */
+template <std::size_t N>
+class NodeSlots {
 protected:
-    Node::Ptr get(int i);
-    Node::Ptr get(int i) const;
-    void set(int i, Node::Ptr);
-    void push(Node::Ptr node) { _children.push_back(std::move(node)); }
+    std::span<Node::Ptr> slots() { return _slots; }
+
+private:
+    Node::Ptr _slots[N]{};
+};
+
+/**
+ * Owns all the nodes of a compilation. Nodes are bump allocated in the
+ * order they are created, which follows the parse, and are all released
+ * at once when the arena is destroyed.
+ */
+class AstArena {
+public:
+    AstArena() = default;
+    AstArena(const AstArena &) = delete;
+    AstArena &operator=(const AstArena &) = delete;
+
+    /**
+     * Constructs a node in the arena, since nodes are never destroyed
+     * `T` must be trivially destructible
+     */
+    template <typename T, typename... Args>
+    requires std::is_base_of_v<Node, T> T *make(Args &&...args)
+    {
+        return _arena.make<T>(std::forward<Args>(args)...);
+    }
+
+    /**
+     * Allocates an uninitialized array of `count` node pointers
+     */
+    Node::Ptr *array(std::size_t count)
+    {
+        return static_cast<Node::Ptr *>(
+            _arena.allocate(count * sizeof(Node::Ptr), alignof(Node::Ptr)));
+    }
+
+    /**
+     * @return the number of bytes allocated for nodes
+     */
+    std::size_t allocated() const { return _arena.allocated(); }
 
 private:
-    std::vector<Node::Ptr> _children{};
+    Arena _arena{};
 };
 } // namespace cstar
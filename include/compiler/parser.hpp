@@ -14,68 +14,84 @@
 #include "compiler/lexer.hpp"
 #include "compiler/symbol.hpp"
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
 namespace cstar {
 
 class Parser : protected SymbolTableScope {
-    class Synchronize : public std::exception {
-    public:
-        using std::exception::exception;
-    };
-
 public:
-    Parser(Log &L, Token::Tange tokens, SymbolTable::Ptr symbols);
+    Parser(Log &L, Lexer &lexer, SymbolTable::Ptr symbols);
 
     bool parse(Program &program);
 
 private:
     Log &L;
 
-    FunctionDecl::Ptr function();
-    Block::Ptr block();
     LiteralExpr::Ptr literal();
     VariableExpr::Ptr variable();
-    Expr::Ptr prefix();
-    Expr::Ptr nots();
-    Expr::Ptr unary();
-    Expr::Ptr factor();
-    Expr::Ptr equality();
-    Expr::Ptr terminal();
-    Expr::Ptr comparison();
     Expr::Ptr primary();
+    /**
+     * Parses an expression with an explicit operator stack rather than
+     * recursion, nested expressions only cost heap memory. The precedence
+     * of infix operators comes from the token table
+     */
     Expr::Ptr expression();
-    Expr::Ptr assignment();
     /**
-     * cond? ifTrue : ifFalse
+     * Shifts the prefix operators, opening parens and string expressions
+     * up to the next primary expression
      */
-    Expr::Ptr ternary();
+    Expr::Ptr prefix();
     /**
-     * lhs?? rhs
+     * Applies the infix or postfix operator at the current token to `lhs`
+     * @return true when the operator was shifted and expects its right
+     * operand, otherwise `lhs` is replaced with the completed expression
+     */
+    bool infix(Expr::Ptr &lhs, Precedence prec);
+    Expr::Ptr call(Expr::Ptr callee, ExpressionList::Ptr arguments);
+    /**
+     * Parses a top level declaration with an explicit stack of constructs
+     * rather than recursion, nested statements only cost heap memory
      */
-    Expr::Ptr coalescing();
-    Expr::Ptr lor();
-    Expr::Ptr land();
-    Expr::Ptr call();
-    Expr::Ptr band();
-    Expr::Ptr bor();
-    Expr::Ptr bxor();
-    Stmt::Ptr statement();
-    Stmt::Ptr variableDecl();
     Stmt::Ptr declaration();
+    /**
+     * Parses the next declaration of the innermost block, or the next
+     * statement of the innermost construct
+     * @return the statement, or null when it entered a construct waiting
+     * for a nested statement or on errors
+     */
+    Stmt::Ptr begin();
+    /**
+     * Hands a nested statement to the innermost construct
+     * @return the statement of the construct when it is complete
+     */
+    Stmt::Ptr complete(Stmt::Ptr stmt);
+    Stmt::Ptr variableDecl();
     Stmt::Ptr expressionStmt();
-    Stmt::Ptr ifStmt();
-    Stmt::Ptr whileStmt();
-    Stmt::Ptr forStmt();
+    Stmt::Ptr function(bool isComptime);
+    Stmt::Ptr block(bool isComptime);
+    Stmt::Ptr blockEnd();
+    IfStmt::Ptr ifHead();
+    Stmt::Ptr ifStmt(bool isComptime);
+    Stmt::Ptr ifEnd(const Range &end);
+    Stmt::Ptr whileStmt(bool isComptime);
+    Stmt::Ptr forStmt(bool isComptime);
     ParameterStmt::Ptr parameter(ParameterStmt::Ptr prev = nullptr);
     Type::Ptr expressionType();
 
-    Token::Ref advance();
-    Token::Ref peek();
-    Token::Ref previous();
-    Token::Kind kind() { return Eof() ? Token::EoF : _current->kind; }
+    Token advance();
+    Token peek();
+    Token previous() const;
+    const Token &current() const { return _window[_current & WINDOW_MASK]; }
+    Range range(const Token &tok) const { return _lexer.range(tok); }
+    Token::Kind kind() { return Eof() ? Token::EoF : current().kind; }
     template <typename... Args>
     bool check(Args &&...args)
     {
-        return !Eof() && ((_current->kind == args) || ...);
+        return !Eof() && ((current().kind == args) || ...);
     }
 
     template <typename... Args>
@@ -88,47 +104,144 @@ private:
         return false;
     }
 
+    /**
+     * Reports an error and puts the parser in panic mode. Parse functions
+     * return `nullptr` on failure, the error propagates up to the nearest
+     * declaration which synchronizes the token stream
+     */
     template <typename... Args>
-    [[noreturn]] void error(const Range &range, Args &&...args)
+    std::nullptr_t error(const Range &range, Args &&...args)
     {
         L.error(range, std::forward<Args>(args)...);
-        throw Synchronize();
+        _panicking = true;
+        return nullptr;
     }
 
     template <typename... Args>
-    [[noreturn]] void error(const char *fmt, Args &&...args)
+    std::nullptr_t error(Diag id, Args &&...args)
     {
-        error(_current->range(), fmt, std::forward<Args>(args)...);
+        return error(range(current()), id, std::forward<Args>(args)...);
     }
 
     template <typename... Args>
-    Token::Ref expect(Token::Kind kind, Args &&...args)
+    std::optional<Token> expect(Token::Kind kind, Args &&...args)
     {
         if (check(kind)) {
-            return _current;
+            return current();
         }
-        error(_current->range(), std::forward<Args>(args)...);
+        error(range(current()), std::forward<Args>(args)...);
+        return std::nullopt;
     }
 
     template <typename... Args>
-    Token::Ref consume(Token::Kind kind, Args &&...args)
+    std::optional<Token> consume(Token::Kind kind, Args &&...args)
     {
         if (check(kind)) {
-            auto tok = _current;
-            advance();
-            return tok;
+            return advance();
         }
-        error(_current->range(), std::forward<Args>(args)...);
+        error(range(current()), std::forward<Args>(args)...);
+        return std::nullopt;
     }
 
     void synchronize();
 
-    bool Eof()
+    /**
+     * An operator waiting for its right operand while an expression is
+     * parsed, the left operands are kept on the operand stack. Infix
+     * operators whose precedence is below `min` end the operand
+     */
+    struct Operator {
+        enum Kind : std::uint8_t {
+            Unary,
+            Prefix,
+            Binary,
+            Assignment,
+            Coalescing,
+            /** `cond ?` waiting for the true branch */
+            Condition,
+            /** `cond ? a :` waiting for the false branch */
+            Ternary,
+            /** `(` waiting for the closing paren */
+            Grouping,
+            /** `callee(` waiting for an argument */
+            Arguments,
+            /** `f"` waiting for a part */
+            Parts,
+        };
+
+        Kind kind;
+        Token::Kind op;
+        Precedence min;
+        Range range{};
+        Node::Ptr node{nullptr};
+    };
+
+    void shift(Operator op, Expr::Ptr operand = nullptr);
+    Expr::Ptr reduce(const Operator &op, Expr::Ptr rhs);
+
+    /**
+     * A statement waiting for a nested statement while a declaration is
+     * parsed. Blocks, `for` loops and functions have a scope of their own
+     */
+    struct Construct {
+        enum Kind : std::uint8_t {
+            /** `{` waiting for a declaration or the closing brace */
+            Block,
+            /** `if (cond)` waiting for the statement run when it holds */
+            Then,
+            /** `if (cond) stmt else` waiting for the other statement */
+            Else,
+            /** `while (cond)` waiting for its body */
+            While,
+            /** `for (init; cond; update)` waiting for its body */
+            For,
+            /** `func name(params)` waiting for its body */
+            Function,
+        };
+
+        Kind kind;
+        bool isComptime{false};
+        Node::Ptr node{nullptr};
+        /** the last `if` of an `else if` chain */
+        IfStmt::Ptr tail{nullptr};
+    };
+
+    void enter(Construct::Kind kind, Node::Ptr node, bool isComptime);
+    /**
+     * Pops the innermost construct and its scope
+     * @return the statement of the construct
+     */
+    Stmt::Ptr leave();
+
+    /**
+     * Creates a node in the arena of the program being parsed
+     */
+    template <typename T, typename... Args>
+    typename T::Ptr make(Args &&...args)
     {
-        return _current->kind == Token::EoF || _current == _tokens.second;
+        return _arena->make<T>(std::forward<Args>(args)...);
     }
 
-    Token::Tange _tokens;
-    Token::Ref _current;
+    bool Eof() const { return current().kind == Token::EoF; }
+
+    void pull();
+
+    /**
+     * Tokens are pulled from the lexer on demand into a small ring buffer
+     * holding the previous, current and next tokens
+     */
+    static constexpr Token::Index WINDOW_SIZE = 4;
+    static constexpr Token::Index WINDOW_MASK = WINDOW_SIZE - 1;
+
+    Lexer &_lexer;
+    AstArena *_arena{nullptr};
+    Generator<Token> _stream;
+    std::array<Token, WINDOW_SIZE> _window{};
+    Token::Index _current{0};
+    Token::Index _pulled{0};
+    bool _panicking{false};
+    std::vector<Construct> _constructs{};
+    std::vector<Operator> _operators{};
+    std::vector<Expr::Ptr> _operands{};
 };
 } // namespace cstar
\ No newline at end of file
@@ -0,0 +1,111 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-04
+ */
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace cstar {
+
+template <typename V>
+struct PerfectHashEntry {
+    std::string_view key;
+    V value;
+};
+
+/**
+ * A perfect hash table over a fixed set of string keys, built at compile
+ * time. The hash only looks at the key's length and its first, middle
+ * and last characters, so a lookup costs one cheap hash and at most one
+ * string comparison.
+ *
+ * The table is built by searching for a seed under which none of the
+ * keys collide, if there is no such seed compilation fails.
+ */
+template <typename V, std::size_t N, std::size_t M = std::bit_ceil(N * 4)>
+class PerfectHash {
+    static_assert(N > 0, "a perfect hash table needs at least one key");
+    static_assert(std::has_single_bit(M), "table size must be a power of 2");
+
+    using Slot = std::conditional_t<(N < 0xFF), std::uint8_t, std::uint16_t>;
+    static constexpr std::uint32_t MAX_SEEDS = 1u << 16;
+
+public:
+    using Entry = PerfectHashEntry<V>;
+
+    consteval explicit PerfectHash(const Entry (&entries)[N])
+    {
+        for (std::size_t i = 0; i < N; i++)
+            _entries[i] = entries[i];
+
+        for (_seed = 0; _seed < MAX_SEEDS; _seed++) {
+            if (tryBuild())
+                return;
+        }
+        throw "no perfect hash seed found for the given keys";
+    }
+
+    /**
+     * @return the value mapped to the given key or a nullptr if the key
+     * is not in the table
+     */
+    constexpr const V *find(std::string_view key) const
+    {
+        if (key.empty())
+            return nullptr;
+
+        auto slot = _slots[hash(key, _seed)];
+        if (slot == 0)
+            return nullptr;
+
+        auto &entry = _entries[slot - 1];
+        return (entry.key == key) ? &entry.value : nullptr;
+    }
+
+private:
+    static constexpr std::size_t hash(std::string_view key, std::uint32_t seed)
+    {
+        constexpr std::uint32_t PRIME = 0x01000193u;
+        auto len = key.size();
+        auto h = (seed ^ std::uint32_t(len)) * 0x9E3779B1u;
+        h = (h ^ std::uint8_t(key[0])) * PRIME;
+        h = (h ^ std::uint8_t(key[len / 2])) * PRIME;
+        h = (h ^ std::uint8_t(key[len - 1])) * PRIME;
+        return (h ^ (h >> 16)) & (M - 1);
+    }
+
+    constexpr bool tryBuild()
+    {
+        _slots = {};
+        for (std::size_t i = 0; i < N; i++) {
+            auto &slot = _slots[hash(_entries[i].key, _seed)];
+            if (slot != 0)
+                return false;
+            slot = Slot(i + 1);
+        }
+        return true;
+    }
+
+    std::array<Entry, N> _entries{};
+    std::array<Slot, M> _slots{};
+    std::uint32_t _seed{0};
+};
+
+template <typename V, std::size_t N>
+consteval auto makePerfectHash(const PerfectHashEntry<V> (&entries)[N])
+{
+    return PerfectHash<V, N>(entries);
+}
+
+} // namespace cstar
@@ -0,0 +1,43 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-12
+ */
+
+#pragma once
+
+#include "compiler/ir.hpp"
+#include "compiler/writer.hpp"
+
+namespace cstar {
+
+/**
+ * Writes a lowered program in the intermediate language of QBE
+ * (https://c9x.me/compile/), which QBE compiles to assembly much faster
+ * than a C compiler compiles the output of `Codegen`.
+ *
+ * The IR maps directly to QBE's, temporaries that are assigned more than
+ * once are turned into SSA form by QBE and the stack slots of variables
+ * are promoted to registers.
+ */
+class QbeCodegen : public ir::Backend {
+public:
+    explicit QbeCodegen(CodeWriter &out);
+
+    void data(const ir::Module &m, const ir::Data &data) override;
+    void function(const ir::Module &m, const ir::Function &func) override;
+
+private:
+    void instruction(const ir::Module &m,
+                     const ir::Function &func,
+                     const ir::Instr &instr);
+    void operand(const ir::Module &m, const ir::Ref &ref);
+
+    CodeWriter &_out;
+};
+
+} // namespace cstar
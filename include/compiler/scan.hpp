@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-03
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Bulk character classification kernels used by the lexer to consume
+ * long runs of bytes at once. Each kernel scans `src` from `idx` and
+ * returns the index of the first byte at which the run ends, or `end`
+ * when the run reaches the end of the buffer.
+ *
+ * The implementation is selected at startup from the best instruction
+ * set supported by the host (AVX2, SSE2 or portable scalar code).
+ */
+namespace cstar::scan {
+
+typedef enum { isaScalar, isaSse2, isaAvx2 } Isa;
+
+/**
+ * @return the instruction set used by the scanning kernels
+ */
+Isa isa();
+
+/**
+ * Forces the kernels to use the given instruction set, falling back
+ * to the best one supported by the host if it is not available
+ *
+ * @return the instruction set actually selected
+ */
+Isa use(Isa isa);
+
+std::string_view toString(Isa isa);
+
+/**
+ * Skips a run of whitespace characters (as in `isspace`)
+ */
+std::uint32_t whitespace(const char *src, std::uint32_t idx, std::uint32_t end);
+
+/**
+ * Skips a run of identifier characters, i.e `[a-zA-Z0-9_$]`
+ */
+std::uint32_t identifier(const char *src, std::uint32_t idx, std::uint32_t end);
+
+/**
+ * Skips a run of decimal digits
+ */
+std::uint32_t digits(const char *src, std::uint32_t idx, std::uint32_t end);
+
+/**
+ * Finds the next character that could end a string literal segment,
+ * i.e one of `"`, `\`, `$` or a newline
+ */
+std::uint32_t stringBreak(const char *src,
+                          std::uint32_t idx,
+                          std::uint32_t end);
+
+/**
+ * Finds the next character that could open or close a nested
+ * multiline comment, i.e `*` or `/`
+ */
+std::uint32_t commentBreak(const char *src,
+                           std::uint32_t idx,
+                           std::uint32_t end);
+
+/**
+ * Finds the next newline character
+ */
+std::uint32_t lineEnd(const char *src, std::uint32_t idx, std::uint32_t end);
+
+} // namespace cstar::scan
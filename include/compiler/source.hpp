@@ -12,35 +12,135 @@
 
 #include <filesystem>
 #include <list>
+#include <shared_mutex>
 #include <string>
 #include <string_view>
+#include <vector>
+
+#include <compiler/utils.hpp>
 
 
 namespace cstar {
     class Log;
+    class Source;
+
+    /**
+     * Hands out to each loaded source a slice of one global 32-bit offset
+     * space, so that a `SourceLocation` alone identifies a byte in any of
+     * the sources of a compilation. Location 0 is never assigned and each
+     * slice is one byte longer than its source so that the end of a
+     * source does not alias the start of the next one.
+     *
+     * Slices are never reused, the locations of a destroyed source
+     * resolve to no source.
+     */
+    class SourceManager final {
+    public:
+        /**
+         * @return the source that contains the given location, `nullptr`
+         * if the location is invalid or its source was destroyed
+         */
+        static const Source* find(SourceLocation loc);
+
+    private:
+        friend class Source;
 
+        struct Slice {
+            SourceLocation base;
+            uint32_t size;
+            const Source* source;
+        };
+
+        SourceManager() = default;
+
+        static SourceLocation add(const Source& src);
+        static void move(SourceLocation base, const Source& src);
+        static void remove(SourceLocation base);
+
+        static SourceManager& get();
+        Slice* slice(SourceLocation loc);
+
+        std::shared_mutex _lock{};
+        std::vector<Slice> _slices{};
+        SourceLocation _next{1};
+    };
+
+    /**
+     * The contents of a source are always followed by `PADDING` sentinel
+     * bytes equal to `EOF`, which allows the lexer to look ahead without
+     * checking for the end of the source. Large files are memory mapped
+     * rather than read.
+     */
     class Source {
     public:
-        Source() = default;
-        Source(std::string name, std::string contents)
-            : _name{std::move(name)},
-              _contents{std::move(contents)}
-        {}
+        static constexpr std::size_t PADDING = 16;
+        static constexpr char SENTINEL = char(-1);
+        /**
+         * Files smaller than this are read with a single `read()` call,
+         * which is cheaper than setting up a mapping
+         */
+        static constexpr std::size_t MMAP_THRESHOLD = 64 * 1024;
 
+        /**
+         * An empty source, it is not given any locations so its ranges
+         * are the invalid range
+         */
+        Source();
+        Source(std::string name, std::string contents);
         Source(Log& L, std::filesystem::path file);
 
+        Source(const Source&) = delete;
+        Source& operator=(const Source&) = delete;
+        Source(Source&& other) noexcept;
+        Source& operator=(Source&& other) noexcept;
+        ~Source();
+
         const std::string& name() const { return _name; }
-        const std::string& contents() const { return _contents; }
+
+        /**
+         * @return the global location of the first byte of this source,
+         * the location of offset `n` is `base() + n`
+         */
+        SourceLocation base() const { return _base; }
+
+        std::string_view contents() const { return _contents; }
         std::size_t size() const { return _contents.size(); }
 
+        /**
+         * @return the source's bytes, valid up to `size() + PADDING`
+         */
+        const char* data() const { return _contents.data(); }
+
         const char& operator[](uint32_t index) const;
         const char* at(uint32_t index) const;
+
+        /**
+         * @return the zero based line and column of the given offset
+         */
+        LineColumn lineColumn(uint32_t offset) const;
+
+        /**
+         * @return the [start, end) offsets of the given line, excluding
+         * the line's terminating newline
+         */
+        std::pair<uint32_t, uint32_t> lineBounds(uint32_t line) const;
+
+        std::size_t lines() const { return _lines.size(); }
         bool operator==(const Source& other) const { return this == &other; }
         bool operator!=(const Source& other) const { return this != &other; }
 
     private:
-        std::string readFile(Log& L, const std::filesystem::path& fname);
+        void readFile(Log& L, const std::filesystem::path& fname);
+        bool mapFile(int fd, std::size_t size);
+        void unmap();
+        void indexLines();
+
         std::string _name{};
-        std::string _contents{};
+        std::string _buffer{};
+        void* _mapped{nullptr};
+        std::size_t _mappedSize{0};
+        std::string_view _contents{};
+        std::vector<uint32_t> _lines{0};
+        SourceLocation _base{0};
     };
 }
\ No newline at end of file
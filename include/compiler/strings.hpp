@@ -1,41 +1,57 @@
 /**
- * Copyright (c) 2022 suilteam, Carter 
+ * Copyright (c) 2022 suilteam, Carter
  *
  * This library is free software; you can redistribute it and/or modify it
  * under the terms of the MIT license. See LICENSE for details.
- * 
+ *
  * @author Mpho Mbotho
  * @date 2022-11-26
  */
 
 #pragma once
 
-#include <unordered_map>
-#include <string>
+#include <cstdint>
+#include <string_view>
 
 namespace cstar {
 
-    class Strings final {
-    public:
-
-        static std::string_view intern(std::string str) {
-            return _impl.intern(std::move(str));
-        }
-
-        static std::string_view intern(std::string_view str) {
-            return _impl.intern(str);
-        }
-
-    private:
-        Strings() = default;
-
-        class StringsImpl {
-        public:
-            std::string_view intern(std::string str);
-            std::string_view intern(std::string_view str);
-            std::unordered_map<std::string_view, std::string> _strings{};
-        };
-
-        static StringsImpl _impl;
-    };
-}
\ No newline at end of file
+/**
+ * The string interner shared by every compilation in the process. Each
+ * distinct string is stored once, in large arena blocks, and identified
+ * by a 32-bit id so that interned strings compare as integers. The hash
+ * of a string is computed when it is interned and kept with it.
+ *
+ * The interner is split in shards selected by the hash, each with its
+ * own lock, so that front-ends running on different threads rarely
+ * contend. Resolving an id never takes a lock.
+ */
+class Strings final {
+public:
+    using Id = std::uint32_t;
+
+    /**
+     * @return the id of the given string, interning it on first use
+     */
+    static Id id(std::string_view str);
+
+    static std::string_view intern(std::string_view str)
+    {
+        return get(id(str));
+    }
+
+    static std::string_view get(Id id);
+
+    /**
+     * @return the hash of the string with the given id
+     */
+    static std::uint32_t hash(Id id);
+
+    /**
+     * The hash function of the interner
+     */
+    static std::uint32_t hash(std::string_view str);
+
+private:
+    Strings() = default;
+};
+} // namespace cstar
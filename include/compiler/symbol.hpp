@@ -11,14 +11,16 @@
 #pragma once
 
 #include <compiler/node.hpp>
+#include <compiler/strings.hpp>
 #include <compiler/utils.hpp>
-#include <unordered_map>
+
+#include <cstdint>
+#include <limits>
 #include <utility>
+#include <vector>
 
 namespace cstar {
 
-class SymbolTable;
-
 typedef enum { symUnknown, symVariable, symFunc } SymbolKind;
 
 template <typename T = Node>
@@ -26,60 +28,107 @@ struct Symbol {
     SymbolKind kind{symUnknown};
     Range range{};
     typename T::Ptr value{nullptr};
-    SymbolTable *scope{nullptr};
+    /** the depth of the scope the symbol was defined in */
+    std::uint32_t scope{0};
     operator bool() const { return kind != symUnknown; }
 };
 
+/**
+ * A single table for every scope of a compilation. Names are interned
+ * identifiers which map, with open addressing, to the innermost binding
+ * of the name; each binding links to the binding it shadows.
+ *
+ * Bindings are kept on a stack in the order they are defined, which is
+ * also the undo log of the scopes: popping a scope unwinds the bindings
+ * defined since it was pushed. Lookups are a single probe whatever the
+ * depth and, once the table has warmed up, scopes do not allocate.
+ */
 class SymbolTable {
 public:
     CSTAR_PTR(SymbolTable);
 
 public:
-    static constexpr int MAX_LOOKUP_DEPTH = 500;
+    /** lookups reach every enclosing scope unless told otherwise */
+    static constexpr int MAX_LOOKUP_DEPTH = std::numeric_limits<int>::max();
 
 public:
-    SymbolTable(SymbolTable::Ptr enclosing = nullptr)
-        : _enclosing{std::move(enclosing)}
-    {
-    }
+    SymbolTable();
 
-    bool define(std::string_view name,
+    bool define(Strings::Id name,
                 Node::Ptr sym,
                 Range range,
                 SymbolKind kind);
 
-    Symbol<> find(std::string_view name, int depth = MAX_LOOKUP_DEPTH);
+    /**
+     * @return the innermost symbol with the given name, defined at most
+     * `depth` scopes out, the symbol is valid until the next definition
+     */
+    const Symbol<> *find(Strings::Id name, int depth = MAX_LOOKUP_DEPTH) const;
 
     // clang-format off
     template <typename T>
         requires std::is_base_of_v<Node, T>
-    Symbol<> lookup( // clang-format on
-        std::string_view name,
-        int depth = MAX_LOOKUP_DEPTH)
+    Symbol<T> lookup( // clang-format on
+        Strings::Id name,
+        int depth = MAX_LOOKUP_DEPTH) const
     {
         auto sym = find(name, depth);
-        return Symbol<T>{sym.kind,
-                         sym.range,
-                         std::dynamic_pointer_cast<T>(sym.value),
-                         sym.scope};
+        if (sym == nullptr)
+            return {};
+        return Symbol<T>{sym->kind,
+                         sym->range,
+                         dyn_cast<T>(sym->value),
+                         sym->scope};
     }
 
-    bool assign(std::string_view name, Node::Ptr value);
+    bool assign(Strings::Id name, Node::Ptr value);
 
-    SymbolTable::Ptr enclosing() { return _enclosing; }
+    void push();
+    void pop();
 
-private:
-    using SymbolsMap = std::unordered_map<std::string_view, Symbol<>>;
+    /**
+     * @return the depth of the current scope, 0 being the global scope
+     */
+    std::uint32_t depth() const { return std::uint32_t(_scopes.size()); }
 
-    SymbolsMap _symbols{};
-    SymbolTable::Ptr _enclosing{};
+private:
+    static constexpr std::uint32_t NONE = ~std::uint32_t(0);
+
+    struct Binding {
+        Symbol<> symbol;
+        Strings::Id name;
+        std::uint32_t shadowed;
+    };
+
+    struct Slot {
+        Strings::Id name{NONE};
+        std::uint32_t binding{NONE};
+    };
+
+    /**
+     * @return the slot of the given name, it is claimed if the name has
+     * never been defined
+     */
+    Slot &slot(Strings::Id name);
+    /**
+     * @return the index of the innermost binding of the given name or
+     * NONE if it is not bound
+     */
+    std::uint32_t binding(Strings::Id name) const;
+    void grow();
+
+    std::vector<Slot> _slots{};
+    std::uint32_t _used{0};
+    std::vector<Binding> _bindings{};
+    /** the size of the bindings stack when each scope was pushed */
+    std::vector<std::uint32_t> _scopes{};
 };
 
 class SymbolTableScope {
 public:
     SymbolTableScope(SymbolTable::Ptr root);
-    void push();
-    void pop();
+    void push() { table().push(); }
+    void pop() { table().pop(); }
     SymbolTable &table();
 
 private:
@@ -10,12 +10,12 @@
 
 #pragma once
 
+#include <compiler/strings.hpp>
 #include <compiler/utils.hpp>
 
-#include <list>
+#include <span>
 #include <string>
 #include <string_view>
-#include <variant>
 
 // clang-format off
 #define TOKEN_LIST(XX, YY, ZZ, BB) \
@@ -154,19 +154,92 @@
         XX(USING)       \
         XX(WHILE)
 
+/**
+ * Compound assignment operators and the binary operator they apply to
+ * the assignee
+ */
+#define COMPOUND_ASSIGNMENT_LIST(XX) \
+        XX(PLUSASSGIN,      PLUS)       \
+        XX(MINUSASSIGN,     MINUS)      \
+        XX(MULTASSIGN,      MULT)       \
+        XX(DIVASSIGN,       DIV)        \
+        XX(MODASSIGN,       MOD)        \
+        XX(SHLASSIGN,       SHL)        \
+        XX(SHRASSIGN,       SHR)        \
+        XX(BITANDASSIGN,    BITAND)     \
+        XX(BITORASSIGN,     BITOR)      \
+        XX(BITXORASSIGN,    BITXOR)
+
+/**
+ * Operators that follow an operand and the precedence they bind with,
+ * assignments are not listed, they all bind with `Assignment`
+ */
+#define INFIX_OPERATOR_LIST(XX) \
+        XX(QUESTION,            Ternary)        \
+        XX(QUESTIONQUESTION,    Coalescing)     \
+        XX(LOR,                 LogicalOr)      \
+        XX(LAND,                LogicalAnd)     \
+        XX(BITOR,               BitOr)          \
+        XX(BITXOR,              BitXor)         \
+        XX(BITAND,              BitAnd)         \
+        XX(EQUAL,               Equality)       \
+        XX(NEQ,                 Equality)       \
+        XX(LT,                  Comparison)     \
+        XX(LTE,                 Comparison)     \
+        XX(GT,                  Comparison)     \
+        XX(GTE,                 Comparison)     \
+        XX(SHL,                 Shift)          \
+        XX(SHR,                 Shift)          \
+        XX(PLUS,                Term)           \
+        XX(MINUS,               Term)           \
+        XX(MULT,                Factor)         \
+        XX(DIV,                 Factor)         \
+        XX(MOD,                 Factor)         \
+        XX(EXPONENT,            Exponent)       \
+        XX(PLUSPLUS,            Postfix)        \
+        XX(MINUSMINUS,          Postfix)        \
+        XX(LPAREN,              Postfix)
+
 // clang-format on
 
 namespace cstar {
 
-using TokenValue = std::variant<std::monostate,
-                                bool,
-                                std::uint32_t,
-                                std::uint64_t,
-                                double,
-                                std::string_view>;
+/**
+ * How tightly an operator binds to its operands, from the loosest to the
+ * tightest. Prefix operators bind with `Unary`, which is looser than
+ * `Exponent` so that `-a ** b` is `-(a ** b)`
+ */
+enum class Precedence : std::uint8_t {
+    None,
+    Assignment,
+    Ternary,
+    Coalescing,
+    LogicalOr,
+    LogicalAnd,
+    BitOr,
+    BitXor,
+    BitAnd,
+    Equality,
+    Comparison,
+    Shift,
+    Term,
+    Factor,
+    Unary,
+    Exponent,
+    Postfix
+};
+
+/**
+ * A token is packed into 16 bytes: an 8 byte literal payload followed by
+ * the token's source offset, its length and its kind. Literal values
+ * that fit are stored inline and string literals point at their value
+ * owned by the lexer. Identifiers carry the 32-bit id their name is
+ * interned to, `value<std::string_view>()` resolves it with
+ * `Strings::get`.
+ */
 class Token {
 public:
-    typedef enum {
+    typedef enum : std::uint8_t {
 #define XX(NAME, _) NAME,
 #define ZZ(NAME, ...) NAME,
 #define YY(NAME, _) NAME,
@@ -178,16 +251,15 @@ public:
 #undef BB
     } Kind;
 
-    using Ref = std::list<Token>::iterator;
-    using Tange = std::pair<Ref, Ref>;
+    using Index = std::uint32_t;
+    using Tange = std::span<const Token>;
+
+    static constexpr std::uint32_t MAX_LENGTH = (1u << 24) - 1;
 
 public:
     Token() = default;
-    Token(Kind kind, Range range) : kind{kind}, _range{range} {}
-
-    template <typename T>
-    Token(Kind kind, Range range, T value)
-        : kind{kind}, _range{range}, _value{std::forward<T>(value)}
+    Token(Kind kind, std::uint32_t start, std::uint32_t length)
+        : start{start}, _length{length}, kind{kind}
     {
     }
 
@@ -197,7 +269,12 @@ public:
 
     bool isKeyword() const { return isKeyword(kind); }
 
-    const Range &range() const { return _range; }
+    std::uint32_t length() const { return _length; }
+    std::uint32_t end() const { return start + _length; }
+    /**
+     * @return the interned name of an identifier token
+     */
+    Strings::Id id() const { return _value.id; }
 
     static bool isKeyword(Kind kind)
     {
@@ -211,15 +288,62 @@ public:
     static std::string_view toString(Kind kind, bool strip = false);
 
     template <typename T>
-    const T &value() const
+    T value() const
     {
-        return get<T>(_value);
+        if constexpr (std::is_same_v<T, bool>)
+            return _value.b;
+        else if constexpr (std::is_same_v<T, std::uint32_t>)
+            return _value.chr;
+        else if constexpr (std::is_same_v<T, std::uint64_t>)
+            return _value.integer;
+        else if constexpr (std::is_same_v<T, double>)
+            return _value.real;
+        else if constexpr (std::is_same_v<T, std::string_view>) {
+            if (kind == STRING)
+                return *_value.str;
+            return Strings::get(_value.id);
+        }
+        else
+            static_assert(!sizeof(T), "unsupported token value type");
     }
 
-    template <typename T>
-    bool has() const
+    /**
+     * @return the precedence of the given token when it follows an
+     * operand, `Precedence::None` if it is not an infix operator
+     */
+    static Precedence precedence(Kind kind)
     {
-        return holds_alternative<T>(_value);
+        switch (kind) {
+        case ASSIGN:
+#define XX(N, _) case N:
+            COMPOUND_ASSIGNMENT_LIST(XX)
+#undef XX
+            return Precedence::Assignment;
+#define XX(N, P)                                                               \
+    case N:                                                                    \
+        return Precedence::P;
+            INFIX_OPERATOR_LIST(XX)
+#undef XX
+        default:
+            return Precedence::None;
+        }
+    }
+
+    /**
+     * @return the binary operator applied by the given compound
+     * assignment operator, `EoF` if it is not a compound assignment
+     */
+    static Kind compoundOperator(Kind kind)
+    {
+        switch (kind) {
+#define XX(N, OP)                                                              \
+    case N:                                                                    \
+        return OP;
+            COMPOUND_ASSIGNMENT_LIST(XX)
+#undef XX
+        default:
+            return EoF;
+        }
     }
 
     bool isBinaryOperator() const;
@@ -228,14 +352,28 @@ public:
     bool isStatementBoundary() const;
     static bool isLogicalOperator(Token::Kind kind);
 
+private:
+    friend class Lexer;
+    union {
+        bool b;
+        std::uint32_t chr;
+        std::uint64_t integer;
+        double real;
+        Strings::Id id;
+        const std::string_view *str;
+    } _value{.integer = 0};
+
 public:
-    Kind kind{EoF};
+    std::uint32_t start{0};
 
 private:
-    friend class Lexer;
-    Range _range{};
-    TokenValue _value{};
+    std::uint32_t _length : 24 {0};
+
+public:
+    Kind kind : 8 {EoF};
 };
+
+static_assert(sizeof(Token) == 16, "tokens must stay 16 bytes");
 } // namespace cstar
 
-std::ostream &operator<<(std::ostream &os, const cstar::Token &tok);
\ No newline at end of file
+std::ostream &operator<<(std::ostream &os, const cstar::Token &tok);
@@ -18,7 +18,7 @@ namespace cstar {
 
     class Type : public ContainerNode {
     public:
-        CSTAR_PTR(Type);
+        CSTAR_NODE_PTR(Type);
         using ContainerNode::ContainerNode;
 
         virtual ~Type() = default;
@@ -31,22 +31,48 @@ namespace cstar {
 
         static Type::Ptr leastUpperBound(Type::Ptr t1, Type::Ptr t2);
 
-        VisitableNode();
+        static bool classof(NodeKind kind)
+        {
+            switch (kind) {
+            case NodeKind::Type:
+#define XX(N) case NodeKind::N##Type:
+                NODE_TYPE_LIST(XX)
+#undef XX
+                return true;
+            default:
+                return false;
+            }
+        }
     };
 
-    class BuiltinType : public virtual Type {
+    class BuiltinType : public Type {
     public:
-        CSTAR_PTR(BuiltinType);
+        CSTAR_NODE_PTR(BuiltinType);
+        static constexpr NodeKind Kind = NodeKind::BuiltinType;
 
-        using Type::Type;
         BuiltinType(std::string_view name)
-            : _name{name}
+            : BuiltinType(Kind, name)
         {}
 
 
         std::string_view name() const override { return _name; }
 
-        VisitableNode();
+        static bool classof(NodeKind kind)
+        {
+            switch (kind) {
+#define XX(N) case NodeKind::N##Type:
+                NODE_TYPE_LIST(XX)
+#undef XX
+                return true;
+            default:
+                return false;
+            }
+        }
+
+    protected:
+        BuiltinType(NodeKind kind, std::string_view name)
+            : Type(kind), _name{name}
+        {}
 
     private:
         std::string_view _name{"unknown"};
@@ -54,33 +80,37 @@ namespace cstar {
 
     class BoolType : public BuiltinType {
     public:
-        CSTAR_PTR(BoolType);
+        CSTAR_NODE_PTR(BoolType);
+        CSTAR_NODE_KIND(BoolType);
 
-        BoolType() : BuiltinType("bool") {}
+        BoolType() : BuiltinType(Kind, "bool") {}
 
         virtual size_t size() const override { return sizeof(bool); }
     };
 
     class CharType : public BuiltinType {
     public:
-        CSTAR_PTR(CharType);
-        CharType() : BuiltinType("char") {}
+        CSTAR_NODE_PTR(CharType);
+        CSTAR_NODE_KIND(CharType);
+        CharType() : BuiltinType(Kind, "char") {}
 
         size_t size() const override { return sizeof(uint32_t); }
     };
 
     class StringType : public BuiltinType {
     public:
-        CSTAR_PTR(StringType);
-        StringType() : BuiltinType("string") {}
+        CSTAR_NODE_PTR(StringType);
+        CSTAR_NODE_KIND(StringType);
+        StringType() : BuiltinType(Kind, "string") {}
         size_t size() const override { return sizeof(const char*); }
     };
 
     class IntegerType final : public BuiltinType {
     public:
-        CSTAR_PTR(IntegerType);
+        CSTAR_NODE_PTR(IntegerType);
+        CSTAR_NODE_KIND(IntegerType);
         IntegerType(std::string_view name, uint8_t bits, bool isSigned)
-            : BuiltinType(name), bits{bits}, isSigned{isSigned}
+            : BuiltinType(Kind, name), bits{bits}, isSigned{isSigned}
         {}
 
         static IntegerType::Ptr bigger(IntegerType::Ptr i1, IntegerType::Ptr i2);
@@ -93,9 +123,10 @@ namespace cstar {
 
     class FloatType : public BuiltinType {
     public:
-        CSTAR_PTR(FloatType);
+        CSTAR_NODE_PTR(FloatType);
+        CSTAR_NODE_KIND(FloatType);
         FloatType(std::string_view name, uint8_t bits)
-            : BuiltinType(std::move(name)), bits{bits}
+            : BuiltinType(Kind, std::move(name)), bits{bits}
         {}
 
         size_t size() const override { return bits/8; }
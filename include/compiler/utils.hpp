@@ -13,6 +13,7 @@
 #include <iomanip>
 #include <memory>
 #include <sstream>
+#include <type_traits>
 #include <variant>
 #include <vector>
 
@@ -77,39 +78,48 @@ struct LineColumn {
     uint32_t line{0}, column{0};
 };
 
-struct Position {
-    uint32_t index{0};
-    LineColumn coord{};
-};
+/**
+ * A byte offset in the location space shared by all the sources of a
+ * compilation, see `SourceManager`. 0 is not the location of any byte.
+ */
+using SourceLocation = uint32_t;
 
+/**
+ * A [start, end) range of source locations. Ranges are two integers, the
+ * source, line and column of a range are only resolved when needed,
+ * typically when a diagnostic is rendered.
+ */
 struct Range {
     Range() = default;
 
-    Range(const Source &src, uint32_t start, uint32_t end, LineColumn pos = {0})
-        : _source(&src), start{start}, end{end}, position{pos}
+    Range(SourceLocation start, SourceLocation end) : start{start}, end{end}
     {
     }
 
-    Range(const Source &src, Position pos, uint32_t end)
-        : _source(&src), start{pos.index}, end{end}, position{pos.coord}
-    {
-    }
-
-    Range(const Range &other) noexcept;
-    Range &operator=(const Range &other) noexcept;
-    Range(Range &&other) noexcept;
-    Range &operator=(Range &&other) noexcept;
+    /**
+     * Creates the range of the given [start, end) offsets of `src`
+     */
+    Range(const Source &src, uint32_t start, uint32_t end);
 
     const Source &source() const;
 
-    const Source *src() const { return _source; }
+    /**
+     * @return the source of this range, `nullptr` if it has none
+     */
+    const Source *src() const;
 
     std::string_view toString() const;
 
+    /**
+     * Resolves the line and column of the start of this range, this
+     * looks up the range's source and then does a binary search on its
+     * line table and is meant to be used when a diagnostic is rendered
+     */
+    LineColumn position() const;
+
     bool operator==(const Range &other) const
     {
-        return (&_source == &other._source) && (start == other.start) &&
-               (end == other.end);
+        return (start == other.start) && (end == other.end);
     }
 
     bool operator!=(const Range &other) const { return !(*this == other); }
@@ -129,16 +139,11 @@ struct Range {
 
     static const Range &Invalid();
 
-    uint32_t start{0};
-    uint32_t end{0};
-    LineColumn position{0};
-
-private:
-    const Source *_source{nullptr};
+    SourceLocation start{0};
+    SourceLocation end{0};
 };
 
-std::string_view locs(std::string_view str);
-std::string_view locs(std::string &&str);
+static_assert(std::is_trivially_copyable_v<Range> and sizeof(Range) == 8);
 
 template <typename Flags_t>
 requires std::is_enum_v<Flags_t>
@@ -16,7 +16,6 @@ class Program;
 
 #define NODE_TYPE_LIST(XX)                                                     \
     XX(Builtin)                                                                \
-    XX(Void)                                                                   \
     XX(Bool)                                                                   \
     XX(Char)                                                                   \
     XX(String)                                                                 \
@@ -78,33 +77,4 @@ NODE_EXPR_LIST(XX)
 NODE_DECL_LIST(XX)
 #undef XX
 
-class Visitor {
-public:
-#define XX(N)                                                                  \
-    virtual void visit(N &node) {}
-    NODE_LIST(XX)
-#undef XX
-
-#define XX(N) virtual void visit(N##Type &node){};
-    NODE_TYPE_LIST(XX)
-#undef XX
-
-#define XX(N)                                                                  \
-    virtual void visit(N##Stmt &node) {}
-    NODE_STMT_LIST(XX)
-#undef XX
-
-#define XX(N)                                                                  \
-    virtual void visit(N##Expr &node) {}
-    NODE_EXPR_LIST(XX)
-#undef XX
-
-#define XX(N)                                                                  \
-    virtual void visit(N##Decl &node) {}
-    NODE_DECL_LIST(XX)
-#undef XX
-};
-
-#define VisitableNode()                                                        \
-    virtual void accept(Visitor &visitor) override { visitor.visit(*this); }
 } // namespace cstar
\ No newline at end of file
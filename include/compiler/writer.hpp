@@ -0,0 +1,150 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-10
+ */
+
+#pragma once
+
+#include <charconv>
+#include <concepts>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cstar {
+
+/**
+ * Accumulates generated code in large chunks which are written out at
+ * once by one of the `flush` functions. Nothing is written to the
+ * destination before that, the writer never flushes on a new line and
+ * numbers are formatted with `std::to_chars` rather than through a
+ * stream's locale.
+ */
+class CodeWriter {
+public:
+    static constexpr std::size_t CHUNK_SIZE = 256 * 1024;
+    /** the widest indentation written with a single copy */
+    static constexpr std::size_t MAX_INDENT = 128;
+
+    CodeWriter() { grow(); }
+    CodeWriter(const CodeWriter &) = delete;
+    CodeWriter &operator=(const CodeWriter &) = delete;
+
+    CodeWriter &operator<<(std::string_view str)
+    {
+        // an empty view may not point anywhere, memcpy wants a valid pointer
+        if (str.empty())
+            return *this;
+        if (std::size_t(_end - _cursor) < str.size())
+            return append(str);
+        std::memcpy(_cursor, str.data(), str.size());
+        _cursor += str.size();
+        return *this;
+    }
+
+    CodeWriter &operator<<(const char *str)
+    {
+        return *this << std::string_view{str};
+    }
+
+    CodeWriter &operator<<(char c)
+    {
+        if (_cursor == _end)
+            grow();
+        *_cursor++ = c;
+        return *this;
+    }
+
+    template <std::integral T>
+    CodeWriter &operator<<(T value)
+    {
+        return format(value);
+    }
+
+    /**
+     * Appends everything written to `other` so far, which is left as is
+     */
+    CodeWriter &operator<<(const CodeWriter &other);
+
+    /**
+     * Floating point numbers are written like `printf("%g")`, which is
+     * also how a default formatted `std::ostream` writes them
+     */
+    CodeWriter &operator<<(double value)
+    {
+        return format(value, std::chars_format::general, 6);
+    }
+
+    /**
+     * Writes `n` spaces
+     */
+    CodeWriter &indent(std::size_t n);
+
+    /**
+     * @return the number of bytes written and not flushed yet
+     */
+    std::size_t size() const;
+
+    /**
+     * Writes everything to the given file descriptor, with a `writev`
+     * call for as many chunks as the system allows at once, and empties
+     * the writer
+     *
+     * @return false if the write failed, `errno` is then set
+     */
+    bool flush(int fd);
+
+    /**
+     * Writes everything to the given file, one `fwrite` per chunk, and
+     * empties the writer
+     */
+    bool flush(std::FILE *file);
+
+    void flush(std::ostream &os);
+
+    /**
+     * @return everything written so far, without flushing it
+     */
+    std::string str() const;
+
+    void clear();
+
+private:
+    /** room for the longest number `std::to_chars` can produce */
+    static constexpr std::size_t MAX_NUMBER = 32;
+
+    template <typename T, typename... Args>
+    CodeWriter &format(T value, Args... args)
+    {
+        // format in place when it fits, the common case
+        if (std::size_t(_end - _cursor) >= MAX_NUMBER) {
+            _cursor = std::to_chars(_cursor, _end, value, args...).ptr;
+            return *this;
+        }
+        char buf[MAX_NUMBER];
+        auto end = std::to_chars(buf, buf + MAX_NUMBER, value, args...).ptr;
+        return append({buf, std::size_t(end - buf)});
+    }
+
+    CodeWriter &append(std::string_view str);
+    void grow();
+
+    std::string_view chunk(std::size_t i) const;
+
+    std::vector<std::unique_ptr<char[]>> _chunks{};
+    /** the number of chunks in use, the others are kept for reuse */
+    std::size_t _used{0};
+    char *_cursor{nullptr};
+    char *_end{nullptr};
+};
+
+} // namespace cstar
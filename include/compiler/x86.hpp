@@ -0,0 +1,52 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-13
+ */
+
+#pragma once
+
+#include "compiler/elf.hpp"
+#include "compiler/ir.hpp"
+
+#include <memory>
+
+namespace cstar {
+
+/**
+ * Compiles a lowered program straight to x86-64 machine code in an ELF
+ * object, following the System V calling convention, without a C compiler
+ * or an assembler. It is meant for fast debug builds rather than fast code.
+ *
+ * Each function is compiled in a single pass over its instructions once
+ * its temporaries are given a register by a linear scan over their live
+ * intervals. Temporaries that do not get one live in the stack frame.
+ */
+class X86Codegen : public ir::Backend {
+public:
+    explicit X86Codegen(ElfObject &object);
+    ~X86Codegen() override;
+
+    void data(const ir::Module &m, const ir::Data &data) override;
+    void function(const ir::Module &m, const ir::Function &func) override;
+
+private:
+    class Compiler;
+
+    /**
+     * @return the object symbol of the given symbol of the module
+     */
+    std::uint32_t symbol(const ir::Module &m, std::uint32_t id);
+
+    ElfObject &_object;
+    /** the object symbols of the module symbols, 0 when not mapped yet */
+    std::vector<std::uint32_t> _symbols{};
+    /** compiles functions, it keeps its buffers between functions */
+    std::unique_ptr<Compiler> _compiler;
+};
+
+} // namespace cstar
@@ -0,0 +1,63 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-05
+ */
+
+#include "compiler/arena.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace cstar {
+
+std::string_view Arena::copy(std::string_view str)
+{
+    if (str.empty())
+        return {};
+
+    auto data = static_cast<char *>(allocate(str.size(), 1));
+    std::memcpy(data, str.data(), str.size());
+    return {data, str.size()};
+}
+
+void Arena::merge(Arena &&other)
+{
+    // the current block stays current, blocks are never revisited so the
+    // unused tail of the other arena's block is simply dropped
+    _blocks.reserve(_blocks.size() + other._blocks.size());
+    for (auto &block : other._blocks)
+        _blocks.push_back(std::move(block));
+    _allocated += other._allocated;
+    other.reset();
+}
+
+void Arena::reset()
+{
+    _blocks.clear();
+    _cursor = _end = nullptr;
+    _allocated = 0;
+}
+
+void *Arena::grow(std::size_t size, std::size_t align)
+{
+    // oversized requests get a block of their own so that the remainder
+    // of the current block is not wasted
+    auto blockSize = std::max(_blockSize, size + align);
+    auto &block = _blocks.emplace_back(new char[blockSize]);
+    if (blockSize != _blockSize and _cursor != nullptr) {
+        auto p = (std::uintptr_t(block.get()) + align - 1) & ~(align - 1);
+        _allocated += size;
+        return reinterpret_cast<void *>(p);
+    }
+
+    _cursor = block.get();
+    _end = _cursor + blockSize;
+    return allocate(size, align);
+}
+
+} // namespace cstar
@@ -15,23 +15,30 @@
 
 namespace cstar {
 
-FunctionDecl::FunctionDecl(std::string_view funcName, Range range)
-    : Stmt(std::move(range)), name{funcName}
+FunctionDecl::FunctionDecl(Strings::Id funcName, Range range)
+    : Stmt(Kind, slots(), std::move(range)), name{funcName}
 {
     returnType(builtin::voidType());
     params(nullptr);
     body(nullptr);
 }
 
-Expr::Expr(Type::Ptr tp, Range range) : ContainerNode(std::move(range))
+Expr::Expr(NodeKind kind,
+           std::span<Node::Ptr> slots,
+           Type::Ptr tp,
+           Range range)
+    : ContainerNode(kind, slots, std::move(range))
 {
     type(std::move(tp));
 }
 
-Expr::Expr(Range range) : Expr(builtin::autoType(), std::move(range)) {}
+Expr::Expr(NodeKind kind, std::span<Node::Ptr> slots, Range range)
+    : Expr(kind, slots, builtin::autoType(), std::move(range))
+{
+}
 
 AssignmentExpr::AssignmentExpr(Expr::Ptr lhs, Expr::Ptr rhs, Range range)
-    : Expr(std::move(range))
+    : Expr(Kind, slots(), std::move(range))
 {
     assignee(std::move(lhs));
     value(std::move(rhs));
@@ -41,7 +48,7 @@ TernaryExpr::TernaryExpr(Expr::Ptr cond,
                          Expr::Ptr iTrue,
                          Expr::Ptr iFalse,
                          Range range)
-    : Expr(std::move(range))
+    : Expr(Kind, slots(), std::move(range))
 {
     condition(std::move(cond));
     ifTrue(std::move(iTrue));
@@ -51,7 +58,7 @@ TernaryExpr::TernaryExpr(Expr::Ptr cond,
 NullishCoalescingExpr::NullishCoalescingExpr(Expr::Ptr e1,
                                              Expr::Ptr e2,
                                              Range range)
-    : Expr(std::move(range))
+    : Expr(Kind, slots(), std::move(range))
 {
     lhs(std::move(e1));
     rhs(std::move(e2));
@@ -61,73 +68,83 @@ BinaryExpr::BinaryExpr(Expr::Ptr lhs,
                        Token::Kind op,
                        Expr::Ptr rhs,
                        Range range)
-    : Expr(std::move(range)), op{op}
+    : Expr(Kind, slots(), std::move(range)), op{op}
 {
     left(std::move(lhs));
     right(std::move(rhs));
 }
 
 UnaryExpr::UnaryExpr(Token::Kind op, Expr::Ptr rhs, Range range)
-    : Expr(std::move(range)), op{op}
+    : Expr(Kind, slots(), std::move(range)), op{op}
 {
     operand(std::move(rhs));
 }
 
 PrefixExpr::PrefixExpr(Token::Kind op, Expr::Ptr rhs, Range range)
-    : Expr(std::move(range)), op{op}
+    : Expr(Kind, slots(), std::move(range)), op{op}
 {
     operand(std::move(rhs));
 }
 
 PostfixExpr::PostfixExpr(Token::Kind op, Expr::Ptr lhs, Range range)
-    : Expr(std::move(range)), op{op}
+    : Expr(Kind, slots(), std::move(range)), op{op}
 {
     operand(std::move(lhs));
 }
 
 BoolExpr::BoolExpr(bool value, Range range)
-    : LiteralExpr(std::move(range)), value{value}
+    : LiteralExpr(Kind, slots(), std::move(range)), value{value}
 {
     type(builtin::booleanType());
 }
 
 CharExpr::CharExpr(uint32_t value, Range range)
-    : LiteralExpr(std::move(range)), value{value}
+    : LiteralExpr(Kind, slots(), std::move(range)), value{value}
 {
     type(builtin::charType());
 }
 
 IntegerExpr::IntegerExpr(int64_t value, Range range)
-    : LiteralExpr(std::move(range)), value{value}
+    : LiteralExpr(Kind, slots(), std::move(range)), value{value}
 {
     type(builtin::i64Type());
 }
 
 FloatExpr::FloatExpr(double value, Range range)
-    : LiteralExpr(std::move(range)), value{value}
+    : LiteralExpr(Kind, slots(), std::move(range)), value{value}
 {
     type(builtin::f64Type());
 }
 
 StringExpr::StringExpr(std::string_view value, Range range)
-    : LiteralExpr(std::move(range)), value{value}
+    : LiteralExpr(Kind, slots(), std::move(range)), value{value}
 {
     type(builtin::stringType());
 }
 
-GroupingExpr::GroupingExpr(Expr::Ptr e, Range range) : Expr(std::move(range))
+GroupingExpr::GroupingExpr(Expr::Ptr e, Range range)
+    : Expr(Kind, slots(), std::move(range))
 {
     expr(std::move(e));
 }
 
-CallExpr::CallExpr(Expr::Ptr func, Range range) : Expr(std::move(range))
+CallExpr::CallExpr(Expr::Ptr func, Range range)
+    : Expr(Kind, slots(), std::move(range))
 {
     callee(std::move(func));
     arguments(nullptr);
 }
 
-DeclarationStmt::DeclarationStmt(std::string_view var, bool imm, Range range)
-    : Stmt(std::move(range)), name{var}
+DeclarationStmt::DeclarationStmt(Strings::Id var, bool imm, Range range)
+    : DeclarationStmt(Kind, var, imm, std::move(range))
+{
+}
+
+DeclarationStmt::DeclarationStmt(NodeKind kind,
+                                 Strings::Id var,
+                                 bool imm,
+                                 Range range)
+    : Stmt(kind, slots(), std::move(range)), name{var}
 {
     type(builtin::autoType());
     value(nullptr);
@@ -135,31 +152,33 @@ DeclarationStmt::DeclarationStmt(std::string_view var, bool imm, Range range)
         flags |= gflIsImmutable;
 }
 
-ParameterStmt::ParameterStmt(std::string_view var, Range range)
-    : DeclarationStmt(var, true, std::move(range))
+ParameterStmt::ParameterStmt(Strings::Id var, Range range)
+    : DeclarationStmt(Kind, var, true, std::move(range))
 {
 }
 
 ExpressionStmt::ExpressionStmt(Expr::Ptr exp, Range range)
-    : Stmt(std::move(range))
+    : Stmt(Kind, slots(), std::move(range))
 {
     expr(std::move(exp));
 }
 
-IfStmt::IfStmt(Expr::Ptr cond, Range range) : Stmt(std::move(range))
+IfStmt::IfStmt(Expr::Ptr cond, Range range)
+    : Stmt(Kind, slots(), std::move(range))
 {
     condition(std::move(cond));
     then(nullptr);
     otherwise(nullptr);
 }
 
-WhileStmt::WhileStmt(Expr::Ptr cond, Range range) : Stmt(std::move(range))
+WhileStmt::WhileStmt(Expr::Ptr cond, Range range)
+    : Stmt(Kind, slots(), std::move(range))
 {
     condition(std::move(cond));
     body(nullptr);
 }
 
-ForStmt::ForStmt(Range range) : Stmt(std::move(range))
+ForStmt::ForStmt(Range range) : Stmt(Kind, slots(), std::move(range))
 {
     init(nullptr);
     condition(nullptr);
@@ -9,23 +9,24 @@
  */
 
 #include "compiler/builtin.hpp"
+#include "compiler/phash.hpp"
 
 namespace cstar {
 
 #define BUILTIN_CREATE(I, N)                                            \
-    static auto s##I##Type = mk<BuiltinType>(N);                        \
-    return s##I##Type \
+    static BuiltinType s##I##Type{N};                                   \
+    return &s##I##Type
 
     BuiltinType::Ptr builtin::voidType()
     {
-        static auto sVoidType = mk<BuiltinType>("void");
-        return sVoidType;
+        static BuiltinType sVoidType{"void"};
+        return &sVoidType;
     }
 
     BuiltinType::Ptr builtin::autoType()
     {
-        static auto sVoidType = mk<BuiltinType>("auto");
-        return sVoidType;
+        static BuiltinType sAutoType{"auto"};
+        return &sAutoType;
     }
 
     BuiltinType::Ptr builtin::nullType()
@@ -36,8 +37,8 @@ namespace cstar {
 #undef BUILTIN_CREATE
 
 #define BUILTIN_CREATE(T, ...)                             \
-    static auto s##T##Type = mk<T##Type>(__VA_ARGS__);     \
-    return s##T##Type
+    static T##Type s##T##Type{__VA_ARGS__};                \
+    return &s##T##Type
 
     BuiltinType::Ptr builtin::booleanType()
     {
@@ -60,8 +61,8 @@ namespace cstar {
 #define i true
 
 #define BUILTIN_CREATE(S, N)                                     \
-    static auto s_##S##N##Type = mk<IntegerType>(#S#N, N, S);    \
-    return s_##S##N##Type
+    static IntegerType s_##S##N##Type{#S#N, N, S};               \
+    return &s_##S##N##Type
 
     BuiltinType::Ptr builtin::i8Type()
     {
@@ -108,8 +109,8 @@ namespace cstar {
 #undef BUILTIN_CREATE
 
 #define BUILTIN_CREATE(N)                                      \
-    static auto s_Float##N##Type = mk<FloatType>("f"#N, N);    \
-    return s_Float##N##Type
+    static FloatType s_Float##N##Type{"f"#N, N};               \
+    return &s_Float##N##Type
 
     BuiltinType::Ptr builtin::f32Type()
     {
@@ -124,27 +125,26 @@ namespace cstar {
 
     BuiltinType::Ptr builtin::getBuiltinType(const std::string_view name)
     {
-        static const std::unordered_map<std::string_view, BuiltinType::Ptr> sBuiltins = {
-            {voidType()->name(), voidType()},
-            {autoType()->name(), autoType()},
-            {nullType()->name(), nullType()},
-            {booleanType()->name(), booleanType()},
-            {charType()->name(), charType()},
-            {i8Type()->name(), i8Type()},
-            {u8Type()->name(), u8Type()},
-            {i16Type()->name(), i16Type()},
-            {u16Type()->name(), u16Type()},
-            {i32Type()->name(), i32Type()},
-            {u32Type()->name(), u32Type()},
-            {i64Type()->name(), i64Type()},
-            {u64Type()->name(), u64Type()},
-            {f32Type()->name(), f32Type()},
-            {f64Type()->name(), f64Type()},
-            {stringType()->name(), stringType()}
-        };
-        auto it = sBuiltins.find(name);
-        if (it != sBuiltins.end()) {
-            return it->second;
+        static constexpr auto sBuiltins = makePerfectHash<BuiltinType::Ptr (*)()>({
+            {"void", voidType},
+            {"auto", autoType},
+            {"null", nullType},
+            {"bool", booleanType},
+            {"char", charType},
+            {"i8", i8Type},
+            {"u8", u8Type},
+            {"i16", i16Type},
+            {"u16", u16Type},
+            {"i32", i32Type},
+            {"u32", u32Type},
+            {"i64", i64Type},
+            {"u64", u64Type},
+            {"f32", f32Type},
+            {"f64", f64Type},
+            {"string", stringType}
+        });
+        if (auto create = sBuiltins.find(name)) {
+            return (*create)();
         }
         return nullptr;
     }
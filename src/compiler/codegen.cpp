@@ -11,11 +11,14 @@
 #include "compiler/codegen.hpp"
 
 #include "compiler/ast.hpp"
-#include "compiler/encoding.hpp"
+#include "compiler/constant.hpp"
+
+#include <charconv>
+#include <utility>
 
 namespace cstar {
 
-Codegen::Codegen(std::ostream &os) : _os{os} {}
+Codegen::Codegen(CodeWriter &out) : _out{out} {}
 
 void Codegen::generate(Program &p)
 {
@@ -23,220 +26,284 @@ void Codegen::generate(Program &p)
 
     Nl();
 
-    p.accept(*this);
+    dispatch(p);
 
     Nl();
 }
 
-void Codegen::visit(ContainerNode &node)
+bool Codegen::visit(ContainerNode &node, Step step)
 {
-    for (auto &p : node.all()) {
-        if (p != nullptr)
-            p->accept(*this);
-    }
+    auto children = node.all();
+    return step < children.size() and descend(children[step]);
 }
 
-void Codegen::visit(FunctionDecl &node)
+bool Codegen::visit(FunctionDecl &node, Step step)
 {
-    Tab();
-    Append(node.returnType()->name(), " ", node.name);
-    Append("()");
-    Nl();
-    node.body()->accept(*this);
+    if (step == 0) {
+        Tab();
+        Append(node.returnType()->name(), " ", node.text());
+        Append("()");
+        Nl();
+        return descend(node.body());
+    }
     Nl();
+    return false;
 }
 
-void Codegen::visit(Block &node)
+bool Codegen::visit(Block &node, Step step)
 {
-    Tab();
-    Append('{');
-    _level += 2;
-    for (auto &stmt : node.all()) {
+    auto stmts = node.all();
+    if (step == 0) {
+        Tab();
+        Append('{');
+        _level += 2;
+    }
+    if (step < stmts.size()) {
         Nl();
-        stmt->accept(*this);
+        return descend(stmts[step]);
     }
     _level -= 2;
     Nl();
     Tab();
     Append('}');
+    return false;
 }
 
-void Codegen::visit(ExpressionList &node)
+bool Codegen::visit(ExpressionList &node, Step step)
 {
-    bool first{true};
-    for (auto expr : node.exprs()) {
-        if (!first)
-            Append(", ");
-        expr->accept(*this);
-        first = false;
-    }
+    auto exprs = node.exprs();
+    if (step == exprs.size())
+        return false;
+    if (step != 0)
+        Append(", ");
+    return descend(exprs[step]);
 }
 
-void Codegen::visit(UnaryExpr &node)
+bool Codegen::visit(UnaryExpr &node, Step step)
 {
-    Append(Token::toString(node.op, true));
-    node.operand()->accept(*this);
+    if (step == 0) {
+        Append(Token::toString(node.op, true));
+        return descend(node.operand());
+    }
+    return false;
 }
 
-void Codegen::visit(BinaryExpr &node)
+bool Codegen::visit(BinaryExpr &node, Step step)
 {
-    node.left()->accept(*this);
-    Append(' ', Token::toString(node.op, true), ' ');
-    node.right()->accept(*this);
+    switch (step) {
+    case 0:
+        return descend(node.left());
+    case 1:
+        Append(' ', Token::toString(node.op, true), ' ');
+        return descend(node.right());
+    default:
+        return false;
+    }
 }
 
-void Codegen::visit(GroupingExpr &node)
+bool Codegen::visit(GroupingExpr &node, Step step)
 {
-    Append('(');
-    node.expr()->accept(*this);
+    if (step == 0) {
+        Append('(');
+        return descend(node.expr());
+    }
     Append(')');
+    return false;
 }
 
-void Codegen::visit(VariableExpr &node) { Append(node.name); }
-
-void Codegen::visit(BoolExpr &node) { Append(node.value ? '1' : '0'); }
-
-void Codegen::visit(CharExpr &node) { writeUtf8(_os, node.value); }
+bool Codegen::visit(VariableExpr &node, Step)
+{
+    Append(node.text());
+    return false;
+}
 
-void Codegen::visit(IntegerExpr &node) { Append(node.value); }
+bool Codegen::visit(BoolExpr &node, Step)
+{
+    Append(node.value ? '1' : '0');
+    return false;
+}
 
-void Codegen::visit(FloatExpr &node) { Append(node.value); }
+bool Codegen::visit(CharExpr &node, Step)
+{
+    // characters C cannot quote as they are are written as numbers
+    if (node.value < 0x20 or node.value > 0x7e)
+        Append(node.value);
+    else if (node.value == '\'' or node.value == '\\')
+        Append("'\\", char(node.value), '\'');
+    else
+        Append('\'', char(node.value), '\'');
+    return false;
+}
 
-void Codegen::visit(StringExpr &node) { Append(node.value); }
+bool Codegen::visit(IntegerExpr &node, Step)
+{
+    // folded values of unsigned types are kept in two's complement
+    if (isa<IntegerType>(node.type()) and !isSigned(node.type()))
+        Append(std::uint64_t(node.value), 'u');
+    else
+        Append(node.value);
+    return false;
+}
 
-void Codegen::visit(AssignmentExpr &node)
+bool Codegen::visit(FloatExpr &node, Step)
 {
-    node.assignee()->accept(*this);
-    Append(" = ");
-    node.value()->accept(*this);
+    // folded values are written in full and stay floating point in C
+    char buf[32];
+    auto end = std::to_chars(buf, buf + sizeof(buf), node.value).ptr;
+    std::string_view str{buf, std::size_t(end - buf)};
+    Append(str);
+    if (str.find_first_of(".e") == std::string_view::npos)
+        Append(".0");
+    return false;
 }
 
-void Codegen::visit(CallExpr &node)
+bool Codegen::visit(StringExpr &node, Step)
 {
-    node.callee()->accept(*this);
-    Append('(');
+    Append(node.value);
+    return false;
+}
 
-    if (auto args = node.arguments()) {
-        args->accept(*this);
+bool Codegen::visit(AssignmentExpr &node, Step step)
+{
+    switch (step) {
+    case 0:
+        return descend(node.assignee());
+    case 1:
+        Append(" = ");
+        return descend(node.value());
+    default:
+        return false;
     }
+}
 
-    Append(')');
+bool Codegen::visit(CallExpr &node, Step step)
+{
+    switch (step) {
+    case 0:
+        return descend(node.callee());
+    case 1:
+        Append('(');
+        return descend(node.arguments());
+    default:
+        Append(')');
+        return false;
+    }
 }
 
-void Codegen::visit(DeclarationStmt &node)
+bool Codegen::visit(DeclarationStmt &node, Step step)
 {
-    Tab();
+    if (step == 0) {
+        Tab();
 
-    if (node.flags && gflIsImmutable) {
-        Append("const ");
-    }
+        if (node.flags && gflIsImmutable) {
+            Append("const ");
+        }
 
-    Append(node.type()->name(), ' ');
-    Append(node.name);
-    if (auto value = node.value()) {
-        Append(" = ");
-        value->accept(*this);
+        Append(node.type()->name(), ' ');
+        Append(node.text());
+        if (auto value = node.value()) {
+            Append(" = ");
+            return descend(value);
+        }
     }
     Append(';');
+    return false;
 }
 
-void Codegen::visit(ExpressionStmt &node)
+bool Codegen::visit(ExpressionStmt &node, Step step)
 {
-    Tab();
-    node.expr()->accept(*this);
+    if (step == 0) {
+        Tab();
+        return descend(node.expr());
+    }
     Append(';');
+    return false;
 }
 
-void Codegen::visit(IfStmt &node)
+bool Codegen::visit(IfStmt &node, Step step)
 {
-    Tab();
-    Append("if (");
-    node.condition()->accept(*this);
-    Append(")\n");
-    if (auto stmt = std::dynamic_pointer_cast<ExpressionStmt>(node.then())) {
-        _level += 2;
-        stmt->accept(*this);
-        _level -= 2;
-    }
-    else {
-        node.then()->accept(*this);
-    }
-    if (auto stmt =
-            std::dynamic_pointer_cast<ExpressionStmt>(node.otherwise())) {
-        Append('\n');
+    // expression statements are not blocks, they are indented here
+    switch (step) {
+    case 0:
         Tab();
-        Append("else\n");
-        _level += 2;
-        stmt->accept(*this);
-        _level -= 2;
-    }
-    else if (auto stmt = node.otherwise()) {
-        Append('\n');
-        Tab();
-        Append("else\n");
-        stmt->accept(*this);
+        Append("if (");
+        return descend(node.condition());
+    case 1:
+        Append(")\n");
+        if (isa<ExpressionStmt>(node.then()))
+            _level += 2;
+        return descend(node.then());
+    case 2:
+        if (isa<ExpressionStmt>(node.then()))
+            _level -= 2;
+        if (auto stmt = node.otherwise()) {
+            Append('\n');
+            Tab();
+            Append("else\n");
+            if (isa<ExpressionStmt>(stmt))
+                _level += 2;
+            return descend(stmt);
+        }
+        return false;
+    default:
+        if (isa<ExpressionStmt>(node.otherwise()))
+            _level -= 2;
+        return false;
     }
 }
 
-void Codegen::visit(WhileStmt &node)
+bool Codegen::visit(WhileStmt &node, Step step)
 {
-    Tab();
-    Append("while (");
-    node.condition()->accept(*this);
-    Append(")\n");
-
-    if (auto body = std::dynamic_pointer_cast<ExpressionStmt>(node.body())) {
-        _level += 2;
-        body->accept(*this);
-        _level -= 2;
-    }
-    else if (auto body = node.body()) {
-        body->accept(*this);
-    }
-    else {
+    switch (step) {
+    case 0:
+        Tab();
+        Append("while (");
+        return descend(node.condition());
+    case 1:
+        Append(")\n");
+        if (auto body = node.body()) {
+            if (isa<ExpressionStmt>(body))
+                _level += 2;
+            return descend(body);
+        }
         Append(";");
+        return false;
+    default:
+        if (isa<ExpressionStmt>(node.body()))
+            _level -= 2;
+        return false;
     }
 }
 
-void Codegen::visit(ForStmt &node)
+bool Codegen::visit(ForStmt &node, Step step)
 {
-    Tab();
-    Append("for (");
-    auto tmp = _level;
-    _level = 0;
-
-    if (auto init = node.init()) {
-        init->accept(*this);
-        Append(" ");
-    }
-    else {
+    switch (step) {
+    case 0:
+        Tab();
+        Append("for (");
+        _inlineLevel = std::exchange(_level, 0);
+        return descend(node.init());
+    case 1:
+        Append(node.init() ? " " : "; ");
+        _level = _inlineLevel;
+        return descend(node.condition());
+    case 2:
         Append("; ");
-    }
-
-    _level = tmp;
-
-    if (auto cond = node.condition()) {
-        cond->accept(*this);
-    }
-    Append("; ");
-
-    if (auto update = node.update()) {
-        update->accept(*this);
-    }
-
-    Append(")\n");
-
-    if (auto body = std::dynamic_pointer_cast<ExpressionStmt>(node.body())) {
-        _level += 2;
-        body->accept(*this);
-        _level -= 2;
-    }
-    else if (auto body = node.body()) {
-        body->accept(*this);
-    }
-    else {
+        return descend(node.update());
+    case 3:
+        Append(")\n");
+        if (auto body = node.body()) {
+            if (isa<ExpressionStmt>(body))
+                _level += 2;
+            return descend(body);
+        }
         Append(";");
+        return false;
+    default:
+        if (isa<ExpressionStmt>(node.body()))
+            _level -= 2;
+        return false;
     }
 }
 
-} // namespace cstar
\ No newline at end of file
+} // namespace cstar
@@ -0,0 +1,346 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-14
+ */
+
+#include "compiler/constant.hpp"
+
+#include "compiler/builtin.hpp"
+
+#include <cmath>
+
+namespace cstar {
+
+namespace {
+
+/**
+ * Rounds a number to the precision of the given floating point type
+ */
+double round(double value, Type::Ptr type)
+{
+    return type->size() == 4 ? double(float(value)) : value;
+}
+
+Constant integer(Type::Ptr type, std::int64_t value)
+{
+    Constant result;
+    result.type = type;
+    result.integer = wrap(value, type);
+    result.typed = true;
+    return result;
+}
+
+Constant real(Type::Ptr type, double value)
+{
+    Constant result;
+    result.type = type;
+    result.real = round(value, type);
+    result.typed = true;
+    return result;
+}
+
+/**
+ * Raises an integer to a power by squaring, which wraps like repeated
+ * multiplications do. Exponents below 1 give 1.
+ */
+std::int64_t power(std::int64_t base, std::int64_t exponent, Type::Ptr type)
+{
+    std::uint64_t result = 1, factor = std::uint64_t(base);
+    if (exponent <= 0)
+        return 1;
+    for (auto e = std::uint64_t(exponent); e != 0; e >>= 1) {
+        if (e & 1)
+            result *= factor;
+        factor *= factor;
+    }
+    return wrap(std::int64_t(result), type);
+}
+
+std::optional<Constant> compare(Token::Kind op,
+                                const Constant &a,
+                                const Constant &b)
+{
+    // comparisons involving NaN are false, except for !=
+    int order = 0;
+    if (isFloat(a.type)) {
+        if (std::isnan(a.real) or std::isnan(b.real))
+            return integer(builtin::booleanType(), op == Token::NEQ);
+        order = a.real < b.real ? -1 : a.real > b.real;
+    }
+    else if (isSigned(a.type)) {
+        order = a.integer < b.integer ? -1 : a.integer > b.integer;
+    }
+    else {
+        auto x = std::uint64_t(a.integer), y = std::uint64_t(b.integer);
+        order = x < y ? -1 : x > y;
+    }
+
+    bool result = false;
+    switch (op) {
+    case Token::EQUAL:
+        result = order == 0;
+        break;
+    case Token::NEQ:
+        result = order != 0;
+        break;
+    case Token::LT:
+        result = order < 0;
+        break;
+    case Token::LTE:
+        result = order <= 0;
+        break;
+    case Token::GT:
+        result = order > 0;
+        break;
+    case Token::GTE:
+        result = order >= 0;
+        break;
+    default:
+        return std::nullopt;
+    }
+    return integer(builtin::booleanType(), result);
+}
+
+std::optional<Constant> floating(Token::Kind op,
+                                 const Constant &a,
+                                 const Constant &b)
+{
+    double result = 0;
+    switch (op) {
+    case Token::PLUS:
+        result = a.real + b.real;
+        break;
+    case Token::MINUS:
+        result = a.real - b.real;
+        break;
+    case Token::MULT:
+        result = a.real * b.real;
+        break;
+    case Token::DIV:
+        result = a.real / b.real;
+        break;
+    case Token::EXPONENT:
+        result = std::pow(a.real, b.real);
+        break;
+    default:
+        return std::nullopt;
+    }
+
+    // infinities and NaN have no literal
+    auto value = real(a.type, result);
+    if (!std::isfinite(value.real))
+        return std::nullopt;
+    return value;
+}
+
+std::optional<Constant> integral(Token::Kind op,
+                                 const Constant &a,
+                                 const Constant &b)
+{
+    auto type = a.type;
+    auto x = std::uint64_t(a.integer), y = std::uint64_t(b.integer);
+    switch (op) {
+    case Token::PLUS:
+        return integer(type, std::int64_t(x + y));
+    case Token::MINUS:
+        return integer(type, std::int64_t(x - y));
+    case Token::MULT:
+        return integer(type, std::int64_t(x * y));
+    case Token::BITAND:
+        return integer(type, std::int64_t(x & y));
+    case Token::BITOR:
+        return integer(type, std::int64_t(x | y));
+    case Token::BITXOR:
+        return integer(type, std::int64_t(x ^ y));
+    case Token::EXPONENT: {
+        // the exponent is compared to 0 as a signed number
+        auto exponent =
+            type->size() == 8 ? b.integer : std::int64_t(std::int32_t(y));
+        return integer(type, power(a.integer, exponent, type));
+    }
+    case Token::DIV:
+    case Token::MOD:
+        break;
+    default:
+        return std::nullopt;
+    }
+
+    // divisions by zero trap, as does dividing the smallest signed number
+    // by -1 whose quotient is too big
+    if (y == 0)
+        return std::nullopt;
+    if (isSigned(type)) {
+        auto min = std::int64_t(~std::uint64_t(0) << (type->size() * 8 - 1));
+        if (a.integer == min and b.integer == -1)
+            return std::nullopt;
+        return integer(type,
+                       op == Token::DIV ? a.integer / b.integer
+                                        : a.integer % b.integer);
+    }
+    return integer(type, std::int64_t(op == Token::DIV ? x / y : x % y));
+}
+
+} // namespace
+
+bool isFloat(Type::Ptr type) { return isa<FloatType>(type); }
+
+bool isIntegral(Type::Ptr type)
+{
+    return isa<IntegerType>(type) or isa<BoolType>(type) or
+           isa<CharType>(type);
+}
+
+bool isSigned(Type::Ptr type)
+{
+    auto integer = dyn_cast<IntegerType>(type);
+    return integer != nullptr and integer->isSigned;
+}
+
+Type::Ptr promoted(Type::Ptr type)
+{
+    if (isa<CharType>(type))
+        return builtin::u32Type();
+    if (isIntegral(type) and type->size() < 4)
+        return builtin::i32Type();
+    return type;
+}
+
+Type::Ptr arithmeticType(Type::Ptr lt,
+                         bool lhsLiteral,
+                         Type::Ptr rt,
+                         bool rhsLiteral)
+{
+    if (lhsLiteral and !rhsLiteral and isFloat(lt) <= isFloat(rt))
+        return promoted(rt);
+    if (rhsLiteral and !lhsLiteral and isFloat(rt) <= isFloat(lt))
+        return promoted(lt);
+    if (isFloat(lt) or isFloat(rt))
+        return !isFloat(rt) or (isFloat(lt) and lt->size() > rt->size()) ? lt
+                                                                         : rt;
+
+    lt = promoted(lt);
+    rt = promoted(rt);
+    if (lt->size() != rt->size())
+        return lt->size() > rt->size() ? lt : rt;
+    return isSigned(lt) ? rt : lt;
+}
+
+std::int64_t wrap(std::int64_t value, Type::Ptr type)
+{
+    if (isa<BoolType>(type))
+        return value != 0;
+    const auto bits = unsigned(type->size() * 8);
+    if (bits >= 64)
+        return value;
+    const auto shift = 64 - bits;
+    if (isSigned(type))
+        return std::int64_t(std::uint64_t(value) << shift) >> shift;
+    return std::int64_t(std::uint64_t(value) & (~std::uint64_t(0) >> shift));
+}
+
+std::int64_t truncate(double value, Type::Ptr type)
+{
+    if (!std::isfinite(value))
+        return 0;
+    if (!isSigned(type) and value >= 0x1p63 and value < 0x1p64)
+        return std::int64_t(std::uint64_t(value));
+    if (value <= -0x1p63 or value >= 0x1p63)
+        return 0;
+    return wrap(std::int64_t(value), type);
+}
+
+Constant convert(const Constant &value, Type::Ptr type)
+{
+    auto from = value.type;
+    if (isa<BoolType>(type))
+        return integer(type, value.truthy());
+    if (isFloat(from))
+        return isFloat(type) ? real(type, value.real)
+                             : integer(type, truncate(value.real, type));
+    if (!isFloat(type))
+        return integer(type, value.integer);
+    return real(type,
+                isSigned(from) or from->size() < 8
+                    ? double(value.integer)
+                    : double(std::uint64_t(value.integer)));
+}
+
+std::optional<Constant> evaluate(Token::Kind op, const Constant &operand)
+{
+    if (op == Token::NOT) {
+        auto result = integer(builtin::booleanType(), !operand.truthy());
+        result.typed = operand.typed;
+        return result;
+    }
+
+    auto type = promoted(operand.type);
+    auto result = convert(operand, type);
+    result.typed = operand.typed;
+    switch (op) {
+    case Token::PLUS:
+        break;
+    case Token::MINUS:
+        if (isFloat(type))
+            result.real = -result.real;
+        else
+            result.integer =
+                wrap(std::int64_t(0 - std::uint64_t(result.integer)), type);
+        break;
+    case Token::COMPLEMENT:
+        if (isFloat(type))
+            return std::nullopt;
+        result.integer = wrap(~result.integer, type);
+        break;
+    default:
+        return std::nullopt;
+    }
+    return result;
+}
+
+std::optional<Constant> evaluate(Token::Kind op,
+                                 const Constant &lhs,
+                                 const Constant &rhs)
+{
+    if (op == Token::LAND)
+        return integer(builtin::booleanType(), lhs.truthy() and rhs.truthy());
+    if (op == Token::LOR)
+        return integer(builtin::booleanType(), lhs.truthy() or rhs.truthy());
+
+    if (op == Token::SHL or op == Token::SHR) {
+        // the count is a word, masked to the width of the shifted value
+        auto type = promoted(lhs.type);
+        if (isFloat(type) or isFloat(rhs.type))
+            return std::nullopt;
+        auto a = convert(lhs, type).integer;
+        auto count = convert(rhs, builtin::u32Type()).integer &
+                     std::int64_t(type->size() * 8 - 1);
+        if (op == Token::SHL)
+            return integer(type, std::int64_t(std::uint64_t(a) << count));
+        if (isSigned(type))
+            return integer(type, a >> count);
+        return integer(type, std::int64_t(std::uint64_t(a) >> count));
+    }
+
+    auto type = arithmeticType(lhs.type, !lhs.typed, rhs.type, !rhs.typed);
+    auto a = convert(lhs, type), b = convert(rhs, type);
+    if (auto result = compare(op, a, b))
+        return result;
+    if (!isFloat(type))
+        return integral(op, a, b);
+    if (op != Token::EXPONENT)
+        return floating(op, a, b);
+
+    // powers are computed in double precision
+    auto f64 = builtin::f64Type();
+    auto result = floating(op, convert(a, f64), convert(b, f64));
+    if (!result)
+        return std::nullopt;
+    return convert(*result, type);
+}
+
+} // namespace cstar
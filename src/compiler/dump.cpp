@@ -26,355 +26,490 @@ namespace cstar {
 
 void AstDump::dump(Program &program)
 {
-    program.accept(*this);
+    dispatch(program);
     std::putchar('\n');
 }
 
-void AstDump::visit(Node &node) {}
+bool AstDump::visit(Node &node, Step) { return false; }
 
-void AstDump::visit(ContainerNode &node)
+bool AstDump::visit(ContainerNode &node, Step step)
 {
-    for (auto &e : node.all()) {
-        if (e != nullptr)
-            e->accept(*this);
+    auto children = node.all();
+    if (step != 0)
         std::putchar('\n');
-    }
+    return step < children.size() and descend(children[step]);
 }
 
-void AstDump::visit(Block &node)
+bool AstDump::visit(Block &node, Step step)
 {
-    std::printf("%*c- Block", level, ' ');
-    level += 2;
+    auto children = node.all();
+    if (step == 0) {
+        std::printf("%*c- Block", level, ' ');
+        level += 2;
+    }
 
-    for (auto &child : node.all()) {
+    if (step < children.size()) {
         std::putchar('\n');
-        child->accept(*this);
+        return descend(children[step]);
     }
 
     level -= 2;
+    return false;
 }
 
-void AstDump::visit(FunctionDecl &node)
+bool AstDump::visit(FunctionDecl &node, Step step)
 {
-    csAssert(node.returnType());
-    csAssert(node.body());
-
-    std::printf("%*c- FunctionDecl:\n", level, ' ');
-    level += 2;
-
-    std::printf("%*c- returns: ", level, ' ');
-    node.returnType()->accept(*this);
+    switch (step) {
+    case 0:
+        csAssert(node.returnType());
+        csAssert(node.body());
 
-    std::printf("\n%*c- name: %.*s",
-                level,
-                ' ',
-                int(node.name.size()),
-                node.name.data());
+        std::printf("%*c- FunctionDecl:\n", level, ' ');
+        level += 2;
 
-    if (auto params = node.params()) {
-        std::printf("\n%*c- params:", level, ' ');
+        std::printf("%*c- returns: ", level, ' ');
+        return descend(node.returnType());
+    case 1:
+        std::printf("\n%*c- name: %.*s",
+                    level,
+                    ' ',
+                    int(node.text().size()),
+                    node.text().data());
+
+        if (auto params = node.params()) {
+            std::printf("\n%*c- params:", level, ' ');
+            level += 2;
+            return descend(params);
+        }
+        return true;
+    case 2:
+        if (node.params())
+            level -= 2;
+
+        std::printf("\n%*c- body: \n", level, ' ');
         level += 2;
-        params->accept(*this);
-        level -= 2;
+        return descend(node.body());
+    default:
+        level -= 4;
+        return false;
     }
-
-    std::printf("\n%*c- body: \n", level, ' ');
-    level += 2;
-    node.body()->accept(*this);
-    level -= 4;
 }
 
-void AstDump::visit(BoolType &node) { std::fputs("bool", stdout); }
-
-void AstDump::visit(CharType &node) { std::fputs("char", stdout); }
+bool AstDump::visit(BoolType &node, Step)
+{
+    std::fputs("bool", stdout);
+    return false;
+}
 
-void AstDump::visit(VoidType &node) { std::fputs("void", stdout); }
+bool AstDump::visit(CharType &node, Step)
+{
+    std::fputs("char", stdout);
+    return false;
+}
 
-void AstDump::visit(IntegerType &node)
+bool AstDump::visit(IntegerType &node, Step)
 {
     std::printf("%.*s", int(node.name().size()), node.name().data());
+    return false;
 }
 
-void AstDump::visit(BuiltinType &node)
+bool AstDump::visit(BuiltinType &node, Step)
 {
     std::printf("%.*s", int(node.name().size()), node.name().data());
+    return false;
 }
 
-void AstDump::visit(FloatType &node)
+bool AstDump::visit(FloatType &node, Step)
 {
     std::printf("%.*s", int(node.name().size()), node.name().data());
+    return false;
 }
 
-void AstDump::visit(StringType &node) { std::fputs("string", stdout); }
+bool AstDump::visit(StringType &node, Step)
+{
+    std::fputs("string", stdout);
+    return false;
+}
 
-void AstDump::visit(BoolExpr &node)
+bool AstDump::visit(BoolExpr &node, Step)
 {
     std::printf("%s", node.value ? "true" : "false");
+    return false;
 }
 
-void AstDump::visit(CharExpr &node)
+bool AstDump::visit(CharExpr &node, Step)
 {
     std::putchar('\'');
     writeUtf8(std::cout, node.value);
     std::putchar('\'');
+    return false;
 }
 
-void AstDump::visit(IntegerExpr &node) { std::printf("%" PRId64, node.value); }
+bool AstDump::visit(IntegerExpr &node, Step)
+{
+    std::printf("%" PRId64, node.value);
+    return false;
+}
 
-void AstDump::visit(FloatExpr &node) { std::printf("%g", node.value); }
+bool AstDump::visit(FloatExpr &node, Step)
+{
+    std::printf("%g", node.value);
+    return false;
+}
 
-void AstDump::visit(StringExpr &node)
+bool AstDump::visit(StringExpr &node, Step)
 {
     std::printf("\"%.*s\"", int(node.value.size()), node.value.data());
+    return false;
 }
 
-void AstDump::visit(VariableExpr &node)
+bool AstDump::visit(VariableExpr &node, Step)
 {
-    std::printf("%.*s", int(node.name.size()), node.name.data());
+    std::printf("%.*s", int(node.text().size()), node.text().data());
+    return false;
 }
 
-void AstDump::visit(GroupingExpr &node)
+bool AstDump::visit(GroupingExpr &node, Step step)
 {
-    std::putchar('(');
-    node.expr()->accept(*this);
+    if (step == 0) {
+        std::putchar('(');
+        return descend(node.expr());
+    }
     std::putchar(')');
+    return false;
 }
 
-void AstDump::visit(UnaryExpr &node)
+bool AstDump::visit(UnaryExpr &node, Step step)
 {
-    std::putchar('(');
-    auto op = Token::toString(node.op, true);
-    std::printf("%.*s", int(op.size()), op.data());
-    node.operand()->accept(*this);
+    if (step == 0) {
+        std::putchar('(');
+        auto op = Token::toString(node.op, true);
+        std::printf("%.*s", int(op.size()), op.data());
+        return descend(node.operand());
+    }
     std::putchar(')');
+    return false;
 }
 
-void AstDump::visit(PostfixExpr &node)
+bool AstDump::visit(PostfixExpr &node, Step step)
 {
-    std::putchar('(');
-    node.operand()->accept(*this);
+    if (step == 0) {
+        std::putchar('(');
+        return descend(node.operand());
+    }
     auto op = Token::toString(node.op, true);
     std::printf("%.*s", int(op.size()), op.data());
     std::putchar(')');
+    return false;
 }
 
-void AstDump::visit(PrefixExpr &node)
+bool AstDump::visit(PrefixExpr &node, Step step)
 {
-    std::putchar('(');
-    auto op = Token::toString(node.op, true);
-    std::printf("%.*s", int(op.size()), op.data());
-    node.operand()->accept(*this);
+    if (step == 0) {
+        std::putchar('(');
+        auto op = Token::toString(node.op, true);
+        std::printf("%.*s", int(op.size()), op.data());
+        return descend(node.operand());
+    }
     std::putchar(')');
+    return false;
 }
 
-void AstDump::visit(TernaryExpr &node)
+bool AstDump::visit(TernaryExpr &node, Step step)
 {
-    std::putchar('(');
-    node.condition()->accept(*this);
-    std::fputs("? ", stdout);
-    node.ifTrue()->accept(*this);
-    std::fputs(" : ", stdout);
-    node.ifFalse()->accept(*this);
-    std::putchar(')');
+    switch (step) {
+    case 0:
+        std::putchar('(');
+        return descend(node.condition());
+    case 1:
+        std::fputs("? ", stdout);
+        return descend(node.ifTrue());
+    case 2:
+        std::fputs(" : ", stdout);
+        return descend(node.ifFalse());
+    default:
+        std::putchar(')');
+        return false;
+    }
 }
 
-void AstDump::visit(NullishCoalescingExpr &node)
+bool AstDump::visit(NullishCoalescingExpr &node, Step step)
 {
-    std::putchar('(');
-    node.lhs()->accept(*this);
-    std::fputs("?\? ", stdout);
-    node.rhs()->accept(*this);
-    std::putchar(')');
+    switch (step) {
+    case 0:
+        std::putchar('(');
+        return descend(node.lhs());
+    case 1:
+        std::fputs("?\? ", stdout);
+        return descend(node.rhs());
+    default:
+        std::putchar(')');
+        return false;
+    }
 }
 
-void AstDump::visit(StringExpressionExpr &node)
+bool AstDump::visit(StringExpressionExpr &node, Step step)
 {
-    std::fputs("f\"", stdout);
-    for (auto &part : node.parts()) {
-        std::fputs("${", stdout);
-        part->accept(*this);
+    auto parts = node.parts();
+    if (step == 0)
+        std::fputs("f\"", stdout);
+    else
         std::putchar('}');
+
+    if (step < parts.size()) {
+        std::fputs("${", stdout);
+        return descend(parts[step]);
     }
     std::putchar('"');
+    return false;
 }
 
-void AstDump::visit(BinaryExpr &node)
+bool AstDump::visit(BinaryExpr &node, Step step)
 {
-    std::putchar('(');
-    node.left()->accept(*this);
-    std::putchar(' ');
-
-    auto op = Token::toString(node.op, true);
-    std::printf("%.*s", int(op.size()), op.data());
-
-    std::putchar(' ');
-    node.right()->accept(*this);
-    std::putchar(')');
+    switch (step) {
+    case 0:
+        std::putchar('(');
+        return descend(node.left());
+    case 1: {
+        std::putchar(' ');
+
+        auto op = Token::toString(node.op, true);
+        std::printf("%.*s", int(op.size()), op.data());
+
+        std::putchar(' ');
+        return descend(node.right());
+    }
+    default:
+        std::putchar(')');
+        return false;
+    }
 }
 
-void AstDump::visit(AssignmentExpr &node)
+bool AstDump::visit(AssignmentExpr &node, Step step)
 {
-    std::fputs("AssignmentExpr:\n", stdout);
-    level += 2;
-    std::printf("%*c- lhs: ", level, ' ');
-    node.assignee()->accept(*this);
-    std::printf("\n%*c- rhs: ", level, ' ');
-    node.value()->accept(*this);
-    level -= 2;
+    switch (step) {
+    case 0:
+        std::fputs("AssignmentExpr:\n", stdout);
+        level += 2;
+        std::printf("%*c- lhs: ", level, ' ');
+        return descend(node.assignee());
+    case 1:
+        std::printf("\n%*c- rhs: ", level, ' ');
+        return descend(node.value());
+    default:
+        level -= 2;
+        return false;
+    }
 }
 
-void AstDump::visit(ExpressionList &node)
+bool AstDump::visit(ExpressionList &node, Step step)
 {
-    for (auto expr : node.exprs()) {
+    auto exprs = node.exprs();
+    if (step < exprs.size()) {
         std::printf("\n%*c- ", level, ' ');
-        expr->accept(*this);
+        return descend(exprs[step]);
     }
+    return false;
 }
 
-void AstDump::visit(CallExpr &node)
+bool AstDump::visit(CallExpr &node, Step step)
 {
-    std::fputs("CallExpr:\n", stdout);
-    level += 2;
-    std::printf("%*c- callee: ", level, ' ');
-    node.callee()->accept(*this);
-    std::printf("\n%*c- args: ", level, ' ');
-
-    if (auto args = node.arguments()) {
+    switch (step) {
+    case 0:
+        std::fputs("CallExpr:\n", stdout);
         level += 2;
-        args->accept(*this);
+        std::printf("%*c- callee: ", level, ' ');
+        return descend(node.callee());
+    case 1:
+        std::printf("\n%*c- args: ", level, ' ');
+
+        if (auto args = node.arguments()) {
+            level += 2;
+            return descend(args);
+        }
+        return true;
+    default:
+        if (node.arguments())
+            level -= 2;
+
         level -= 2;
+        return false;
     }
-
-    level -= 2;
 }
 
-void AstDump::visit(cstar::ExpressionStmt &node)
+bool AstDump::visit(cstar::ExpressionStmt &node, Step step)
 {
-    std::printf("%*c- ExpressionSmt: ", level, ' ');
-    node.expr()->accept(*this);
-}
-
-void AstDump::visit(cstar::DeclarationStmt &node)
-{
-    std::printf("%*c- DeclarationStmt:", level, ' ');
-    level += 2;
-    if (node.flags && gflIsImmutable) {
-        std::printf("\n%*c- immutable\n", level, ' ');
-    }
-
-    if (auto tp = node.type()) {
-        std::printf("\n%*c- type: ", level, ' ');
-        tp->accept(*this);
+    if (step == 0) {
+        std::printf("%*c- ExpressionSmt: ", level, ' ');
+        return descend(node.expr());
     }
-
-    std::printf("\n%*c- name: %.*s",
-                level,
-                ' ',
-                int(node.name.size()),
-                node.name.data());
-
-    if (auto val = node.value()) {
-        std::printf("\n%*c- value: ", level, ' ');
-        val->accept(*this);
-    }
-    level -= 2;
+    return false;
 }
 
-void AstDump::visit(cstar::ParameterStmt &node)
+bool AstDump::visit(cstar::DeclarationStmt &node, Step step)
 {
-    std::printf("%*c- ParameterStmt:", level, ' ');
-    level += 2;
-    if (auto tp = node.type()) {
-        std::printf("\n%*c- type: ", level, ' ');
-        tp->accept(*this);
-    }
-
-    std::printf("\n%*c- name: %s%.*s",
-                level,
-                ' ',
-                (node.flags && gflIsVariadic) ? "..." : "",
-                int(node.name.size()),
-                node.name.data());
-
-    if (auto val = node.value()) {
-        std::printf("\n%*c- value: ", level, ' ');
-        val->accept(*this);
+    switch (step) {
+    case 0:
+        std::printf("%*c- DeclarationStmt:", level, ' ');
+        level += 2;
+        if (node.flags && gflIsImmutable) {
+            std::printf("\n%*c- immutable\n", level, ' ');
+        }
+
+        if (auto tp = node.type()) {
+            std::printf("\n%*c- type: ", level, ' ');
+            return descend(tp);
+        }
+        return true;
+    case 1:
+        std::printf("\n%*c- name: %.*s",
+                    level,
+                    ' ',
+                    int(node.text().size()),
+                    node.text().data());
+
+        if (auto val = node.value()) {
+            std::printf("\n%*c- value: ", level, ' ');
+            return descend(val);
+        }
+        return true;
+    default:
+        level -= 2;
+        return false;
     }
-    level -= 2;
 }
 
-void AstDump::visit(IfStmt &node)
+bool AstDump::visit(cstar::ParameterStmt &node, Step step)
 {
-    std::printf("%*c- IfStmt\n", level, ' ');
-    level += 2;
-    std::printf("%*c- cond: ", level, ' ');
-    node.condition()->accept(*this);
-    std::printf("\n%*c- then: \n", level, ' ');
-    level += 2;
-    node.then()->accept(*this);
-    level -= 2;
-    if (auto otherwise = node.otherwise()) {
-        std::printf("\n%*c- else: \n", level, ' ');
+    switch (step) {
+    case 0:
+        std::printf("%*c- ParameterStmt:", level, ' ');
         level += 2;
-        otherwise->accept(*this);
+        if (auto tp = node.type()) {
+            std::printf("\n%*c- type: ", level, ' ');
+            return descend(tp);
+        }
+        return true;
+    case 1:
+        std::printf("\n%*c- name: %s%.*s",
+                    level,
+                    ' ',
+                    (node.flags && gflIsVariadic) ? "..." : "",
+                    int(node.text().size()),
+                    node.text().data());
+
+        if (auto val = node.value()) {
+            std::printf("\n%*c- value: ", level, ' ');
+            return descend(val);
+        }
+        return true;
+    default:
         level -= 2;
+        return false;
     }
-    level -= 2;
 }
 
-void AstDump::visit(WhileStmt &node)
+bool AstDump::visit(IfStmt &node, Step step)
 {
-    std::printf("%*c- WhileStmt:\n", level, ' ');
-    level += 2;
-    std::printf("%*c- cond: ", level, ' ');
-    node.condition()->accept(*this);
-
-    if (auto body = node.body()) {
-        std::printf("\n%*c- body:\n", level, ' ');
+    switch (step) {
+    case 0:
+        std::printf("%*c- IfStmt\n", level, ' ');
         level += 2;
-        body->accept(*this);
+        std::printf("%*c- cond: ", level, ' ');
+        return descend(node.condition());
+    case 1:
+        std::printf("\n%*c- then: \n", level, ' ');
+        level += 2;
+        return descend(node.then());
+    case 2:
+        level -= 2;
+        if (auto otherwise = node.otherwise()) {
+            std::printf("\n%*c- else: \n", level, ' ');
+            level += 2;
+            return descend(otherwise);
+        }
+        return true;
+    default:
+        if (node.otherwise())
+            level -= 2;
         level -= 2;
+        return false;
     }
-    level -= 2;
 }
 
-void AstDump::visit(ForStmt &node)
+bool AstDump::visit(WhileStmt &node, Step step)
 {
-    std::printf("%*c- ForStmt:\n", level, ' ');
-    level += 2;
-    if (auto init = node.init()) {
-        std::printf("%*c init:\n", level, ' ');
+    switch (step) {
+    case 0:
+        std::printf("%*c- WhileStmt:\n", level, ' ');
         level += 2;
-        init->accept(*this);
+        std::printf("%*c- cond: ", level, ' ');
+        return descend(node.condition());
+    case 1:
+        if (auto body = node.body()) {
+            std::printf("\n%*c- body:\n", level, ' ');
+            level += 2;
+            return descend(body);
+        }
+        return true;
+    default:
+        if (node.body())
+            level -= 2;
         level -= 2;
+        return false;
     }
+}
 
-    if (auto cond = node.condition()) {
-        std::printf("\n%*c- cond: ", level, ' ');
-        cond->accept(*this);
-    }
-
-    if (auto update = node.update()) {
-        std::printf("\n%*c- update: ", level, ' ');
-        update->accept(*this);
-    }
-
-    if (auto body = node.body()) {
-        std::printf("\n%*c- body:\n", level, ' ');
+bool AstDump::visit(ForStmt &node, Step step)
+{
+    switch (step) {
+    case 0:
+        std::printf("%*c- ForStmt:\n", level, ' ');
         level += 2;
-        body->accept(*this);
+        if (auto init = node.init()) {
+            std::printf("%*c init:\n", level, ' ');
+            level += 2;
+            return descend(init);
+        }
+        return true;
+    case 1:
+        if (node.init())
+            level -= 2;
+
+        if (auto cond = node.condition()) {
+            std::printf("\n%*c- cond: ", level, ' ');
+            return descend(cond);
+        }
+        return true;
+    case 2:
+        if (auto update = node.update()) {
+            std::printf("\n%*c- update: ", level, ' ');
+            return descend(update);
+        }
+        return true;
+    case 3:
+        if (auto body = node.body()) {
+            std::printf("\n%*c- body:\n", level, ' ');
+            level += 2;
+            return descend(body);
+        }
+        return true;
+    default:
+        if (node.body())
+            level -= 2;
         level -= 2;
+        return false;
     }
-
-    level -= 2;
 }
 
-void AstDump::visit(StatementList &node)
+bool AstDump::visit(StatementList &node, Step step)
 {
-    for (auto stmt : node.stmts()) {
+    auto stmts = node.stmts();
+    if (step < stmts.size()) {
         std::putchar('\n');
-        stmt->accept(*this);
+        return descend(stmts[step]);
     }
+    return false;
 }
 
-} // namespace cstar
\ No newline at end of file
+} // namespace cstar
@@ -0,0 +1,314 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-13
+ */
+
+#include "compiler/elf.hpp"
+
+#include <string>
+
+namespace cstar {
+
+namespace {
+
+constexpr std::uint16_t ET_REL = 1;
+constexpr std::uint16_t EM_X86_64 = 62;
+
+constexpr std::uint32_t SHT_PROGBITS = 1;
+constexpr std::uint32_t SHT_SYMTAB = 2;
+constexpr std::uint32_t SHT_STRTAB = 3;
+constexpr std::uint32_t SHT_RELA = 4;
+
+constexpr std::uint64_t SHF_WRITE = 0x1;
+constexpr std::uint64_t SHF_ALLOC = 0x2;
+constexpr std::uint64_t SHF_EXECINSTR = 0x4;
+constexpr std::uint64_t SHF_INFO_LINK = 0x40;
+
+constexpr std::uint8_t STB_LOCAL = 0;
+constexpr std::uint8_t STB_GLOBAL = 1;
+constexpr std::uint8_t STT_NOTYPE = 0;
+constexpr std::uint8_t STT_OBJECT = 1;
+constexpr std::uint8_t STT_FUNC = 2;
+
+constexpr std::size_t EHDR_SIZE = 64;
+constexpr std::size_t SHDR_SIZE = 64;
+constexpr std::size_t SYM_SIZE = 24;
+constexpr std::size_t RELA_SIZE = 24;
+
+/** the sections of the object, in the order of their headers */
+enum : std::uint16_t {
+    SEC_NULL,
+    SEC_TEXT,
+    SEC_DATA,
+    SEC_RELA_TEXT,
+    SEC_RELA_DATA,
+    SEC_SYMTAB,
+    SEC_STRTAB,
+    SEC_SHSTRTAB,
+    SEC_NOTE,
+    SECTIONS
+};
+
+/**
+ * The names of the sections, each with its offset in the string table.
+ * An empty `.note.GNU-stack` tells the linker the stack is not executable.
+ */
+constexpr char SECTION_NAMES_DATA[] =
+    "\0.text\0.data\0.rela.text\0.rela.data\0.symtab\0.strtab\0.shstrtab\0"
+    ".note.GNU-stack";
+constexpr std::string_view SECTION_NAMES{SECTION_NAMES_DATA,
+                                         sizeof(SECTION_NAMES_DATA)};
+constexpr std::uint32_t SECTION_NAME[SECTIONS] = {
+    0, 1, 7, 13, 24, 35, 43, 51, 61};
+
+std::size_t align(std::size_t offset, std::size_t alignment)
+{
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * Writes an integer of `n` bytes in little-endian order
+ */
+void put(CodeWriter &out, std::uint64_t value, unsigned n)
+{
+    char buf[8];
+    for (unsigned i = 0; i < n; i++, value >>= 8)
+        buf[i] = char(value & 0xFF);
+    out << std::string_view{buf, n};
+}
+
+void pad(CodeWriter &out, std::size_t from, std::size_t to)
+{
+    for (; from < to; from++)
+        out << '\0';
+}
+
+void bytes(CodeWriter &out, const std::vector<std::uint8_t> &data)
+{
+    // sections without data, the vector may not have a buffer
+    if (data.empty())
+        return;
+    out << std::string_view{reinterpret_cast<const char *>(data.data()),
+                            data.size()};
+}
+
+void sectionHeader(CodeWriter &out,
+                   std::uint16_t section,
+                   std::uint32_t type,
+                   std::uint64_t flags,
+                   std::uint64_t offset,
+                   std::uint64_t size,
+                   std::uint32_t link = 0,
+                   std::uint32_t info = 0,
+                   std::uint64_t alignment = 1,
+                   std::uint64_t entrySize = 0)
+{
+    put(out, SECTION_NAME[section], 4);
+    put(out, type, 4);
+    put(out, flags, 8);
+    put(out, 0, 8);
+    put(out, offset, 8);
+    put(out, size, 8);
+    put(out, link, 4);
+    put(out, info, 4);
+    put(out, alignment, 8);
+    put(out, entrySize, 8);
+}
+
+} // namespace
+
+std::uint32_t ElfObject::symbol(std::string_view name)
+{
+    auto [it, added] = _index.emplace(name, std::uint32_t(_symbols.size()));
+    if (added)
+        _symbols.push_back({name});
+    return it->second;
+}
+
+void ElfObject::define(std::uint32_t symbol,
+                       Section section,
+                       std::uint64_t value,
+                       std::uint64_t size,
+                       bool global,
+                       bool function)
+{
+    auto &sym = _symbols[symbol];
+    sym.section = section;
+    sym.value = value;
+    sym.size = size;
+    sym.global = global;
+    sym.function = function;
+}
+
+void ElfObject::relocate(Section section,
+                         std::uint64_t offset,
+                         std::uint32_t symbol,
+                         Relocation type,
+                         std::int64_t addend)
+{
+    auto &relocations =
+        section == Section::Text ? _textRelocations : _dataRelocations;
+    relocations.push_back({offset, symbol, type, addend});
+}
+
+void ElfObject::write(CodeWriter &out) const
+{
+    // local symbols must come before the others in the symbol table, the
+    // first entry is the null symbol
+    std::vector<std::uint32_t> order, index(_symbols.size());
+    std::uint32_t firstGlobal = 1;
+    order.reserve(_symbols.size());
+    for (auto local : {true, false}) {
+        for (std::uint32_t i = 0; i < _symbols.size(); i++) {
+            auto &sym = _symbols[i];
+            auto isLocal = !sym.global and sym.section != Section::Undefined;
+            if (isLocal == local) {
+                index[i] = std::uint32_t(order.size() + 1);
+                order.push_back(i);
+            }
+        }
+        if (local)
+            firstGlobal = std::uint32_t(order.size() + 1);
+    }
+
+    std::string strtab(1, '\0');
+    std::vector<std::uint32_t> names(_symbols.size());
+    for (auto i : order) {
+        names[i] = std::uint32_t(strtab.size());
+        strtab.append(_symbols[i].name);
+        strtab.push_back('\0');
+    }
+
+    const auto symbols = order.size() + 1;
+    const auto textOffset = EHDR_SIZE;
+    const auto dataOffset = align(textOffset + _text.size(), 16);
+    const auto relaTextOffset = align(dataOffset + _data.size(), 8);
+    const auto relaDataOffset =
+        relaTextOffset + _textRelocations.size() * RELA_SIZE;
+    const auto symtabOffset =
+        relaDataOffset + _dataRelocations.size() * RELA_SIZE;
+    const auto strtabOffset = symtabOffset + symbols * SYM_SIZE;
+    const auto shstrtabOffset = strtabOffset + strtab.size();
+    const auto headersOffset = align(shstrtabOffset + SECTION_NAMES.size(), 8);
+
+    // the file header
+    out << std::string_view{"\x7f"
+                            "ELF\x02\x01\x01\0\0\0\0\0\0\0\0\0",
+                            16};
+    put(out, ET_REL, 2);
+    put(out, EM_X86_64, 2);
+    put(out, 1, 4);
+    put(out, 0, 8);
+    put(out, 0, 8);
+    put(out, headersOffset, 8);
+    put(out, 0, 4);
+    put(out, EHDR_SIZE, 2);
+    put(out, 0, 2);
+    put(out, 0, 2);
+    put(out, SHDR_SIZE, 2);
+    put(out, SECTIONS, 2);
+    put(out, SEC_SHSTRTAB, 2);
+
+    bytes(out, _text);
+    pad(out, textOffset + _text.size(), dataOffset);
+    bytes(out, _data);
+    pad(out, dataOffset + _data.size(), relaTextOffset);
+
+    for (auto relocations : {&_textRelocations, &_dataRelocations}) {
+        for (auto &rela : *relocations) {
+            put(out, rela.offset, 8);
+            put(out, (std::uint64_t(index[rela.symbol]) << 32) | rela.type, 8);
+            put(out, std::uint64_t(rela.addend), 8);
+        }
+    }
+
+    pad(out, 0, SYM_SIZE);
+    for (auto i : order) {
+        auto &sym = _symbols[i];
+        auto bind = !sym.global and sym.section != Section::Undefined
+                        ? STB_LOCAL
+                        : STB_GLOBAL;
+        auto type = sym.section == Section::Undefined ? STT_NOTYPE
+                    : sym.function                    ? STT_FUNC
+                                                      : STT_OBJECT;
+        auto section = sym.section == Section::Text   ? SEC_TEXT
+                       : sym.section == Section::Data ? SEC_DATA
+                                                      : SEC_NULL;
+        put(out, names[i], 4);
+        put(out, std::uint8_t(bind << 4 | type), 1);
+        put(out, 0, 1);
+        put(out, section, 2);
+        put(out, sym.value, 8);
+        put(out, sym.size, 8);
+    }
+
+    out << std::string_view{strtab};
+    out << SECTION_NAMES;
+    pad(out, shstrtabOffset + SECTION_NAMES.size(), headersOffset);
+
+    pad(out, 0, SHDR_SIZE);
+    sectionHeader(out,
+                  SEC_TEXT,
+                  SHT_PROGBITS,
+                  SHF_ALLOC | SHF_EXECINSTR,
+                  textOffset,
+                  _text.size(),
+                  0,
+                  0,
+                  16);
+    sectionHeader(out,
+                  SEC_DATA,
+                  SHT_PROGBITS,
+                  SHF_WRITE | SHF_ALLOC,
+                  dataOffset,
+                  _data.size(),
+                  0,
+                  0,
+                  16);
+    sectionHeader(out,
+                  SEC_RELA_TEXT,
+                  SHT_RELA,
+                  SHF_INFO_LINK,
+                  relaTextOffset,
+                  _textRelocations.size() * RELA_SIZE,
+                  SEC_SYMTAB,
+                  SEC_TEXT,
+                  8,
+                  RELA_SIZE);
+    sectionHeader(out,
+                  SEC_RELA_DATA,
+                  SHT_RELA,
+                  SHF_INFO_LINK,
+                  relaDataOffset,
+                  _dataRelocations.size() * RELA_SIZE,
+                  SEC_SYMTAB,
+                  SEC_DATA,
+                  8,
+                  RELA_SIZE);
+    sectionHeader(out,
+                  SEC_SYMTAB,
+                  SHT_SYMTAB,
+                  0,
+                  symtabOffset,
+                  symbols * SYM_SIZE,
+                  SEC_STRTAB,
+                  firstGlobal,
+                  8,
+                  SYM_SIZE);
+    sectionHeader(
+        out, SEC_STRTAB, SHT_STRTAB, 0, strtabOffset, strtab.size());
+    sectionHeader(out,
+                  SEC_SHSTRTAB,
+                  SHT_STRTAB,
+                  0,
+                  shstrtabOffset,
+                  SECTION_NAMES.size());
+    sectionHeader(out, SEC_NOTE, SHT_PROGBITS, 0, headersOffset, 0);
+}
+
+} // namespace cstar
@@ -53,13 +53,13 @@ namespace cstar {
         }
 
         if (sv.size() > len) {
-            L.error(range, "invalid UTF-8 character sequence");
+            L.error(range, Diag::InvalidUtf8Sequence);
             cstar::abortCompiler(L);
         }
 
         for (auto i = 1u; i < len; i++) {
             if ((sv[i] & 0xC0) != 0x80) {
-                L.error(range.sub(i, 1), "invalid UTF-8 continuation byte");
+                L.error(range.sub(i, 1), Diag::InvalidUtf8Continuation);
                 cstar::abortCompiler(L);
             }
         }
@@ -72,7 +72,7 @@ namespace cstar {
             case 4:
                 return {4, ((sv[0] & 0x7) << 18) | ((sv[1] & 0x3F) << 12) | ((sv[2] & 0x3F) << 6) | (sv[3] & 0x3F)};
             default:
-                L.error(range, "invalid UTF-8 sequence");
+                L.error(range, Diag::InvalidUtf8);
                 cstar::abortCompiler(L);
         }
     }
@@ -105,39 +105,53 @@ namespace cstar {
         }
     }
 
-    void writeUtf8(std::ostream& os, Log* L, const Range& range, uint32_t chr)
+    std::uint32_t encodeUtf8(char (&c)[4],
+                             Log* L,
+                             const Range& range,
+                             uint32_t chr)
     {
         if (chr < 0x80) {
-            write(os, uint8_t(chr));
+            c[0] = char(chr);
+            return 1;
         }
         else if (chr < 0x800) {
-            char c[] = {char(0xC0|(chr >> 6)),  char(0x80|(chr &  0x3F)), '\0'};
-            os << c;
+            c[0] = char(0xC0 | (chr >> 6));
+            c[1] = char(0x80 | (chr & 0x3F));
+            return 2;
         }
         else if (chr < 0x10000) {
-            char c[] = {
-                    char(0xE0 | (chr >> 12)),
-                    char(0x80 | ((chr >> 6) & 0x3F)),
-                    char(0x80 | (chr & 0x3F)),
-                    '\0'
-            };
-            os << c;
+            c[0] = char(0xE0 | (chr >> 12));
+            c[1] = char(0x80 | ((chr >> 6) & 0x3F));
+            c[2] = char(0x80 | (chr & 0x3F));
+            return 3;
         }
         else if (chr < 0x200000) {
-            char c[] = {
-                    char(0xF0 | (chr >> 18)),
-                    char(0x80 | ((chr >> 12) & 0x3F)),
-                    char(0x80 | ((chr >> 6) & 0x3F)),
-                    char(0x80 | (chr & 0x3F)),
-                    '\0'
-            };
-            os << c;
+            c[0] = char(0xF0 | (chr >> 18));
+            c[1] = char(0x80 | ((chr >> 12) & 0x3F));
+            c[2] = char(0x80 | ((chr >> 6) & 0x3F));
+            c[3] = char(0x80 | (chr & 0x3F));
+            return 4;
         }
         else if (L) {
-            L->error(range, "invalid UCS character: \\U", chr);
+            L->error(range, Diag::InvalidUcs, chr);
         }
         else {
             csAssert(false, "invalid UCS character");
         }
+        return 0;
+    }
+
+    void writeUtf8(std::ostream& os, Log* L, const Range& range, uint32_t chr)
+    {
+        char c[4];
+        if (auto len = encodeUtf8(c, L, range, chr))
+            os.write(c, len);
+    }
+
+    void writeUtf8(std::string& str, Log* L, const Range& range, uint32_t chr)
+    {
+        char c[4];
+        if (auto len = encodeUtf8(c, L, range, chr))
+            str.append(c, len);
     }
 }
\ No newline at end of file
@@ -0,0 +1,528 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-14
+ */
+
+#include "compiler/fold.hpp"
+
+#include "compiler/builtin.hpp"
+
+#include <cmath>
+
+namespace cstar {
+
+namespace {
+
+/**
+ * @return the value of a literal, literals folded by an earlier pass keep
+ * their type
+ */
+Constant literalValue(Expr &node, Type::Ptr type)
+{
+    Constant result;
+    result.type = type;
+    if (node.type() != builtin::autoType()) {
+        result.type = node.type();
+        result.typed = true;
+    }
+    return result;
+}
+
+Constant integer(Expr &node, Type::Ptr type, std::int64_t value)
+{
+    auto result = literalValue(node, type);
+    result.integer = wrap(value, result.type);
+    return result;
+}
+
+bool isDivision(Token::Kind op) { return op == Token::DIV or op == Token::MOD; }
+
+} // namespace
+
+Folding::Folding(Log &L) : L{L} {}
+
+bool Folding::fold(Program &program)
+{
+    _arena = &program.arena();
+    dispatch(program);
+    csAssert(_results.empty(), "folded values left unused");
+    return !_failed;
+}
+
+void Folding::bind(Strings::Id name,
+                   std::optional<Constant> value,
+                   bool immutable)
+{
+    Binding binding{name, value, immutable};
+    auto [it, inserted] =
+        _bound.try_emplace(binding.name, std::uint32_t(_bindings.size()));
+    if (!inserted) {
+        binding.shadowed = it->second;
+        it->second = std::uint32_t(_bindings.size());
+    }
+    _bindings.push_back(binding);
+}
+
+const Folding::Binding *Folding::lookup(Strings::Id name) const
+{
+    auto it = _bound.find(name);
+    return it == _bound.end() ? nullptr : &_bindings[it->second];
+}
+
+void Folding::leave()
+{
+    // unwinds the bindings of the scope, uncovering the ones they hid
+    for (auto i = _bindings.size(); i > _scopes.back(); i--) {
+        auto &binding = _bindings[i - 1];
+        if (binding.shadowed == NONE)
+            _bound.erase(binding.name);
+        else
+            _bound[binding.name] = binding.shadowed;
+    }
+    _bindings.resize(_scopes.back());
+    _scopes.pop_back();
+}
+
+void Folding::checkAssignable(Expr &assignee)
+{
+    auto variable = dyn_cast<VariableExpr>(&assignee);
+    if (variable == nullptr or _parameters)
+        return;
+    if (auto binding = lookup(variable->name); binding and binding->immutable) {
+        L.error(assignee.range(), Diag::AssignToImmutable, variable->text());
+        _failed = true;
+    }
+}
+
+void Folding::constant(Node &node, const Constant &value)
+{
+    _results.push_back({&node, value});
+}
+
+void Folding::replace(Node &node, Node *replacement)
+{
+    _results.push_back({&node, {}, replacement});
+}
+
+const Constant *Folding::peek(Node *child) const
+{
+    if (child == nullptr or _results.empty())
+        return nullptr;
+    auto &top = _results.back();
+    if (top.node != child or top.replacement != nullptr)
+        return nullptr;
+    return &top.value;
+}
+
+std::optional<Constant> Folding::take(Node *child)
+{
+    auto value = peek(child);
+    if (value == nullptr)
+        return std::nullopt;
+    auto taken = *value;
+    _results.pop_back();
+    return taken;
+}
+
+Node *Folding::result(Node *child)
+{
+    if (child == nullptr or _results.empty() or _results.back().node != child)
+        return child;
+    if (auto replacement = _results.back().replacement) {
+        _results.pop_back();
+        return replacement;
+    }
+    return result(child, take(child));
+}
+
+Node *Folding::result(Node *child, const std::optional<Constant> &value)
+{
+    if (!value or isa<LiteralExpr>(child))
+        return child;
+    auto expr = literal(*value, child->range());
+    return expr ? expr : child;
+}
+
+Expr *Folding::literal(const Constant &value, const Range &range)
+{
+    // untyped values take the type of the literal, there are no literals
+    // of the other types
+    auto type = value.type;
+    Type::Ptr literalType = nullptr;
+    if (isa<BoolType>(type))
+        literalType = builtin::booleanType();
+    else if (isa<CharType>(type))
+        literalType = builtin::charType();
+    else if (isFloat(type))
+        literalType = builtin::f64Type();
+    else
+        literalType = builtin::i64Type();
+    if (!value.typed and type != literalType)
+        return nullptr;
+    if (isFloat(type) and !std::isfinite(value.real))
+        return nullptr;
+
+    Expr *expr = nullptr;
+    if (isa<BoolType>(type))
+        expr = _arena->make<BoolExpr>(value.integer != 0, range);
+    else if (isa<CharType>(type))
+        expr = _arena->make<CharExpr>(std::uint32_t(value.integer), range);
+    else if (isFloat(type))
+        expr = _arena->make<FloatExpr>(value.real, range);
+    else
+        expr = _arena->make<IntegerExpr>(value.integer, range);
+    if (value.typed)
+        expr->type(type);
+    return expr;
+}
+
+bool Folding::children(std::span<Node::Ptr> nodes, Step step)
+{
+    if (step > 0)
+        nodes[step - 1] = result(nodes[step - 1]);
+    return step < nodes.size() and descend(nodes[step]);
+}
+
+bool Folding::visit(Program &node, Step step)
+{
+    return children(node.all(), step);
+}
+
+bool Folding::visit(Block &node, Step step)
+{
+    if (step == 0)
+        enter();
+    if (children(node.all(), step))
+        return true;
+    leave();
+    return false;
+}
+
+bool Folding::visit(StatementList &node, Step step)
+{
+    return children(node.all(), step);
+}
+
+bool Folding::visit(ExpressionList &node, Step step)
+{
+    return children(node.all(), step);
+}
+
+bool Folding::visit(FunctionDecl &node, Step step)
+{
+    switch (step) {
+    case 0:
+        enter();
+        _parameters = true;
+        return descend(node.params());
+    case 1:
+        _parameters = false;
+        return descend(node.body());
+    default:
+        node.body(result(node.body()));
+        leave();
+        return false;
+    }
+}
+
+bool Folding::visit(BoolExpr &node, Step)
+{
+    constant(node, integer(node, builtin::booleanType(), node.value));
+    return false;
+}
+
+bool Folding::visit(CharExpr &node, Step)
+{
+    constant(node, integer(node, builtin::charType(), node.value));
+    return false;
+}
+
+bool Folding::visit(IntegerExpr &node, Step)
+{
+    constant(node, integer(node, builtin::i64Type(), node.value));
+    return false;
+}
+
+bool Folding::visit(FloatExpr &node, Step)
+{
+    auto value = literalValue(node, builtin::f64Type());
+    value.real = node.value;
+    constant(node, value);
+    return false;
+}
+
+bool Folding::visit(VariableExpr &node, Step)
+{
+    // parameter defaults do not see the variables of the function
+    auto binding = _parameters ? nullptr : lookup(node.name);
+    if (binding and binding->value)
+        constant(node, *binding->value);
+    return false;
+}
+
+bool Folding::visit(GroupingExpr &node, Step step)
+{
+    if (step == 0)
+        return descend(node.expr());
+    if (auto value = take(node.expr()))
+        constant(node, *value);
+    return false;
+}
+
+bool Folding::visit(UnaryExpr &node, Step step)
+{
+    if (step == 0)
+        return descend(node.operand());
+
+    auto operand = take(node.operand());
+    if (auto value = operand ? evaluate(node.op, *operand) : std::nullopt) {
+        constant(node, *value);
+        return false;
+    }
+    node.operand(result(node.operand(), operand));
+    return false;
+}
+
+bool Folding::visit(PrefixExpr &node, Step)
+{
+    checkAssignable(*node.operand());
+    return false;
+}
+
+bool Folding::visit(PostfixExpr &node, Step)
+{
+    checkAssignable(*node.operand());
+    return false;
+}
+
+bool Folding::visit(BinaryExpr &node, Step step)
+{
+    const auto logical = node.op == Token::LAND or node.op == Token::LOR;
+    switch (step) {
+    case 0:
+        return descend(node.left());
+    case 1:
+        // the right operand is not evaluated when the left one decides the
+        // result
+        if (auto lhs = peek(node.left());
+            lhs and logical and lhs->truthy() == (node.op == Token::LOR)) {
+            auto value = convert(*take(node.left()), builtin::booleanType());
+            constant(node, value);
+            return false;
+        }
+        return descend(node.right());
+    default:
+        break;
+    }
+
+    auto rhs = take(node.right()), lhs = take(node.left());
+    if (lhs and rhs) {
+        if (auto value = evaluate(node.op, *lhs, *rhs)) {
+            constant(node, *value);
+            return false;
+        }
+
+        auto type =
+            arithmeticType(lhs->type, !lhs->typed, rhs->type, !rhs->typed);
+        if (isDivision(node.op) and !isFloat(type) and
+            !convert(*rhs, type).truthy())
+            L.warning(node.range(), Diag::DivisionByZero);
+    }
+    node.left(result(node.left(), lhs));
+    node.right(result(node.right(), rhs));
+    return false;
+}
+
+bool Folding::visit(AssignmentExpr &node, Step step)
+{
+    if (step == 0) {
+        checkAssignable(*node.assignee());
+        return descend(node.value());
+    }
+    node.value(result(node.value()));
+    return false;
+}
+
+bool Folding::visit(CallExpr &node, Step step)
+{
+    // the callee is the name of a function
+    return step == 0 and descend(node.arguments());
+}
+
+bool Folding::visit(TernaryExpr &node, Step step)
+{
+    switch (step) {
+    case 0:
+        return descend(node.condition());
+    case 1:
+        return descend(node.ifTrue());
+    case 2:
+        return descend(node.ifFalse());
+    default:
+        break;
+    }
+
+    auto otherwise = take(node.ifFalse()), then = take(node.ifTrue());
+    auto cond = take(node.condition());
+    if (cond and then and otherwise) {
+        // the branches are converted to their common type
+        auto type = then->type == otherwise->type
+                        ? then->type
+                        : arithmeticType(then->type,
+                                         !then->typed,
+                                         otherwise->type,
+                                         !otherwise->typed);
+        constant(node, convert(cond->truthy() ? *then : *otherwise, type));
+        return false;
+    }
+
+    node.condition(result(node.condition(), cond));
+    node.ifTrue(result(node.ifTrue(), then));
+    node.ifFalse(result(node.ifFalse(), otherwise));
+    return false;
+}
+
+bool Folding::visit(NullishCoalescingExpr &node, Step step)
+{
+    switch (step) {
+    case 0:
+        return descend(node.lhs());
+    case 1:
+        return descend(node.rhs());
+    default:
+        break;
+    }
+
+    // nothing can be null yet, the value is the left operand
+    node.rhs(result(node.rhs()));
+    if (auto value = take(node.lhs())) {
+        constant(node, *value);
+        return false;
+    }
+    node.lhs(result(node.lhs()));
+    return false;
+}
+
+bool Folding::visit(StringExpressionExpr &node, Step step)
+{
+    return children(node.all().subspan(1), step);
+}
+
+bool Folding::visit(DeclarationStmt &node, Step step)
+{
+    if (step == 0)
+        return descend(node.value());
+
+    auto value = take(node.value());
+    node.value(result(node.value(), value));
+
+    // only immutable variables keep the value they are initialized with
+    const auto immutable = (node.flags & gflIsImmutable) == gflIsImmutable;
+    std::optional<Constant> bound{};
+    auto type = node.type();
+    if (value and type == builtin::autoType())
+        type = value->type;
+    if (value and immutable and (isIntegral(type) or isFloat(type))) {
+        bound = convert(*value, type);
+        if (isFloat(type) and !std::isfinite(bound->real))
+            bound.reset();
+    }
+    bind(node.name, bound, immutable);
+    return false;
+}
+
+bool Folding::visit(ParameterStmt &node, Step step)
+{
+    // parameters are variables that can be assigned
+    if (step == 0)
+        return descend(node.value());
+    node.value(result(node.value()));
+    bind(node.name);
+    return false;
+}
+
+bool Folding::visit(ExpressionStmt &node, Step step)
+{
+    if (step == 0)
+        return descend(node.expr());
+    node.expr(result(node.expr()));
+    return false;
+}
+
+bool Folding::visit(IfStmt &node, Step step)
+{
+    // a constant condition is replaced by a boolean literal, only the
+    // branch it takes is kept
+    switch (step) {
+    case 0:
+        return descend(node.condition());
+    case 1:
+        if (auto cond = take(node.condition())) {
+            node.condition(_arena->make<BoolExpr>(
+                cond->truthy(), node.condition()->range()));
+            return descend(cond->truthy() ? node.then() : node.otherwise());
+        }
+        node.condition(result(node.condition()));
+        return descend(node.then());
+    case 2:
+        if (auto cond = dyn_cast<BoolExpr>(node.condition())) {
+            auto taken = cond->value ? node.then() : node.otherwise();
+            Node *stmt = result(taken);
+            if (stmt == nullptr)
+                stmt = _arena->make<Block>(node.range());
+            replace(node, stmt);
+            return false;
+        }
+        node.then(result(node.then()));
+        return descend(node.otherwise());
+    default:
+        node.otherwise(result(node.otherwise()));
+        return false;
+    }
+}
+
+bool Folding::visit(WhileStmt &node, Step step)
+{
+    if (step == 0)
+        return descend(node.condition());
+    if (step == 1) {
+        auto cond = take(node.condition());
+        if (cond and !cond->truthy()) {
+            replace(node, _arena->make<Block>(node.range()));
+            return false;
+        }
+        node.condition(result(node.condition(), cond));
+        return descend(node.body());
+    }
+    node.body(result(node.body()));
+    return false;
+}
+
+bool Folding::visit(ForStmt &node, Step step)
+{
+    switch (step) {
+    case 0:
+        enter();
+        return descend(node.init());
+    case 1:
+        node.init(result(node.init()));
+        return descend(node.condition());
+    case 2:
+        node.condition(result(node.condition()));
+        return descend(node.body());
+    case 3:
+        node.body(result(node.body()));
+        return descend(node.update());
+    default:
+        node.update(result(node.update()));
+        leave();
+        return false;
+    }
+}
+
+} // namespace cstar
@@ -0,0 +1,55 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-12
+ */
+
+#include "compiler/ir.hpp"
+
+#include "compiler/strings.hpp"
+
+namespace cstar::ir {
+
+std::string_view toString(Op op)
+{
+    switch (op) {
+#define XX(N, S)                                                               \
+    case Op::N:                                                                \
+        return S;
+        IR_OP_LIST(XX)
+#undef XX
+    default:
+        return {};
+    }
+}
+
+void Function::clear()
+{
+    // the vectors keep their memory for the next function
+    symbol = 0;
+    exported = true;
+    returns = false;
+    ret = Cls::W;
+    params.clear();
+    slots.clear();
+    code.clear();
+    callArgs.clear();
+    temps.resize(1);
+    labels = 0;
+}
+
+std::uint32_t Module::symbol(Strings::Id name, bool isFunction)
+{
+    auto [it, added] = _index.emplace(name, std::uint32_t(_symbols.size()));
+    if (added)
+        _symbols.push_back({Strings::get(name), isFunction});
+    else if (isFunction)
+        _symbols[it->second].isFunction = true;
+    return it->second;
+}
+
+} // namespace cstar::ir
@@ -11,11 +11,14 @@
 #include "compiler/lexer.hpp"
 
 #include "compiler/encoding.hpp"
+#include "compiler/phash.hpp"
+#include "compiler/scan.hpp"
 #include "compiler/source.hpp"
 #include "compiler/strings.hpp"
 
 #include <charconv>
-#include <map>
+#include <cstring>
+#include <thread>
 
 namespace {
 inline bool isoct(char c) { return '0' <= c && c <= '7'; }
@@ -30,107 +33,203 @@ bool isValidUcn(uint32_t c)
 
 namespace cstar {
 
-Token Lexer::mkToken(Token::Kind kind, uint32_t start, uint32_t end)
+Range Lexer::range(const Token &tok) const
 {
-    return Token{kind, Range{_src, start, end, _pos}};
+    return Range{_src, tok.start, tok.end()};
 }
 
-Token &Lexer::addToken(Token::Kind kind, Position pos, uint32_t end)
+Token Lexer::mkToken(Token::Kind kind, uint32_t start, uint32_t end)
 {
-    return _tokens.emplace_back(kind, Range{_src, pos, end});
+    return Token{kind, start, end - start};
 }
 
-void Lexer::eatWhile(char c)
+Token &Lexer::addToken(Token::Kind kind, uint32_t pos, uint32_t end)
 {
-    eatWhileFunc([c](char x) { return x == c; });
+    auto length = end - pos;
+    if (length > Token::MAX_LENGTH) {
+        L.error({_src, pos, end}, Diag::TokenTooLong, Token::MAX_LENGTH);
+        length = Token::MAX_LENGTH;
+    }
+    return _tokens.emplace_back(kind, pos, length);
 }
 
-void Lexer::eatUntil(char c)
+void Lexer::eatWhitespace()
 {
-    eatUntilFunc([c](char x) { return x != c; });
+    _idx = scan::whitespace(_src.data(), _idx, _src.size());
 }
 
-void Lexer::eatUntilFunc(std::function<bool(char)> func)
+void Lexer::eatDigits()
 {
-    auto limit = _src.size();
-    while (_idx < limit and !func(_src[_idx])) {
-        if (_src[_idx] == '\n') {
-            _pos.line++;
-            _pos.column = 0;
-        }
-        else {
-            _pos.column++;
-        }
-        _idx++;
-    }
+    _idx = scan::digits(_src.data(), _idx, _src.size());
 }
 
-void Lexer::eatWhileFunc(std::function<bool(char)> func)
+uint32_t Lexer::advance(uint32_t n)
 {
-    auto limit = _src.size();
-    while (_idx < limit and func(_src[_idx])) {
-        if (_src[_idx] == '\n') {
-            _pos.line++;
-            _pos.column = 0;
-        }
-        else {
-            _pos.column++;
-        }
-        _idx++;
-    }
+    auto ret = _idx;
+    _idx = std::min(uint32_t(_src.size()), (_idx + n));
+    return ret;
 }
 
-void Lexer::eatWhitespace()
+bool Lexer::tokenize()
 {
-    eatWhileFunc([](char c) { return isspace(c); });
+    auto limit = uint32_t(_src.size());
+    _tokens.reserve(_tokens.size() + limit / BYTES_PER_TOKEN_ESTIMATE + 1);
+
+    if (!lex(limit)) {
+        return false;
+    }
+    auto pos = _idx == 0 ? 0 : _idx - 1;
+    addToken(Token::EoF, pos, pos);
+    _tokenized = true;
+    return true;
 }
 
-char Lexer::peek(uint32_t n)
+bool Lexer::tokenizeParallel(std::size_t jobs)
 {
-    n += _idx;
-    if (n < _src.size()) {
-        return _src[n];
+    auto size = uint32_t(_src.size());
+    jobs = std::min(jobs, std::size_t(size / MIN_CHUNK_SIZE));
+    if (jobs <= 1 or _idx != 0) {
+        return tokenize();
+    }
+
+    // split the source into chunks that start at the beginning of a line
+    auto code = _src.data();
+    std::vector<uint32_t> bounds{0};
+    for (std::size_t i = 1; i < jobs; i++) {
+        auto target = uint32_t(size * i / jobs);
+        if (target <= bounds.back())
+            continue;
+        auto nl = static_cast<const char *>(
+            std::memchr(code + target, '\n', size - target));
+        if (nl == nullptr)
+            break;
+        auto bound = uint32_t(nl - code) + 1;
+        if (bound < size)
+            bounds.push_back(bound);
+    }
+    bounds.push_back(size);
+
+    struct Chunk {
+        Log log{};
+        std::unique_ptr<Lexer> lexer{};
+        uint32_t end{0};
+        bool ok{false};
+        bool speculated{false};
+    };
+
+    // every chunk is lexed speculatively, assuming that it does not start
+    // inside a comment, a string or a string expression
+    std::vector<Chunk> chunks(bounds.size() - 1);
+    std::vector<std::thread> workers;
+    workers.reserve(chunks.size());
+    for (std::size_t i = 0; i < chunks.size(); i++) {
+        auto &chunk = chunks[i];
+        chunk.end = bounds[i + 1];
+        chunk.log.errorLimit(L.errorLimit());
+        chunk.lexer = std::make_unique<Lexer>(chunk.log, _src, _flags);
+        chunk.lexer->_idx = bounds[i];
+        chunk.lexer->_speculative = true;
+        workers.emplace_back([&chunk] {
+            auto &lexer = *chunk.lexer;
+            lexer._tokens.reserve((chunk.end - lexer._idx) /
+                                  BYTES_PER_TOKEN_ESTIMATE);
+            try {
+                chunk.ok = lexer.lex(chunk.end);
+                chunk.speculated = true;
+            }
+            catch (Speculation &) {
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    // stitch the chunks in order, a chunk's speculation holds if lexing the
+    // chunks before it ended exactly at its start outside of any string
+    // expression, otherwise the chunk is lexed again from where they ended
+    _tokens.reserve(_tokens.size() + size / BYTES_PER_TOKEN_ESTIMATE + 1);
+    for (std::size_t i = 0; i < chunks.size(); i++) {
+        auto &chunk = chunks[i];
+        auto &lexer = *chunk.lexer;
+        if (chunk.speculated and _idx == bounds[i] and !_inStrExpr) {
+            _tokens.insert(
+                _tokens.end(), lexer._tokens.begin(), lexer._tokens.end());
+            _literals.merge(std::move(lexer._literals));
+            L.append(std::move(chunk.log));
+            _idx = lexer._idx;
+            _inStrExpr = lexer._inStrExpr;
+            if (!chunk.ok or L.limitReached())
+                return false;
+        }
+        else if (_idx < chunk.end and !lex(chunk.end)) {
+            return false;
+        }
     }
-    return EOF;
+
+    auto pos = _idx == 0 ? 0 : _idx - 1;
+    addToken(Token::EoF, pos, pos);
+    _tokenized = true;
+    return true;
 }
 
-uint32_t Lexer::advance(uint32_t n)
+bool Lexer::lex(uint32_t limit)
 {
-    auto ret = _idx;
-    _idx = std::min(uint32_t(_src.size()), (_idx + n));
-    for (auto i = ret; i < _idx; i++) {
-        if (_src[i] == '\n') {
-            _pos.column = 0;
-            _pos.line++;
+    auto code = _src.data();
+    while (_idx < limit) {
+        auto c = code[_idx];
+        if (std::isspace(c)) {
+            // whitespace is not skipped past the limit so that lexing can
+            // resume exactly at a chunk boundary
+            _idx = scan::whitespace(code, _idx, limit);
+            continue;
         }
-        else {
-            _pos.column++;
+
+        if (!tokenize(c) or L.limitReached()) {
+            return false;
         }
     }
+    return true;
+}
 
-    return ret;
+void Lexer::fatal()
+{
+    if (_speculative)
+        throw Speculation();
+    abortCompiler(L);
 }
 
-bool Lexer::tokenize()
+Generator<Token> Lexer::stream()
 {
-    auto limit = _src.size();
-    auto &code = _src.contents();
+    if (_tokenized) {
+        for (const auto &tok : _tokens)
+            co_yield tok;
+        co_return;
+    }
 
-    while (_idx < limit) {
+    auto limit = _src.size();
+    auto code = _src.data();
+    auto ok = true;
+    while (ok and _idx < limit) {
         auto c = code[_idx];
         if (std::isspace(c)) {
             eatWhitespace();
             continue;
         }
 
-        if (!tokenize(c)) {
-            return false;
-        }
+        // a single call can add several tokens (e.g a string expression)
+        // or none at all (e.g a skipped comment)
+        ok = tokenize(c) and !L.limitReached();
+        for (const auto &tok : _tokens)
+            co_yield tok;
+        _tokens.clear();
+    }
+
+    if (ok) {
+        auto pos = _idx == 0 ? 0 : _idx - 1;
+        co_yield addToken(Token::EoF, pos, pos);
+        _tokens.clear();
     }
-    auto pos = mark();
-    pos.index = _idx - 1;
-    addToken(Token::EoF, pos, pos.index);
-    return true;
 }
 
 bool Lexer::tokenize(char c)
@@ -199,10 +298,12 @@ bool Lexer::tokenize(char c)
         IF_ELSE('=', Token::COMPASSIGN, Token::COMPLEMENT);
         break;
     case '>':
-        IF_ELSE2('>', '=', Token::SHRASSIGN, Token::SHR, Token::GT);
+        IF('=', Token::GTE)
+        else IF_ELSE2('>', '=', Token::SHRASSIGN, Token::SHR, Token::GT);
         break;
     case '<':
         IF('-', Token::LARROW)
+        else IF('=', Token::LTE)
         else IF_ELSE2('<', '=', Token::SHLASSIGN, Token::SHL, Token::LT);
         break;
     case '=':
@@ -292,7 +393,7 @@ bool Lexer::tokenize(char c)
         tokIdentifier();
         break;
     default:
-        L.error({_src, pos, _idx}, "unknown token");
+        L.error({_src, pos, _idx}, Diag::UnknownToken);
         advance();
         return false;
     }
@@ -336,7 +437,7 @@ uint32_t Lexer::tokEscapedChar()
     case '0' ... '7':
         return tokOctalChar(c);
     default:
-        L.warning({_src, _idx, _idx, _pos}, "unknown escape character: \\", c);
+        L.warning({_src, _idx, _idx}, Diag::UnknownEscape, c);
         advance();
         return c;
     }
@@ -365,9 +466,8 @@ uint32_t Lexer::tokHexChar()
 {
     auto c = peek();
     if (!isxdigit(c)) {
-        L.error({_src, _idx - 1, _idx, _pos},
-                "\\x is not followed by a hexadecimal literal");
-        abortCompiler(L);
+        L.error({_src, _idx - 1, _idx}, Diag::HexEscapeWithoutDigits);
+        fatal();
     }
 
     uint32_t r = 0;
@@ -408,17 +508,16 @@ uint32_t Lexer::tokUniversalChar(uint32_t len)
             r = (r << 4) | (c - 'A' + 10);
             break;
         default: {
-            L.error(
-                {_src, start, _idx, _pos}, "invalid character character: ", c);
-            abortCompiler(L);
+            L.error({_src, start, _idx}, Diag::InvalidUcnDigit, c);
+            fatal();
         }
         }
         advance();
     }
 
     if (!isValidUcn(r)) {
-        L.error({_src, start, _idx, _pos}, "invalid character character");
-        abortCompiler(L);
+        L.error({_src, start, _idx}, Diag::InvalidUcn);
+        fatal();
     }
     return r;
 }
@@ -441,27 +540,39 @@ void Lexer::tokCharacter()
             c = peek();
         }
 
-        chr = readRune(L, {_src, pos.index + 1, _idx, pos.coord}).second;
+        chr = readRune(L, {_src, pos + 1, _idx}).second;
     }
 
     if (peek() != '\'') {
         // unterminated character literal
-        L.error({_src, pos, _idx}, "unterminated character sequence");
+        L.error({_src, pos, _idx}, Diag::UnterminatedChar);
     }
     else {
         advance();
-        addToken(Token::CHAR, pos, _idx)._value = chr;
+        addToken(Token::CHAR, pos, _idx)._value.chr = chr;
     }
 }
 
 void Lexer::tokString()
 {
     auto pos = mark();
-    std::stringstream ss;
+    auto code = _src.data();
+    auto limit = uint32_t(_src.size());
     auto c = peek();
     bool inStrExpr = _inStrExpr;
+    // literals without escapes reference the source directly, the others
+    // are decoded into the scratch buffer starting from the first escape
+    bool escaped = false;
+    uint32_t run = pos, end = pos;
+
+    for (;;) {
+        _idx = scan::stringBreak(code, _idx, limit);
+        end = _idx;
+        c = peek();
+        if (c == EOF) {
+            break;
+        }
 
-    for (; c != EOF; c = peek()) {
         if (c == '"') {
             _inStrExpr = false;
             break;
@@ -478,29 +589,41 @@ void Lexer::tokString()
         }
 
         if (c != '\\') {
-            ss << c;
             continue;
         }
 
+        if (!escaped) {
+            _scratch.clear();
+            escaped = true;
+        }
+        _scratch.append(code + run, end - run);
+
         auto ucn = (cc == 'u' or cc == 'U');
         auto es = _idx;
         auto chr = tokEscapedChar();
         if (ucn) {
-            writeUtf8(ss, &L, {_src, es, _idx, _pos}, chr);
+            writeUtf8(_scratch, &L, {_src, es, _idx}, chr);
         }
         else {
-            writeChar(ss, char(chr));
+            _scratch.push_back(char(chr));
         }
+        run = _idx;
     }
 
     if (!_inStrExpr and c != '"') {
-        L.error({_src, pos, _idx}, "unterminated string literal");
+        L.error({_src, pos, _idx}, Diag::UnterminatedString);
     }
     else {
         advance();
-        if (!inStrExpr or (_idx - pos.index) > 1)
-            addToken(Token::STRING, pos, _idx)._value =
-                Strings::intern(ss.str());
+        if (!inStrExpr or (_idx - pos) > 1) {
+            std::string_view value{code + run, end - run};
+            if (escaped) {
+                _scratch.append(value);
+                value = _literals.copy(_scratch);
+            }
+            addToken(Token::STRING, pos, _idx)._value.str =
+                _literals.make<std::string_view>(value);
+        }
 
         if (inStrExpr && c == '"')
             addToken(Token::RSTREXPR, mark(), _idx);
@@ -517,8 +640,8 @@ void Lexer::tokBinaryNumber()
 
     if (isdigit(c)) {
         auto p = mark();
-        eatWhileFunc(isdigit);
-        L.error({_src, p, _idx}, "invalid digit in a binary number '", c, "'");
+        eatDigits();
+        L.error({_src, p, _idx}, Diag::InvalidBinaryDigit, c);
     }
     else {
         parseInteger(pos, 2);
@@ -551,14 +674,14 @@ void Lexer::tokOctalNumber()
     auto x = peek();
     if (isdigit(x)) {
         // could be a floating point number, try to jump to a '.' or an 'E'
-        for (; isdigit(c); c = peek())
-            advance();
+        eatDigits();
+        c = peek();
 
         if (c == '.' or c == 'e' or c == 'E') {
             tokFloatingPoint(pos);
         }
         else {
-            L.error({_src, pos, _idx}, "'", x, "' is not a valid octal digit");
+            L.error({_src, pos, _idx}, Diag::InvalidOctalDigit, x);
         }
     }
     else {
@@ -569,9 +692,8 @@ void Lexer::tokOctalNumber()
 void Lexer::tokDecimalNumber()
 {
     auto pos = mark();
+    eatDigits();
     auto c = peek();
-    for (; isdigit(c); c = peek())
-        advance();
     auto C = toupper(c);
     if (C == 'E' or c == '.') {
         // this is possibly a floating point number
@@ -582,22 +704,22 @@ void Lexer::tokDecimalNumber()
     }
 }
 
-void Lexer::parseInteger(const Position &start, int base)
+void Lexer::parseInteger(uint32_t start, int base)
 {
     std::uint64_t value{0};
-    auto s = (base == 16 || base == 2) ? _src.at(start.index + 2)
-                                       : _src.at(start.index);
+    auto s = (base == 16 || base == 2) ? _src.at(start + 2)
+                                       : _src.at(start);
 
     auto [_, ec] = std::from_chars(s, _src.at(_idx), value, base);
     if (ec == std::errc::result_out_of_range) {
-        L.error({_src, start, _idx}, "number too big parse");
+        L.error({_src, start, _idx}, Diag::IntegerTooBig);
     }
     else {
-        addToken(Token::INTEGER, start, _idx)._value = value;
+        addToken(Token::INTEGER, start, _idx)._value.integer = value;
     }
 }
 
-void Lexer::tokFloatingPoint(const Position &start)
+void Lexer::tokFloatingPoint(uint32_t start)
 {
     auto c = char(toupper(peek()));
     csAssert(c == '.' || c == 'E' or c == 'P');
@@ -609,22 +731,22 @@ void Lexer::tokFloatingPoint(const Position &start)
             advance();
         }
         if (!isdigit(peek())) {
-            L.error({_src, start, _idx}, "'", c, "' exponent has no digits");
+            L.error({_src, start, _idx}, Diag::ExponentWithoutDigits, c);
             return;
         }
     }
-    eatWhileFunc(isdigit);
+    eatDigits();
 
     double value{0};
     auto [ptr, ec] =
-        std::from_chars(_src.at(start.index), _src.at(_idx), value);
+        std::from_chars(_src.at(start), _src.at(_idx), value);
     if (ec == std::errc::result_out_of_range) {
         L.error({_src, start, _idx},
-                "number too big parse: ",
-                (ptr - _src.at(start.index)));
+                Diag::FloatTooBig,
+                (ptr - _src.at(start)));
     }
     else {
-        addToken(Token::FLOAT, start, _idx)._value = value;
+        addToken(Token::FLOAT, start, _idx)._value.real = value;
     }
 }
 
@@ -654,74 +776,78 @@ void Lexer::tokNumber()
 
 void Lexer::tokIdentifier()
 {
-#define YY(TOK, NAME) {std::string_view{NAME}, cstar::Token::TOK},
-#define ZZ(TOK, NAME, ALIAS) {std::string_view{NAME}, cstar::Token::ALIAS},
+#define YY(TOK, NAME) {NAME, cstar::Token::TOK},
+#define ZZ(TOK, NAME, ALIAS) {NAME, cstar::Token::ALIAS},
 #define XX(_, ___)
-#define BB(TOK, NAME) {std::string_view{NAME}, cstar::Token::TOK},
-    static const std::map<std::string_view, Token::Kind> KeyWords(
-        {TOKEN_LIST(XX, YY, ZZ, BB)});
+#define BB(TOK, NAME) {NAME, cstar::Token::TOK},
+    static constexpr auto KeyWords =
+        makePerfectHash<Token::Kind>({TOKEN_LIST(XX, YY, ZZ, BB)});
 #undef BB
 #undef XX
 #undef ZZ
 #undef YY
     auto pos = mark();
-    auto c = peek();
 
     // consume all letters that can be an identifier
-    for (; (c == '_' or c == '$' or isdigit(c) or std::isalnum(c)); c = peek())
-        advance();
+    _idx = scan::identifier(_src.data(), _idx, _src.size());
 
-    auto range = Range{_src, pos, _idx};
-    auto sv = range.toString();
-    auto it = KeyWords.find(sv);
-    if (it != KeyWords.end()) {
+    auto sv = std::string_view{_src.at(pos), _idx - pos};
+    if (auto kind = KeyWords.find(sv)) {
         // this is a keyword
-        auto &tok = addToken(it->second, pos, _idx);
+        auto &tok = addToken(*kind, pos, _idx);
         if (tok.kind == Token::FALSE or tok.kind == Token::TRUE) {
-            tok._value = tok.kind == Token::TRUE;
+            tok._value.b = tok.kind == Token::TRUE;
         }
     }
     else {
-        // this is an identifier
+        // this is an identifier, interned once here so that later passes
+        // compare names as integers
         auto &tok = addToken(Token::IDENTIFIER, pos, _idx);
-        tok._value = false;
+        tok._value.id = Strings::id(sv);
     }
 }
 
 void Lexer::tokComment()
 {
     auto pos = mark();
+    auto code = _src.data();
+    auto limit = uint32_t(_src.size());
     advance();
-    auto c = peek();
-    auto isMultiLine = c == '*';
+    auto isMultiLine = peek() == '*';
     auto level = 1;
     advance();
 
-    while (c != EOF) {
-        c = peek();
-        advance();
-
-        if (c == '\n' and !isMultiLine) {
-            break;
-        }
-
-        auto cc = peek();
-        if (c == '*' and cc == '/') {
-            advance();
-            if (--level == 0)
+    if (!isMultiLine) {
+        // single line comments include the terminating newline
+        _idx = std::min(scan::lineEnd(code, _idx, limit) + 1, limit);
+    }
+    else {
+        while (_idx < limit) {
+            // jump straight to the next character that can open or
+            // close a nested comment
+            _idx = scan::commentBreak(code, _idx, limit);
+            if (_idx >= limit)
                 break;
+
+            auto c = code[_idx++];
+            auto cc = peek();
+            if (c == '*' and cc == '/') {
+                advance();
+                if (--level == 0)
+                    break;
+            }
+            if (c == '/' and cc == '*')
+                level++;
         }
-        if (c == '/' and cc == '*')
-            level++;
     }
 
     if (isMultiLine && level != 0) {
-        L.error({_src, pos, _idx}, "unterminated multiline comment");
+        L.error({_src, pos, _idx}, Diag::UnterminatedComment);
     }
     else {
         // the token value will indicate whether the comment is multiline or not
         if ((_flags & gflLexerSkipComments) != gflLexerSkipComments)
-            addToken(Token::COMMENT, pos, _idx)._value = isMultiLine;
+            addToken(Token::COMMENT, pos, _idx)._value.b = isMultiLine;
     }
 }
 } // namespace cstar
\ No newline at end of file
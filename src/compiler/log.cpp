@@ -13,19 +13,99 @@
 #include "compiler/ccolor.hpp"
 #include "compiler/source.hpp"
 
+#include <array>
+
 namespace cstar {
 
-    void Log::append(Diagnostic::Kind kind, Range range, std::string msg)
+    namespace {
+        constexpr std::string_view Messages[] = {
+#define XX(_, MSG) MSG,
+            DIAGNOSTIC_LIST(XX)
+#undef XX
+        };
+
+        constexpr std::uint8_t countArgs(std::string_view msg)
+        {
+            std::uint8_t count = 0;
+            for (auto i = msg.find("{}"); i != std::string_view::npos;
+                 i = msg.find("{}", i + 2))
+                count++;
+            return count;
+        }
+
+        constexpr auto ArgCounts = [] {
+            std::array<std::uint8_t, std::size(Messages)> counts{};
+            for (std::size_t i = 0; i < counts.size(); i++)
+                counts[i] = countArgs(Messages[i]);
+            return counts;
+        }();
+
+        std::ostream& print(std::ostream& os, const DiagnosticArg& arg)
+        {
+            switch (arg.kind) {
+                case DiagnosticArg::INTEGER:
+                    return os << arg.integer;
+                case DiagnosticArg::UNSIGNED:
+                    return os << arg.uinteger;
+                case DiagnosticArg::CHAR:
+                    return os << arg.chr;
+                case DiagnosticArg::STRING:
+                    return os << Strings::get(arg.str);
+            }
+            return os;
+        }
+    }
+
+    std::string Diagnostic::message() const
+    {
+        std::stringstream ss;
+        auto msg = Messages[std::size_t(id)];
+        for (auto i = 0u; i < argc; i++) {
+            auto at = msg.find("{}");
+            print(ss << msg.substr(0, at), args[i]);
+            msg.remove_prefix(at + 2);
+        }
+        ss << msg;
+        return ss.str();
+    }
+
+    void Log::add(const Diagnostic& diagnostic)
     {
-        _diagnostics.push_back({kind, range, std::move(msg)});
+        csAssert(diagnostic.argc == ArgCounts[std::size_t(diagnostic.id)],
+                 "wrong number of arguments for diagnostic ",
+                 Messages[std::size_t(diagnostic.id)]);
+        if (limitReached())
+            return;
+
+        if (diagnostic.kind == Diagnostic::ERROR) {
+            // errors cascading from an error are usually reported where
+            // it was
+            auto loc = diagnostic.range.start;
+            if (loc != 0 and loc == _lastError)
+                return;
+            _lastError = loc;
+
+            if (++_errors == _errorLimit) {
+                _diagnostics.push_back(diagnostic);
+                _diagnostics.push_back({Diagnostic::ERROR,
+                                        0,
+                                        Diag::TooManyErrors,
+                                        diagnostic.range});
+                return;
+            }
+        }
+        _diagnostics.push_back(diagnostic);
     }
 
-    bool Log::hasErrors() const
+    void Log::append(Log&& other)
     {
-        for (const auto& d: _diagnostics) {
-            if (d.kind == Diagnostic::ERROR) return true;
+        for (const auto& d: other._diagnostics) {
+            if (d.id != Diag::TooManyErrors)
+                add(d);
         }
-        return false;
+        other._diagnostics.clear();
+        other._errors = 0;
+        other._lastError = 0;
     }
 
     std::string Log::toString() const
@@ -54,28 +134,29 @@ namespace cstar {
         auto diagnostics = L.diagnostics();
         for (auto& diag: diagnostics) {
             auto& range = diag.range;
+            auto position = range.position();
             os  << cc::BOLD
                     << range.source().name() << ':'
-                    << (range.position.line+1) << ':'
-                    << (range.position.column+1) << ": "
+                    << (position.line+1) << ':'
+                    << (position.column+1) << ": "
                 << cc::DEFAULT
                 << (diag.kind == Diagnostic::ERROR? cc::RED : cc::YELLOW)
                     << (diag.kind == Diagnostic::ERROR? "error: " : "warning: ")
                 << cc::BOLD
-                    << diag.message
+                    << diag.message()
                 << cc::DEFAULT
                     << std::endl
                     << range.enclosingLine().toString()
                     << std::endl
-                    << std::string(range.position.column, ' ');
+                    << std::string(position.column, ' ');
 
             if (range.size() <= 1) {
                 os << '^';
             }
             else {
-                auto i = range.start+1;
+                auto text = range.toString();
                 os << '^';
-                while (i < range.end && range.source()[i++] != '\n') {
+                for (auto i = 1u; i < text.size() && text[i] != '\n'; i++) {
                     os << '~';
                 }
             }
@@ -89,24 +170,25 @@ namespace cstar {
 std::ostream& operator<<(std::ostream& os, const cstar::Diagnostic& diagnostic)
 {
     auto& range = diagnostic.range;
+    auto position = range.position();
     os << range.source().name() << ':'
-       << (range.position.line+1) << ':'
-       << (range.position.column+1) << ": ";
+       << (position.line+1) << ':'
+       << (position.column+1) << ": ";
 
     os << (diagnostic.kind == cstar::Diagnostic::ERROR ? "error: " : "warning: ")
-       << diagnostic.message << "\n";
+       << diagnostic.message() << "\n";
 
     auto enclosingLine = range.enclosingLine();
     os << enclosingLine.toString() << "\n";
 
-    auto col = range.position.column;
+    auto col = position.column;
     os << std::string(col, ' ');
     if (range.size() <= 1) {
         os << '^';
     }
     else {
-        auto i = range.start;
-        while (i < range.end && range.source()[i++] != '\n') {
+        auto text = range.toString();
+        for (auto i = 0u; i < text.size() && text[i] != '\n'; i++) {
             os << '~';
         }
     }
@@ -0,0 +1,1203 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-12
+ */
+
+#include "compiler/lower.hpp"
+
+#include "compiler/builtin.hpp"
+#include "compiler/constant.hpp"
+
+#include <optional>
+#include <string>
+
+namespace cstar {
+
+namespace {
+
+using ir::Cls;
+using ir::Op;
+using ir::Ref;
+
+/**
+ * @return true if every value of type `from` is a value of type `to`, in
+ * which case integral conversions do not change the bits of a value
+ */
+bool fits(Type::Ptr from, Type::Ptr to)
+{
+    if (isa<BoolType>(from))
+        return true;
+    if (isSigned(from) == isSigned(to))
+        return from->size() <= to->size();
+    return !isSigned(from) and from->size() < to->size();
+}
+
+/**
+ * @return the type of the data items holding values of the given type
+ */
+char ext(Type::Ptr type)
+{
+    if (isFloat(type))
+        return type->size() == 4 ? 's' : 'd';
+    switch (type->size()) {
+    case 1:
+        return 'b';
+    case 2:
+        return 'h';
+    case 4:
+        return 'w';
+    default:
+        return 'l';
+    }
+}
+
+Op loadOp(Type::Ptr type)
+{
+    if (isFloat(type))
+        return type->size() == 4 ? Op::Loads : Op::Loadd;
+    switch (type->size()) {
+    case 1:
+        return isSigned(type) ? Op::Loadsb : Op::Loadub;
+    case 2:
+        return isSigned(type) ? Op::Loadsh : Op::Loaduh;
+    case 4:
+        return Op::Loadw;
+    default:
+        return Op::Loadl;
+    }
+}
+
+Op storeOp(Type::Ptr type)
+{
+    if (isFloat(type))
+        return type->size() == 4 ? Op::Stores : Op::Stored;
+    switch (type->size()) {
+    case 1:
+        return Op::Storeb;
+    case 2:
+        return Op::Storeh;
+    case 4:
+        return Op::Storew;
+    default:
+        return Op::Storel;
+    }
+}
+
+/**
+ * @return false if the operator is not a comparison
+ */
+bool comparison(Token::Kind kind, Type::Ptr type, Op &op)
+{
+    const auto isUnsigned = !isFloat(type) and !isSigned(type);
+    switch (kind) {
+    case Token::EQUAL:
+        op = Op::Ceq;
+        return true;
+    case Token::NEQ:
+        op = Op::Cne;
+        return true;
+    case Token::LT:
+        op = isFloat(type) ? Op::Clt : isUnsigned ? Op::Cult : Op::Cslt;
+        return true;
+    case Token::LTE:
+        op = isFloat(type) ? Op::Cle : isUnsigned ? Op::Cule : Op::Csle;
+        return true;
+    case Token::GT:
+        op = isFloat(type) ? Op::Cgt : isUnsigned ? Op::Cugt : Op::Csgt;
+        return true;
+    case Token::GTE:
+        op = isFloat(type) ? Op::Cge : isUnsigned ? Op::Cuge : Op::Csge;
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+Lowering::Lowering(Log &L, ir::Backend &backend) : L{L}, _backend{backend}
+{
+}
+
+bool Lowering::lower(Program &p)
+{
+    dispatch(p);
+    if (!_failed)
+        _backend.finish(_module);
+    return !_failed;
+}
+
+bool Lowering::supported(Type::Ptr type)
+{
+    switch (type->kind()) {
+    case NodeKind::BoolType:
+    case NodeKind::CharType:
+    case NodeKind::IntegerType:
+    case NodeKind::FloatType:
+    case NodeKind::StringType:
+        return true;
+    default:
+        return false;
+    }
+}
+
+Cls Lowering::cls(Type::Ptr type)
+{
+    switch (type->kind()) {
+    case NodeKind::BoolType:
+    case NodeKind::CharType:
+        return Cls::W;
+    case NodeKind::IntegerType:
+        return type->size() == 8 ? Cls::L : Cls::W;
+    case NodeKind::FloatType:
+        return type->size() == 8 ? Cls::D : Cls::S;
+    default:
+        return Cls::L;
+    }
+}
+
+Ref Lowering::Variable::address() const
+{
+    return slot != 0 ? Ref::makeTemp(Cls::L, slot) : Ref::makeSymbol(symbol);
+}
+
+void Lowering::unsupported(const Node &node, std::string_view what)
+{
+    L.error(node.range(), Diag::UnsupportedConstruct, what);
+    _failed = true;
+}
+
+Lowering::Value Lowering::pop()
+{
+    csAssert(!_values.empty(), "expression without a value");
+    auto value = _values.back();
+    _values.pop_back();
+    return value;
+}
+
+Lowering::Value Lowering::temp(Type::Ptr type)
+{
+    return {type, _fn.newTemp(cls(type))};
+}
+
+Lowering::Value Lowering::constant(Type::Ptr type, std::int64_t value)
+{
+    if (isFloat(type))
+        return {type, Ref::makeFloat(cls(type), double(value))};
+    return {type,
+            Ref::makeInteger(cls(type),
+                             isIntegral(type) ? wrap(value, type) : value)};
+}
+
+Lowering::Value Lowering::literal(Expr &node,
+                                  Type::Ptr type,
+                                  std::int64_t value)
+{
+    // folded constants keep the type of the expression they replace
+    const auto typed = node.type() != builtin::autoType();
+    auto result = constant(typed ? node.type() : type, value);
+    result.typed = typed;
+    return result;
+}
+
+ir::Instr &Lowering::add(Op op, Cls cls)
+{
+    auto &instr = _fn.code.emplace_back();
+    instr.op = op;
+    instr.cls = cls;
+    return instr;
+}
+
+Lowering::Value Lowering::emit(Type::Ptr type,
+                               Op op,
+                               const Ref &a,
+                               const Ref &b)
+{
+    auto result = temp(type);
+    assign(result, op, a, b);
+    return result;
+}
+
+Lowering::Value Lowering::compare(Op op,
+                                  Type::Ptr type,
+                                  const Ref &a,
+                                  const Ref &b)
+{
+    auto result = temp(builtin::booleanType());
+    auto &instr = add(op, cls(type));
+    instr.dst = result.ref.id;
+    instr.args = {a, b};
+    return result;
+}
+
+void Lowering::assign(const Value &dst, Op op, const Ref &a, const Ref &b)
+{
+    auto &instr = add(op, dst.ref.cls);
+    instr.dst = dst.ref.id;
+    instr.args = {a, b};
+}
+
+void Lowering::startBlock(std::uint32_t id) { add(Op::Label).aux[0] = id; }
+
+void Lowering::jump(std::uint32_t id) { add(Op::Jmp).aux[0] = id; }
+
+void Lowering::branch(const Value &cond,
+                      std::uint32_t then,
+                      std::uint32_t otherwise)
+{
+    // the target of a constant condition is known, the other one is left
+    // unreachable
+    if (cond.kind() == Ref::INTEGER) {
+        jump(cond.ref.integer ? then : otherwise);
+        return;
+    }
+    auto &instr = add(Op::Jnz);
+    instr.args[0] = cond.ref;
+    instr.aux = {then, otherwise};
+}
+
+void Lowering::bind(Variable var)
+{
+    auto [it, inserted] =
+        _bound.try_emplace(var.name, std::uint32_t(_variables.size()));
+    if (!inserted) {
+        var.shadowed = it->second;
+        it->second = std::uint32_t(_variables.size());
+    }
+    _variables.push_back(var);
+}
+
+const Lowering::Variable *Lowering::lookup(Strings::Id name) const
+{
+    auto it = _bound.find(name);
+    return it == _bound.end() ? nullptr : &_variables[it->second];
+}
+
+void Lowering::leave()
+{
+    // unwinds the variables of the scope, uncovering the ones they hid
+    for (auto i = _variables.size(); i > _scopes.back(); i--) {
+        auto &var = _variables[i - 1];
+        if (var.shadowed == NONE)
+            _bound.erase(var.name);
+        else
+            _bound[var.name] = var.shadowed;
+    }
+    _variables.resize(_scopes.back());
+    _scopes.pop_back();
+}
+
+Lowering::Value Lowering::load(const Variable &var)
+{
+    return emit(var.type, loadOp(var.type), var.address());
+}
+
+void Lowering::store(const Variable &var, const Value &value)
+{
+    auto &instr = add(storeOp(var.type), cls(var.type));
+    instr.args = {value.ref, var.address()};
+}
+
+void Lowering::declare(Strings::Id name,
+                       Type::Ptr type,
+                       const Value &init)
+{
+    auto size = std::uint32_t(type->size());
+    Variable var{name, type, _fn.newTemp(Cls::L).id};
+    _fn.slots.push_back({var.slot, size, size > 4 ? 8u : 4u});
+    bind(var);
+    store(var, init);
+}
+
+void Lowering::global(DeclarationStmt &node)
+{
+    auto type = node.type();
+    auto symbol = _module.symbol(node.name);
+    Value value{};
+    if (auto expr = node.value()) {
+        // constant expressions are folded to literals before lowering,
+        // except negated characters and booleans which have no literal
+        auto negate = false;
+        if (auto unary = dyn_cast<UnaryExpr>(expr);
+            unary and (unary->op == Token::MINUS or unary->op == Token::PLUS)) {
+            negate = unary->op == Token::MINUS;
+            expr = unary->operand();
+        }
+        if (!isa<LiteralExpr>(expr) or (negate and isa<StringExpr>(expr))) {
+            // still declared, uses of the variable are not errors
+            L.error(node.range(), Diag::NonConstantGlobal, node.text());
+            _failed = true;
+            if (type == builtin::autoType())
+                type = builtin::i64Type();
+            bind({node.name, type, 0, symbol});
+            return;
+        }
+
+        dispatch(*expr);
+        value = pop();
+        if (negate and value.kind() == Ref::FLOAT)
+            value.ref.real = -value.ref.real;
+        else if (negate)
+            value.ref.integer =
+                std::int64_t(0 - std::uint64_t(value.ref.integer));
+        if (type == builtin::autoType())
+            type = value.type;
+    }
+
+    if (!supported(type)) {
+        L.error(node.range(), Diag::UnsupportedType, type->name());
+        _failed = true;
+        return;
+    }
+
+    // globals are visible to the other objects of the program, as in C
+    bind({node.name, type, 0, symbol});
+    ir::Data data{symbol, true};
+    if (value.kind() == Ref::NONE) {
+        data.items.push_back(
+            {'z', Ref::makeInteger(Cls::L, std::int64_t(type->size()))});
+    }
+    else {
+        data.items.push_back(
+            {ext(type), convert(value, type, node.range()).ref});
+    }
+    _backend.data(_module, data);
+}
+
+Lowering::Value Lowering::convert(const Value &value,
+                                  Type::Ptr type,
+                                  const Range &range)
+{
+    auto from = value.type;
+    if (value.kind() == Ref::NONE) {
+        L.error(range, Diag::VoidValue);
+        _failed = true;
+        return constant(type, 0);
+    }
+    if (from == type)
+        return value;
+    if (isa<BoolType>(type))
+        return condition(value, range);
+    if (isa<StringType>(from) or isa<StringType>(type) or !supported(type)) {
+        L.error(range, Diag::InvalidConversion, from->name(), type->name());
+        _failed = true;
+        return constant(type, 0);
+    }
+
+    // constants are converted here, they are all 64-bit
+    if (value.kind() == Ref::INTEGER) {
+        if (!isFloat(type))
+            return constant(type, value.ref.integer);
+        auto result = constant(type, 0);
+        result.ref.real = isSigned(from) or from->size() < 8
+                              ? double(value.ref.integer)
+                              : double(std::uint64_t(value.ref.integer));
+        return result;
+    }
+    if (value.kind() == Ref::FLOAT) {
+        auto result = constant(type, truncate(value.ref.real, type));
+        if (isFloat(type))
+            result.ref.real = value.ref.real;
+        return result;
+    }
+
+    const auto fc = cls(from), tc = cls(type);
+    if (isFloat(from) and isFloat(type))
+        return emit(type, fc == Cls::S ? Op::Exts : Op::Truncd, value.ref);
+    if (isFloat(type)) {
+        auto op = isSigned(from) ? (fc == Cls::L ? Op::Sltof : Op::Swtof)
+                                 : (fc == Cls::L ? Op::Ultof : Op::Uwtof);
+        return emit(type, op, value.ref);
+    }
+
+    auto result = value;
+    result.type = type;
+    if (isFloat(from)) {
+        auto op = fc == Cls::S ? (isSigned(type) ? Op::Stosi : Op::Stoui)
+                               : (isSigned(type) ? Op::Dtosi : Op::Dtoui);
+        result = emit(type, op, value.ref);
+    }
+    else if (fc == Cls::W and tc == Cls::L) {
+        return emit(type, isSigned(from) ? Op::Extsw : Op::Extuw, value.ref);
+    }
+    else if (fc == Cls::L and tc == Cls::W) {
+        result = emit(type, Op::Copy, value.ref);
+    }
+    else if (fits(from, type)) {
+        return result;
+    }
+
+    // values narrower than a word are kept extended to a whole word
+    if (type->size() == 1)
+        result = emit(type, isSigned(type) ? Op::Extsb : Op::Extub, result.ref);
+    else if (type->size() == 2)
+        result = emit(type, isSigned(type) ? Op::Extsh : Op::Extuh, result.ref);
+    return result;
+}
+
+Lowering::Value Lowering::condition(const Value &value, const Range &range)
+{
+    auto boolean = builtin::booleanType();
+    switch (value.kind()) {
+    case Ref::NONE:
+        L.error(range, Diag::VoidValue);
+        _failed = true;
+        return constant(boolean, 0);
+    case Ref::INTEGER:
+        return constant(boolean, value.ref.integer != 0);
+    case Ref::FLOAT:
+        return constant(boolean, value.ref.real != 0);
+    case Ref::SYMBOL:
+        return constant(boolean, 1);
+    default:
+        break;
+    }
+
+    if (value.type == boolean)
+        return value;
+    auto zero = isFloat(value.type) ? constant(value.type, 0).ref
+                                    : Ref::makeInteger(cls(value.type), 0);
+    return compare(Op::Cne, value.type, value.ref, zero);
+}
+
+Type::Ptr Lowering::common(const Value &lhs, const Value &rhs)
+{
+    // constants that were not folded from typed values have no type in
+    // the source, they take the type of the other operand
+    return arithmeticType(lhs.type,
+                          lhs.kind() != Ref::TEMP and !lhs.typed,
+                          rhs.type,
+                          rhs.kind() != Ref::TEMP and !rhs.typed);
+}
+
+Lowering::Value Lowering::arithmetic(Token::Kind op,
+                                     const Value &lhs,
+                                     const Value &rhs,
+                                     const Range &range)
+{
+    auto lt = lhs.type, rt = rhs.type;
+    if (lhs.kind() == Ref::NONE or rhs.kind() == Ref::NONE) {
+        L.error(range, Diag::VoidValue);
+        _failed = true;
+        return constant(builtin::i32Type(), 0);
+    }
+    if (isa<StringType>(lt) or isa<StringType>(rt)) {
+        L.error(range, Diag::UnsupportedConstruct, "operations on strings");
+        _failed = true;
+        return constant(builtin::i32Type(), 0);
+    }
+
+    auto type = op == Token::SHL or op == Token::SHR ? promoted(lt)
+                                                     : common(lhs, rhs);
+    if (op == Token::EXPONENT)
+        return power(convert(lhs, type, range), convert(rhs, type, range));
+
+    if ((op == Token::SHL or op == Token::SHR) and
+        (isFloat(lt) or isFloat(rt))) {
+        // there are no floating point shifts in QBE
+        L.error(range,
+                Diag::InvalidOperation,
+                Token::toString(op, true),
+                (isFloat(lt) ? lt : rt)->name());
+        _failed = true;
+        return constant(type, 0);
+    }
+
+    auto a = convert(lhs, type, range);
+    if (op == Token::SHL or op == Token::SHR) {
+        // the shift count is a word
+        auto b = convert(rhs, builtin::u32Type(), range);
+        auto shift = op == Token::SHL  ? Op::Shl
+                     : isSigned(type) ? Op::Sar
+                                      : Op::Shr;
+        return emit(type, shift, a.ref, b.ref);
+    }
+
+    auto b = convert(rhs, type, range);
+    if (Op cmp; comparison(op, type, cmp))
+        return compare(cmp, type, a.ref, b.ref);
+
+    std::optional<Op> instr{};
+    switch (op) {
+    case Token::PLUS:
+        instr = Op::Add;
+        break;
+    case Token::MINUS:
+        instr = Op::Sub;
+        break;
+    case Token::MULT:
+        instr = Op::Mul;
+        break;
+    case Token::DIV:
+        instr = isFloat(type) or isSigned(type) ? Op::Div : Op::Udiv;
+        break;
+    case Token::MOD:
+        if (!isFloat(type))
+            instr = isSigned(type) ? Op::Rem : Op::Urem;
+        break;
+    case Token::BITAND:
+        if (!isFloat(type))
+            instr = Op::And;
+        break;
+    case Token::BITOR:
+        if (!isFloat(type))
+            instr = Op::Or;
+        break;
+    case Token::BITXOR:
+        if (!isFloat(type))
+            instr = Op::Xor;
+        break;
+    default:
+        break;
+    }
+
+    if (!instr) {
+        L.error(range,
+                Diag::InvalidOperation,
+                Token::toString(op, true),
+                type->name());
+        _failed = true;
+        return constant(type, 0);
+    }
+    return emit(type, *instr, a.ref, b.ref);
+}
+
+Lowering::Value Lowering::power(const Value &lhs, const Value &rhs)
+{
+    auto type = lhs.type;
+    if (isFloat(type)) {
+        auto f64 = builtin::f64Type();
+        auto result = temp(f64);
+        auto a = convert(lhs, f64, {}), b = convert(rhs, f64, {});
+        static const auto POW = Strings::id("pow");
+        auto &call = add(Op::Call, Cls::D);
+        call.dst = result.ref.id;
+        call.args[0] = Ref::makeSymbol(_module.symbol(POW, true));
+        call.aux = {std::uint32_t(_fn.callArgs.size()), 2};
+        _fn.callArgs.push_back(a.ref);
+        _fn.callArgs.push_back(b.ref);
+        return convert(result, type, {});
+    }
+
+    // multiplies in a loop, an exponent below 1 gives 1
+    const auto c = cls(type);
+    const auto head = label(), body = label(), done = label();
+    auto result = temp(type), exponent = temp(type);
+    assign(result, Op::Copy, Ref::makeInteger(c, 1));
+    assign(exponent, Op::Copy, rhs.ref);
+    jump(head);
+    startBlock(head);
+    auto more =
+        compare(Op::Csgt, type, exponent.ref, Ref::makeInteger(c, 0));
+    branch(more, body, done);
+    startBlock(body);
+    assign(result, Op::Mul, result.ref, lhs.ref);
+    assign(exponent, Op::Sub, exponent.ref, Ref::makeInteger(c, 1));
+    jump(head);
+    startBlock(done);
+    return result;
+}
+
+bool Lowering::visit(Program &node, Step step)
+{
+    auto stmts = node.all();
+    if (step == 0) {
+        // functions can be called before they are defined
+        for (auto stmt : stmts) {
+            if (auto func = dyn_cast<FunctionDecl>(stmt))
+                _functions.emplace(func->name, func);
+        }
+    }
+    if (step == stmts.size())
+        return false;
+
+    auto stmt = stmts[step];
+    if (isa<FunctionDecl>(stmt))
+        return descend(stmt);
+    if (auto decl = dyn_cast<DeclarationStmt>(stmt))
+        global(*decl);
+    else
+        unsupported(*stmt, "statements outside of functions");
+    return true;
+}
+
+bool Lowering::visit(Block &node, Step step)
+{
+    auto stmts = node.all();
+    if (step == 0)
+        enter();
+    if (step < stmts.size())
+        return descend(stmts[step]);
+    leave();
+    return false;
+}
+
+bool Lowering::visit(ExpressionList &node, Step step)
+{
+    auto exprs = node.exprs();
+    return step < exprs.size() and descend(exprs[step]);
+}
+
+bool Lowering::visit(FunctionDecl &node, Step step)
+{
+    auto params = node.params() ? node.params()->all() : std::span<Node::Ptr>{};
+    auto returnType = node.returnType();
+    static const auto MAIN = Strings::id("main");
+    const auto isMain = node.name == MAIN;
+    if (step == 0) {
+        if (_function != nullptr) {
+            unsupported(node, "nested functions");
+            return false;
+        }
+        for (auto param : params) {
+            if ((param->flags & gflIsVariadic) == gflIsVariadic) {
+                unsupported(*param, "variadic functions");
+                return false;
+            }
+            auto type = cast<ParameterStmt>(param)->type();
+            if (!supported(type)) {
+                L.error(param->range(), Diag::UnsupportedType, type->name());
+                _failed = true;
+                return false;
+            }
+        }
+
+        _function = &node;
+        _fn.clear();
+        _fn.symbol = _module.symbol(node.name, true);
+        startBlock(label());
+        enter();
+
+        // the parameters are the first temporaries, they are copied to
+        // slots so that they can be assigned
+        for (auto param : params) {
+            auto c = cls(cast<ParameterStmt>(param)->type());
+            _fn.params.push_back(c);
+            _fn.newTemp(c);
+        }
+        std::uint32_t id = 1;
+        for (auto param : params) {
+            auto type = cast<ParameterStmt>(param)->type();
+            declare(cast<ParameterStmt>(param)->name,
+                    type,
+                    {type, Ref::makeTemp(cls(type), id++)});
+        }
+        return descend(node.body());
+    }
+
+    // there is no return statement yet, main returns 0 like it does in C
+    auto &ret = add(Op::Ret);
+    if (returnType != builtin::voidType()) {
+        _fn.returns = true;
+        _fn.ret = cls(returnType);
+        ret.args[0] = constant(returnType, 0).ref;
+    }
+    else if (isMain) {
+        _fn.returns = true;
+        ret.args[0] = Ref::makeInteger(Cls::W, 0);
+    }
+    _backend.function(_module, _fn);
+
+    leave();
+    _function = nullptr;
+    return false;
+}
+
+bool Lowering::visit(BoolExpr &node, Step)
+{
+    push(literal(node, builtin::booleanType(), node.value));
+    return false;
+}
+
+bool Lowering::visit(CharExpr &node, Step)
+{
+    push(literal(node, builtin::charType(), node.value));
+    return false;
+}
+
+bool Lowering::visit(IntegerExpr &node, Step)
+{
+    push(literal(node, builtin::i64Type(), node.value));
+    return false;
+}
+
+bool Lowering::visit(FloatExpr &node, Step)
+{
+    auto value = literal(node, builtin::f64Type(), 0);
+    value.ref.real = node.value;
+    push(value);
+    return false;
+}
+
+bool Lowering::visit(StringExpr &node, Step)
+{
+    auto name = ".Lstr." + std::to_string(_nextString++);
+    ir::Data data{_module.symbol(Strings::id(name)), false};
+    if (!node.value.empty())
+        data.items.push_back({'b', {}, node.value});
+    data.items.push_back({'b', Ref::makeInteger(Cls::W, 0)});
+    _backend.data(_module, data);
+    push({builtin::stringType(), Ref::makeSymbol(data.symbol)});
+    return false;
+}
+
+bool Lowering::visit(VariableExpr &node, Step)
+{
+    if (auto var = lookup(node.name)) {
+        push(load(*var));
+    }
+    else {
+        L.error(node.range(), Diag::UndefinedVariable, node.text());
+        _failed = true;
+        push(constant(builtin::i32Type(), 0));
+    }
+    return false;
+}
+
+bool Lowering::visit(GroupingExpr &node, Step step)
+{
+    return step == 0 and descend(node.expr());
+}
+
+bool Lowering::visit(UnaryExpr &node, Step step)
+{
+    if (step == 0)
+        return descend(node.operand());
+
+    auto value = pop();
+    const auto &range = node.range();
+    const auto typed = value.typed;
+    auto type = value.type;
+    if (node.op == Token::NOT) {
+        auto cond = condition(value, range);
+        if (cond.kind() == Ref::INTEGER) {
+            cond = constant(cond.type, !cond.ref.integer);
+            cond.typed = typed;
+            push(cond);
+        }
+        else
+            push(compare(
+                Op::Ceq, cond.type, cond.ref, Ref::makeInteger(Cls::W, 0)));
+        return false;
+    }
+    if (value.kind() == Ref::NONE or isa<StringType>(type)) {
+        L.error(range,
+                Diag::InvalidOperation,
+                Token::toString(node.op, true),
+                value.kind() == Ref::NONE ? "void" : type->name());
+        _failed = true;
+        push(constant(builtin::i32Type(), 0));
+        return false;
+    }
+
+    type = promoted(type);
+    value = convert(value, type, range);
+    switch (node.op) {
+    case Token::MINUS:
+        if (value.kind() == Ref::FLOAT)
+            value.ref.real = -value.ref.real;
+        else if (value.kind() == Ref::INTEGER)
+            value = constant(
+                type, std::int64_t(0 - std::uint64_t(value.ref.integer)));
+        else
+            value = emit(type, Op::Neg, value.ref);
+        break;
+    case Token::COMPLEMENT:
+        if (isFloat(type)) {
+            L.error(range, Diag::InvalidOperation, "~", type->name());
+            _failed = true;
+        }
+        else if (value.kind() == Ref::INTEGER) {
+            value = constant(type, ~value.ref.integer);
+        }
+        else {
+            value =
+                emit(type, Op::Xor, value.ref, Ref::makeInteger(cls(type), -1));
+        }
+        break;
+    default:
+        break;
+    }
+    value.typed = typed;
+    push(value);
+    return false;
+}
+
+Lowering::Value Lowering::increment(Expr &operand,
+                                    Token::Kind op,
+                                    bool prefix)
+{
+    auto variable = dyn_cast<VariableExpr>(&operand);
+    auto var = variable ? lookup(variable->name) : nullptr;
+    if (var == nullptr or isa<StringType>(var->type)) {
+        unsupported(operand, var ? "incrementing strings" : "this operand");
+        return constant(builtin::i32Type(), 0);
+    }
+
+    auto type = promoted(var->type);
+    auto old = load(*var);
+    auto updated = emit(type,
+                        op == Token::PLUSPLUS ? Op::Add : Op::Sub,
+                        convert(old, type, operand.range()).ref,
+                        constant(type, 1).ref);
+    updated = convert(updated, var->type, operand.range());
+    store(*var, updated);
+    return prefix ? updated : old;
+}
+
+bool Lowering::visit(PrefixExpr &node, Step)
+{
+    push(increment(*node.operand(), node.op, true));
+    return false;
+}
+
+bool Lowering::visit(PostfixExpr &node, Step)
+{
+    push(increment(*node.operand(), node.op, false));
+    return false;
+}
+
+bool Lowering::visit(BinaryExpr &node, Step step)
+{
+    const auto logical = node.op == Token::LAND or node.op == Token::LOR;
+    switch (step) {
+    case 0:
+        return descend(node.left());
+    case 1:
+        if (logical) {
+            // the right operand is only evaluated if the left one does
+            // not decide the result, which is assigned on both paths
+            auto boolean = builtin::booleanType();
+            auto left = condition(pop(), node.left()->range());
+            const auto right = label(), done = label();
+            auto result = temp(boolean);
+            assign(result,
+                   Op::Copy,
+                   constant(boolean, node.op == Token::LOR).ref);
+            _labels.push_back(right);
+            _results.push_back(result);
+            if (node.op == Token::LAND)
+                branch(left, right, done);
+            else
+                branch(left, done, right);
+            startBlock(right);
+        }
+        return descend(node.right());
+    default:
+        break;
+    }
+
+    auto rhs = pop();
+    if (!logical) {
+        auto lhs = pop();
+        push(arithmetic(node.op, lhs, rhs, node.range()));
+        return false;
+    }
+
+    auto right = condition(rhs, node.right()->range());
+    auto result = _results.back();
+    _results.pop_back();
+    const auto done = _labels.back() + 1;
+    _labels.pop_back();
+    assign(result, Op::Copy, right.ref);
+    jump(done);
+    startBlock(done);
+    push(result);
+    return false;
+}
+
+bool Lowering::visit(AssignmentExpr &node, Step step)
+{
+    auto variable = dyn_cast<VariableExpr>(node.assignee());
+    auto var = variable ? lookup(variable->name) : nullptr;
+    if (step == 0) {
+        if (var == nullptr) {
+            unsupported(*node.assignee(), "assigning to this expression");
+            push(constant(builtin::i32Type(), 0));
+            return false;
+        }
+        return descend(node.value());
+    }
+
+    auto value = convert(pop(), var->type, node.value()->range());
+    store(*var, value);
+    push(value);
+    return false;
+}
+
+bool Lowering::visit(CallExpr &node, Step step)
+{
+    auto callee = dyn_cast<VariableExpr>(node.callee());
+    auto it = callee ? _functions.find(callee->name) : _functions.end();
+    if (step == 0) {
+        if (callee == nullptr or lookup(callee->name) or
+            it == _functions.end()) {
+            unsupported(*node.callee(), "calling this expression");
+            push(constant(builtin::i32Type(), 0));
+            return false;
+        }
+        return descend(node.arguments());
+    }
+
+    auto &func = *it->second;
+    auto args = node.arguments() ? node.arguments()->exprs().size() : 0;
+    auto params =
+        func.params() ? func.params()->all() : std::span<Node::Ptr>{};
+
+    // missing arguments take the default value of their parameter
+    if (args + step - 1 < params.size()) {
+        auto param = cast<ParameterStmt>(params[args + step - 1]);
+        if (param->value() == nullptr) {
+            L.error(node.range(), Diag::ArgumentCount, func.text());
+            _failed = true;
+            push(constant(param->type(), 0));
+            return true;
+        }
+        return descend(param->value());
+    }
+
+    auto count = std::max(args, params.size());
+    if (args > params.size()) {
+        L.error(node.range(), Diag::ArgumentCount, func.text());
+        _failed = true;
+    }
+
+    // convert the arguments to the type of their parameter before the
+    // call is added
+    auto first = _values.size() - count;
+    for (std::size_t i = 0; i < params.size(); i++) {
+        auto &value = _values[first + i];
+        value = convert(value,
+                        cast<ParameterStmt>(params[i])->type(),
+                        node.range());
+    }
+
+    Value result{};
+    auto returnType = func.returnType();
+    if (returnType != builtin::voidType())
+        result = temp(returnType);
+    auto &call = add(Op::Call, result.ref.cls);
+    call.dst = result.ref.id;
+    call.args[0] = Ref::makeSymbol(_module.symbol(func.name, true));
+    call.aux = {std::uint32_t(_fn.callArgs.size()),
+                std::uint32_t(params.size())};
+    for (std::size_t i = 0; i < params.size(); i++)
+        _fn.callArgs.push_back(_values[first + i].ref);
+
+    _values.resize(first);
+    push(result);
+    return false;
+}
+
+bool Lowering::visit(TernaryExpr &node, Step step)
+{
+    // each branch converts its value to the type of the result in a block
+    // of its own, the true one is added after the false branch once the
+    // type is known
+    switch (step) {
+    case 0:
+        return descend(node.condition());
+    case 1: {
+        auto cond = condition(pop(), node.condition()->range());
+        const auto then = label();
+        label(), label(), label();
+        _labels.push_back(then);
+        branch(cond, then, then + 1);
+        startBlock(then);
+        return descend(node.ifTrue());
+    }
+    case 2:
+        jump(_labels.back() + 2);
+        startBlock(_labels.back() + 1);
+        return descend(node.ifFalse());
+    default:
+        break;
+    }
+
+    auto otherwise = pop(), then = pop();
+    const auto first = _labels.back(), done = first + 3;
+    _labels.pop_back();
+
+    Type::Ptr type = nullptr;
+    if (then.kind() == Ref::NONE or otherwise.kind() == Ref::NONE) {
+        if (then.kind() != otherwise.kind()) {
+            L.error(node.range(), Diag::VoidValue);
+            _failed = true;
+        }
+    }
+    else if (then.type == otherwise.type) {
+        type = then.type;
+    }
+    else if (isa<StringType>(then.type) or isa<StringType>(otherwise.type)) {
+        L.error(node.ifFalse()->range(),
+                Diag::InvalidConversion,
+                otherwise.type->name(),
+                then.type->name());
+        _failed = true;
+    }
+    else {
+        type = common(then, otherwise);
+    }
+
+    if (type == nullptr) {
+        jump(first + 2);
+        startBlock(first + 2);
+        startBlock(done);
+        push({});
+        return false;
+    }
+
+    otherwise = convert(otherwise, type, node.ifFalse()->range());
+    auto result = temp(type);
+    assign(result, Op::Copy, otherwise.ref);
+    jump(done);
+    startBlock(first + 2);
+    then = convert(then, type, node.ifTrue()->range());
+    assign(result, Op::Copy, then.ref);
+    jump(done);
+    startBlock(done);
+    push(result);
+    return false;
+}
+
+bool Lowering::visit(NullishCoalescingExpr &node, Step step)
+{
+    // nothing can be null yet, the right operand is never needed
+    return step == 0 and descend(node.lhs());
+}
+
+bool Lowering::visit(StringExpressionExpr &node, Step)
+{
+    unsupported(node, "string expressions");
+    push(constant(builtin::stringType(), 0));
+    return false;
+}
+
+bool Lowering::visit(DeclarationStmt &node, Step step)
+{
+    if (step == 0 and node.value())
+        return descend(node.value());
+
+    auto type = node.type();
+    Value value{};
+    if (node.value()) {
+        value = pop();
+        if (type == builtin::autoType())
+            type = value.kind() == Ref::NONE ? builtin::i32Type() : value.type;
+    }
+    if (!supported(type)) {
+        L.error(node.range(), Diag::UnsupportedType, type->name());
+        _failed = true;
+        type = builtin::i32Type();
+    }
+
+    // variables without a value are zero initialized
+    if (value.kind() == Ref::NONE and node.value() == nullptr)
+        value = constant(type, 0);
+    declare(node.name, type, convert(value, type, node.range()));
+    return false;
+}
+
+bool Lowering::visit(ExpressionStmt &node, Step step)
+{
+    if (step == 0)
+        return descend(node.expr());
+    pop();
+    return false;
+}
+
+bool Lowering::visit(IfStmt &node, Step step)
+{
+    // the labels of a statement are consecutive, only the first one is
+    // kept while the statement is lowered
+    switch (step) {
+    case 0:
+        return descend(node.condition());
+    case 1: {
+        auto cond = condition(pop(), node.condition()->range());
+        const auto then = label(), otherwise = label(), done = label();
+        _labels.push_back(then);
+        branch(cond, then, node.otherwise() ? otherwise : done);
+        startBlock(then);
+        return descend(node.then());
+    }
+    case 2:
+        if (node.otherwise()) {
+            jump(_labels.back() + 2);
+            startBlock(_labels.back() + 1);
+            return descend(node.otherwise());
+        }
+        [[fallthrough]];
+    default:
+        startBlock(_labels.back() + 2);
+        _labels.pop_back();
+        return false;
+    }
+}
+
+bool Lowering::visit(WhileStmt &node, Step step)
+{
+    switch (step) {
+    case 0: {
+        const auto head = label();
+        label(), label();
+        _labels.push_back(head);
+        jump(head);
+        startBlock(head);
+        return descend(node.condition());
+    }
+    case 1: {
+        const auto head = _labels.back();
+        auto cond = condition(pop(), node.condition()->range());
+        branch(cond, head + 1, head + 2);
+        startBlock(head + 1);
+        return descend(node.body());
+    }
+    default:
+        jump(_labels.back());
+        startBlock(_labels.back() + 2);
+        _labels.pop_back();
+        return false;
+    }
+}
+
+bool Lowering::visit(ForStmt &node, Step step)
+{
+    switch (step) {
+    case 0:
+        enter();
+        return descend(node.init());
+    case 1: {
+        const auto head = label();
+        label(), label();
+        _labels.push_back(head);
+        jump(head);
+        startBlock(head);
+        return descend(node.condition());
+    }
+    case 2: {
+        const auto head = _labels.back();
+        if (auto expr = node.condition())
+            branch(condition(pop(), expr->range()), head + 1, head + 2);
+        startBlock(head + 1);
+        return descend(node.body());
+    }
+    case 3:
+        return descend(node.update());
+    default:
+        if (node.update())
+            pop();
+        jump(_labels.back());
+        startBlock(_labels.back() + 2);
+        _labels.pop_back();
+        leave();
+        return false;
+    }
+}
+
+} // namespace cstar
@@ -3,18 +3,294 @@
  *
  * This library is free software; you can redistribute it and/or modify it
  * under the terms of the MIT license. See LICENSE for details.
- * 
+ *
  * @author Carter
  * @date 2022-04-29
  */
 
-#include "compiler/source.hpp"
+#include "compiler/codegen.hpp"
+#include "compiler/fold.hpp"
 #include "compiler/lexer.hpp"
+#include "compiler/lower.hpp"
+#include "compiler/parser.hpp"
+#include "compiler/qbe.hpp"
+#include "compiler/source.hpp"
+#include "compiler/symbol.hpp"
+#include "compiler/x86.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+#ifndef CSTAR_QBE_EXECUTABLE
+#define CSTAR_QBE_EXECUTABLE "qbe"
+#endif
+
+#ifndef CSTAR_BACKEND
+#define CSTAR_BACKEND "native"
+#endif
 
 using namespace cstar;
 
+namespace {
+
+enum class Emit { C, Qbe, Object, Executable };
+
+/** how objects and executables are compiled */
+enum class Backend { Native, Qbe };
+
+struct Options {
+    Emit emit{Emit::Executable};
+    Backend backend{std::string_view{CSTAR_BACKEND} == "qbe" ? Backend::Qbe
+                                                             : Backend::Native};
+    const char *input{nullptr};
+    const char *output{nullptr};
+    /** the number of threads lexing large sources */
+    std::size_t jobs{1};
+    /** the number of errors after which compilation stops, 0 for none */
+    std::uint32_t errorLimit{20};
+};
+
+int usage(const char *program)
+{
+    std::fprintf(stderr,
+                 "usage: %s [--emit-c | --emit-qbe | -c] [--backend=name]\n"
+                 "          [-j jobs] [--error-limit n] [-o output] file\n"
+                 "  --emit-c     write the generated C code\n"
+                 "  --emit-qbe   write the generated QBE IL\n"
+                 "  -c           compile to an object file without linking\n"
+                 "  --backend    native to write objects directly, qbe to\n"
+                 "               compile them with qbe, %s by default\n"
+                 "  -j jobs      lex large sources on up to jobs threads\n"
+                 "  --error-limit n\n"
+                 "               stop after n errors, 0 for no limit, 20\n"
+                 "               by default\n"
+                 "  -o output    the file to write, standard output for the\n"
+                 "               --emit-* options, a.out otherwise\n"
+                 "\n"
+                 "  QBE and CC in the environment override the qbe and C\n"
+                 "  compiler used to compile and link\n",
+                 program,
+                 CSTAR_BACKEND);
+    return EXIT_FAILURE;
+}
+
+bool parseOptions(Options &options, int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg{argv[i]};
+        if (arg == "--emit-c")
+            options.emit = Emit::C;
+        else if (arg == "--emit-qbe")
+            options.emit = Emit::Qbe;
+        else if (arg == "-c")
+            options.emit = Emit::Object;
+        else if (arg == "--backend=native")
+            options.backend = Backend::Native;
+        else if (arg == "--backend=qbe")
+            options.backend = Backend::Qbe;
+        else if (arg == "-j" and i + 1 < argc)
+            options.jobs = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--error-limit" and i + 1 < argc)
+            options.errorLimit =
+                std::uint32_t(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "-o" and i + 1 < argc)
+            options.output = argv[++i];
+        else if (arg.starts_with('-') or options.input != nullptr)
+            return false;
+        else
+            options.input = argv[i];
+    }
+    return options.input != nullptr;
+}
+
+/**
+ * Runs the given command and waits for it
+ *
+ * @return true if the command succeeded
+ */
+bool run(std::vector<const char *> command)
+{
+    command.push_back(nullptr);
+    pid_t pid;
+    auto argv = const_cast<char *const *>(command.data());
+    auto err = posix_spawnp(&pid, command[0], nullptr, nullptr, argv, environ);
+    if (err != 0) {
+        std::fprintf(
+            stderr, "error: cannot run %s: %s\n", command[0], strerror(err));
+        return false;
+    }
+
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR)
+            return false;
+    }
+    return WIFEXITED(status) and WEXITSTATUS(status) == 0;
+}
+
+const char *tool(const char *variable, const char *fallback)
+{
+    auto value = std::getenv(variable);
+    return value != nullptr and *value != '\0' ? value : fallback;
+}
+
+bool write(CodeWriter &out, const char *path)
+{
+    if (path == nullptr)
+        return out.flush(stdout);
+
+    std::ofstream os{path, std::ios::binary};
+    out.flush(os);
+    return bool(os);
+}
+
+/**
+ * Writes the code to a new temporary file with the given suffix
+ *
+ * @return the path of the file, empty if it could not be written
+ */
+std::string temporary(CodeWriter &code, const char *suffix)
+{
+    auto path = std::filesystem::temp_directory_path().string() +
+                "/cstar-XXXXXX" + suffix;
+    auto fd = mkstemps(path.data(), int(std::strlen(suffix)));
+    if (fd < 0) {
+        std::fprintf(stderr, "error: cannot create %s\n", path.c_str());
+        return {};
+    }
+    auto ok = code.flush(fd);
+    close(fd);
+    if (!ok) {
+        unlink(path.c_str());
+        return {};
+    }
+    return path;
+}
+
+const char *output(const Options &options)
+{
+    return options.output ? options.output
+                          : (options.emit == Emit::Object ? "a.o" : "a.out");
+}
+
+/**
+ * Lets the C compiler assemble the given input, and link it unless `emit`
+ * is `Object`
+ */
+bool link(const std::string &input, const Options &options)
+{
+    auto cc = tool("CC", "cc");
+    if (options.emit == Emit::Object)
+        return run({cc, "-c", input.c_str(), "-o", output(options)});
+    return run({cc, input.c_str(), "-o", output(options), "-lm"});
+}
+
+/**
+ * Writes the IL to a temporary file, compiles it to assembly with qbe and
+ * assembles or links it
+ */
+bool compile(CodeWriter &il, const Options &options)
+{
+    auto ssa = temporary(il, ".ssa");
+    if (ssa.empty())
+        return false;
+
+    auto assembly = ssa.substr(0, ssa.size() - 3) + "s";
+    auto ok = run({tool("QBE", CSTAR_QBE_EXECUTABLE),
+                   "-o",
+                   assembly.c_str(),
+                   ssa.c_str()});
+    ok = ok and link(assembly, options);
+
+    unlink(ssa.c_str());
+    unlink(assembly.c_str());
+    return ok;
+}
+
+/**
+ * Writes the object of the native backend, or links it to an executable
+ */
+bool compile(const ElfObject &object, const Options &options)
+{
+    CodeWriter out;
+    object.write(out);
+    if (options.emit == Emit::Object)
+        return write(out, output(options));
+
+    auto path = temporary(out, ".o");
+    if (path.empty())
+        return false;
+    auto ok = link(path, options);
+    unlink(path.c_str());
+    return ok;
+}
+
+} // namespace
 
 int main(int argc, char *argv[])
 {
-    return EXIT_SUCCESS;
+    Options options;
+    if (!parseOptions(options, argc, argv))
+        return usage(argv[0]);
+
+    Log L{options.errorLimit};
+    Source src{L, options.input};
+    Lexer lexer{L, src, gflLexerSkipComments};
+    // the parser pulls tokens from the lexer as it goes unless the source
+    // is lexed on several threads up front
+    if (options.jobs > 1 and !lexer.tokenizeParallel(options.jobs))
+        abortCompiler(L);
+
+    Parser parser(L, lexer, std::make_shared<SymbolTable>());
+    Program program;
+    // fails on lexing errors too, they are logged as they are reached
+    if (!parser.parse(program))
+        abortCompiler(L);
+
+    // constants are folded the way the lowering evaluates them, for every
+    // backend so that they all accept the same programs
+    Folding folding{L};
+    if (!folding.fold(program))
+        abortCompiler(L);
+
+    CodeWriter out;
+    if (options.emit == Emit::C) {
+        Codegen codegen{out};
+        codegen.generate(program);
+    }
+    else if (options.emit == Emit::Qbe or options.backend == Backend::Qbe) {
+        QbeCodegen codegen{out};
+        Lowering lowering{L, codegen};
+        if (!lowering.lower(program))
+            abortCompiler(L);
+    }
+    else {
+        ElfObject object;
+        X86Codegen codegen{object};
+        Lowering lowering{L, codegen};
+        if (!lowering.lower(program))
+            abortCompiler(L);
+        L.toString(std::cerr);
+        return compile(object, options) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    L.toString(std::cerr);
+
+    auto ok = options.emit == Emit::C or options.emit == Emit::Qbe
+                  ? write(out, options.output)
+                  : compile(out, options);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -9,27 +9,26 @@
  */
 
 #include "compiler/node.hpp"
-#include "compiler/log.hpp"
 
-namespace cstar {
-
-    Node::Ptr ContainerNode::get(int i)
-    {
-        csAssert(i < _children.size(), "index out of bounds");
-        return _children[i];
-    }
+#include <cstring>
 
-    Node::Ptr ContainerNode::get(int i) const
-    {
-        csAssert(i < _children.size(), "index out of bounds");
-        return _children[i];
-    }
+namespace cstar {
 
-    void ContainerNode::set(int i, Node::Ptr node)
+    void ContainerNode::insert(AstArena &arena, Node::Ptr node)
     {
-        if (i >= _children.size()) {
-            _children.resize(i + 1, {nullptr});
+        if (_size == _capacity) {
+            // the previous array is left behind in the arena, it is
+            // released together with the nodes
+            auto capacity = std::max<std::uint32_t>(4, _capacity * 2);
+            auto children = arena.array(capacity);
+            if (_size)
+                std::memcpy(children, _children, _size * sizeof(Node::Ptr));
+            std::memset(children + _size,
+                        0,
+                        (capacity - _size) * sizeof(Node::Ptr));
+            _children = children;
+            _capacity = capacity;
         }
-        _children[i] = node;
+        _children[_size++] = node;
     }
-}
\ No newline at end of file
+}
@@ -15,46 +15,67 @@
 
 namespace cstar {
 
-Parser::Parser(Log &L, Token::Tange tokens, SymbolTable::Ptr symbols)
-    : SymbolTableScope(std::move(symbols)), L{L}, _tokens{std::move(tokens)}
+Parser::Parser(Log &L, Lexer &lexer, SymbolTable::Ptr symbols)
+    : SymbolTableScope(std::move(symbols)), L{L}, _lexer{lexer},
+      _stream{lexer.stream()}
 {
-    _current = _tokens.first;
+    pull();
 }
 
-Token::Ref Parser::peek()
+void Parser::pull()
+{
+    auto &slot = _window[_pulled & WINDOW_MASK];
+    if (!L.limitReached() and _stream.next()) {
+        slot = _stream.value();
+    }
+    else {
+        // the lexer stopped without an EoF token, most likely on an error,
+        // or too many errors were reported and parsing stops here
+        auto end = _pulled ? _window[(_pulled - 1) & WINDOW_MASK].end() : 0;
+        slot = Token{Token::EoF, end, 0};
+    }
+    _pulled++;
+}
+
+Token Parser::peek()
 {
     if (Eof())
-        return _current;
-    return std::next(_current);
+        return current();
+    if (_pulled == _current + 1)
+        pull();
+    return _window[(_current + 1) & WINDOW_MASK];
 }
 
-Token::Ref Parser::advance()
+Token Parser::advance()
 {
-    auto curr = _current;
+    auto curr = current();
     if (!Eof()) {
-        std::advance(_current, 1);
+        _current++;
+        if (_pulled == _current)
+            pull();
     }
     return curr;
 }
 
-Token::Ref Parser::previous()
+Token Parser::previous() const
 {
-    if (_current == _tokens.first)
-        return _current;
-    return std::prev(_current);
+    if (_current == 0)
+        return current();
+    return _window[(_current - 1) & WINDOW_MASK];
 }
 
 void Parser::synchronize()
 {
+    _panicking = false;
     advance();
 
     while (!Eof()) {
-        if (_current->kind == Token::SEMICOLON) {
+        if (current().kind == Token::SEMICOLON) {
             advance();
             break;
         }
 
-        switch (_current->kind) {
+        switch (current().kind) {
         case Token::STRUCT:
         case Token::FUNC:
         case Token::IMM:
@@ -75,276 +96,404 @@ void Parser::synchronize()
 
 bool Parser::parse(Program &program)
 {
+    _arena = &program.arena();
     while (!Eof()) {
-        try {
-            program.insert(declaration());
-        }
-        catch (Synchronize &) {
-            synchronize();
-        }
+        if (auto decl = declaration())
+            program.insert(*_arena, decl);
     }
 
     return !L.hasErrors();
 }
 
-FunctionDecl::Ptr Parser::function()
+Stmt::Ptr Parser::declaration()
 {
-    auto fn =
-        consume(Token::FUNC, "expecting a 'func' keyword to start a function");
-
-    auto name =
-        consume(Token::IDENTIFIER, "expecting the name of the function");
-    auto nstr = name->range().toString();
+    csAssert(_constructs.empty(), "declarations are parsed from the top");
 
-    auto func = std::make_shared<FunctionDecl>(nstr, fn->range());
-
-    try {
-        push();
-        consume(Token::LPAREN, "expecting an opening paren '('");
-        if (!check(Token::RPAREN)) {
-            auto params = std::make_shared<StatementList>(previous()->range());
-            ParameterStmt::Ptr param = nullptr;
-            do {
-                param = parameter(param);
-                params->range().extend(param->range());
-                params->add(param);
-            } while (match(Token::COMMA));
-
-            func->params(std::move(params));
+    Stmt::Ptr stmt = begin();
+    for (;;) {
+        if (_panicking) {
+            // blocks are the synchronization point, whatever failed within
+            // them is dropped, up to the top level declaration
+            while (!_constructs.empty() and
+                   _constructs.back().kind != Construct::Block)
+                leave();
+            synchronize();
+            if (_constructs.empty())
+                return nullptr;
+            stmt = begin();
+            continue;
         }
 
-        consume(Token::RPAREN, "expecting an closing paren ')'");
-
-        if (match(Token::RARROW)) {
-            auto expr = expressionStmt();
-            auto block = std::make_shared<Block>(expr->range());
-            block->insert(std::move(expr));
-            func->body(std::move(block));
-        }
-        else {
-            func->body(block());
+        if (stmt == nullptr) {
+            // a construct was just entered and waits for a nested statement
+            stmt = begin();
+            continue;
         }
 
-        func->range().extend(func->body()->range());
-        pop();
-    }
-    catch (...) {
-        pop();
-        throw;
+        if (_constructs.empty())
+            return stmt;
+        stmt = complete(stmt);
     }
-
-    return func;
 }
 
-Block::Ptr Parser::block()
+Stmt::Ptr Parser::begin()
 {
-    auto lb = consume(Token::LBRACE, "expecting an opening brace '{'");
-    push();
-    auto block = std::make_shared<Block>(lb->range());
-    while (!Eof() && !check(Token::RBRACE)) {
-        if (auto stmt = declaration())
-            block->insert(stmt);
+    auto inner = _constructs.empty() ? nullptr : &_constructs.back();
+    if (inner != nullptr and inner->kind != Construct::Block) {
+        // the bodies of statements are not declarations
+        switch (kind()) {
+        case Token::IF:
+            return ifStmt(false);
+        case Token::WHILE:
+            return whileStmt(false);
+        case Token::FOR:
+            return forStmt(false);
+        case Token::LBRACE:
+            return block(false);
+        default:
+            return expressionStmt();
+        }
     }
 
-    auto rb = consume(Token::RBRACE, "expecting a closing brace '}'");
-    block->range().extend(rb->range());
-    pop();
+    if (inner != nullptr and (Eof() or check(Token::RBRACE)))
+        return blockEnd();
 
-    return block;
-}
+    auto isComptime = match(Token::AT);
+    Stmt::Ptr stmt{nullptr};
 
-Stmt::Ptr Parser::statement()
-{
     switch (kind()) {
+    case Token::MUT:
+    case Token::IMM:
+        stmt = variableDecl();
+        break;
+    case Token::FUNC:
+        return function(isComptime);
     case Token::IF:
-        return ifStmt();
+        return ifStmt(isComptime);
     case Token::WHILE:
-        return whileStmt();
+        return whileStmt(isComptime);
     case Token::FOR:
-        return forStmt();
+        return forStmt(isComptime);
     case Token::LBRACE:
-        return block();
+        return block(isComptime);
     default:
-        return expressionStmt();
+        stmt = expressionStmt();
+        break;
     }
+
+    if (stmt != nullptr and isComptime) {
+        stmt->flags |= gflIsComptime;
+    }
+
+    return stmt;
 }
 
-Stmt::Ptr Parser::declaration()
+Stmt::Ptr Parser::complete(Stmt::Ptr stmt)
 {
-    auto isComptime = match(Token::AT);
-    Stmt::Ptr stmt{nullptr};
-
-    try {
-        switch (kind()) {
-        case Token::MUT:
-        case Token::IMM:
-            stmt = variableDecl();
-            break;
-        case Token::FUNC:
-            stmt = function();
-            break;
-        default:
-            stmt = statement();
-        }
-        if (isComptime) {
-            stmt->flags |= gflIsComptime;
+    auto &inner = _constructs.back();
+    switch (inner.kind) {
+    case Construct::Block:
+        cast<Block>(inner.node)->add(*_arena, stmt);
+        return nullptr;
+    case Construct::Then: {
+        inner.tail->then(stmt);
+        if (!match(Token::ELSE))
+            return ifEnd(stmt->range());
+
+        if (check(Token::IF)) {
+            // `else if` chains stay in the same construct, they do not nest
+            auto next = ifHead();
+            if (next == nullptr)
+                return nullptr;
+            inner.tail->otherwise(next);
+            inner.tail = next;
+            return nullptr;
         }
+        inner.kind = Construct::Else;
+        return nullptr;
+    }
+    case Construct::Else:
+        inner.tail->otherwise(stmt);
+        return ifEnd(stmt->range());
+    case Construct::While: {
+        auto loop = cast<WhileStmt>(inner.node);
+        loop->body(stmt);
+        loop->range().extend(stmt->range());
+        return leave();
+    }
+    case Construct::For: {
+        auto loop = cast<ForStmt>(inner.node);
+        loop->body(stmt);
+        loop->range().extend(stmt->range());
+        return leave();
+    }
+    case Construct::Function:
+        break;
+    }
+
+    auto func = cast<FunctionDecl>(inner.node);
+    func->body(stmt);
+    func->range().extend(stmt->range());
+    return leave();
+}
+
+void Parser::enter(Construct::Kind kind, Node::Ptr node, bool isComptime)
+{
+    if (kind == Construct::Block or kind == Construct::For or
+        kind == Construct::Function)
+        push();
+    _constructs.push_back({kind, isComptime, node});
+}
+
+Stmt::Ptr Parser::leave()
+{
+    auto inner = _constructs.back();
+    _constructs.pop_back();
+    if (inner.kind == Construct::Block or inner.kind == Construct::For or
+        inner.kind == Construct::Function)
+        pop();
+
+    auto stmt = cast<Stmt>(inner.node);
+    if (inner.isComptime)
+        stmt->flags |= gflIsComptime;
+    return stmt;
+}
+
+Stmt::Ptr Parser::function(bool isComptime)
+{
+    auto fn =
+        consume(Token::FUNC, Diag::ExpectedFunc);
+    if (!fn)
+        return nullptr;
+
+    auto name =
+        consume(Token::IDENTIFIER, Diag::ExpectedFunctionName);
+    if (!name)
+        return nullptr;
+    const auto id = name->id();
+    auto func = make<FunctionDecl>(id, range(*fn));
+
+    // defined before the body so that functions can call themselves
+    if (table().find(id, 0) or
+        !table().define(id, func, range(*name), symFunc)) {
+        return error(range(*name), Diag::FunctionRedefined, func->text());
+    }
+
+    enter(Construct::Function, func, isComptime);
+    if (!consume(Token::LPAREN, Diag::ExpectedLParen))
+        return nullptr;
 
-        return stmt;
+    if (!check(Token::RPAREN)) {
+        auto params = make<StatementList>(range(previous()));
+        ParameterStmt::Ptr param = nullptr;
+        do {
+            param = parameter(param);
+            if (param == nullptr)
+                return nullptr;
+            params->range().extend(param->range());
+            params->add(*_arena, param);
+        } while (match(Token::COMMA));
+
+        func->params(params);
     }
-    catch (Synchronize &) {
-        synchronize();
+
+    if (!consume(Token::RPAREN, Diag::ExpectedRParen))
         return nullptr;
+
+    if (match(Token::RARROW)) {
+        auto expr = expressionStmt();
+        if (expr == nullptr)
+            return nullptr;
+        auto body = make<Block>(expr->range());
+        body->add(*_arena, expr);
+        return complete(body);
     }
+
+    return block(false);
+}
+
+Stmt::Ptr Parser::block(bool isComptime)
+{
+    auto lb = consume(Token::LBRACE, Diag::ExpectedLBrace);
+    if (!lb)
+        return nullptr;
+
+    enter(Construct::Block, make<Block>(range(*lb)), isComptime);
+    return nullptr;
+}
+
+Stmt::Ptr Parser::blockEnd()
+{
+    auto rb = expect(Token::RBRACE, Diag::ExpectedRBrace);
+    auto block = leave();
+    if (!rb)
+        return nullptr;
+
+    advance();
+    block->range().extend(range(*rb));
+    return block;
 }
 
 Stmt::Ptr Parser::expressionStmt()
 {
     auto expr = expression();
-    auto stmt = std::make_shared<ExpressionStmt>(expr, expr->range());
+    if (expr == nullptr)
+        return nullptr;
+    auto stmt = make<ExpressionStmt>(expr, expr->range());
 
-    consume(Token::SEMICOLON, "expecting a semicolon ';' after a statement");
+    if (!consume(Token::SEMICOLON, Diag::ExpectedStatementSemicolon))
+        return nullptr;
 
     return stmt;
 }
 
-Stmt::Ptr Parser::ifStmt()
+IfStmt::Ptr Parser::ifHead()
 {
-    auto start = consume(Token::IF, "expecting an 'if' statement");
-    consume(Token::LPAREN,
-            "expecting an opening paren '(' after an 'if' keyword");
-    auto condition = expression();
-    consume(Token::RPAREN, "expect a closing paren ')' after an if condition");
+    auto start = consume(Token::IF, Diag::ExpectedIf);
+    if (!start or !consume(Token::LPAREN, Diag::ExpectedIfLParen))
+        return nullptr;
 
-    auto stmt = std::make_shared<IfStmt>(std::move(condition), start->range());
-    stmt->then(statement());
-    if (match(Token::ELSE)) {
-        stmt->otherwise(statement());
-        stmt->range().extend(stmt->otherwise()->range());
-    }
-    else {
-        stmt->range().extend(stmt->then()->range());
-    }
+    auto condition = expression();
+    if (condition == nullptr or
+        !consume(Token::RPAREN, Diag::ExpectedIfRParen))
+        return nullptr;
 
-    return stmt;
+    return make<IfStmt>(condition, range(*start));
 }
 
-Stmt::Ptr Parser::whileStmt()
+Stmt::Ptr Parser::ifStmt(bool isComptime)
 {
-    auto start = consume(
-        Token::WHILE, "expecting a 'while' keyword to start a while statement");
-    consume(Token::LPAREN,
-            "expecting an opening paren '(' after 'while' keyword");
+    auto stmt = ifHead();
+    if (stmt == nullptr)
+        return nullptr;
 
-    auto stmt = std::make_shared<WhileStmt>(expression(), start->range());
-    consume(
-        Token::RPAREN,
-        "expecting an closing paren ')' after a 'while' statement condition");
+    enter(Construct::Then, stmt, isComptime);
+    _constructs.back().tail = stmt;
+    return nullptr;
+}
 
-    if (!match(Token::SEMICOLON)) {
-        stmt->body(statement());
-        stmt->range().extend(stmt->body()->range());
+Stmt::Ptr Parser::ifEnd(const Range &end)
+{
+    auto &inner = _constructs.back();
+    for (auto stmt = cast<IfStmt>(inner.node);;
+         stmt = cast<IfStmt>(stmt->otherwise())) {
+        stmt->range().extend(end);
+        if (stmt == inner.tail)
+            break;
     }
-    else {
+    return leave();
+}
+
+Stmt::Ptr Parser::whileStmt(bool isComptime)
+{
+    auto start = consume(Token::WHILE, Diag::ExpectedWhile);
+    if (!start or !consume(Token::LPAREN, Diag::ExpectedWhileLParen))
+        return nullptr;
+
+    auto condition = expression();
+    if (condition == nullptr)
+        return nullptr;
+
+    auto stmt = make<WhileStmt>(condition, range(*start));
+    if (!consume(Token::RPAREN, Diag::ExpectedWhileRParen))
+        return nullptr;
+
+    enter(Construct::While, stmt, isComptime);
+    if (match(Token::SEMICOLON)) {
         // while(true);
-        stmt->range().extend(previous()->range());
+        stmt->range().extend(range(previous()));
+        return leave();
     }
 
-    return stmt;
+    return nullptr;
 }
 
-Stmt::Ptr Parser::forStmt()
+Stmt::Ptr Parser::forStmt(bool isComptime)
 {
-    auto start = consume(
-        Token::FOR, "expecting a 'for' keyword to start a 'for' statement");
-    consume(Token::LPAREN,
-            "expecting an open paren ';' to start for loop clauses");
+    auto start = consume(Token::FOR, Diag::ExpectedFor);
+    if (!start or !consume(Token::LPAREN, Diag::ExpectedForLParen))
+        return nullptr;
 
-    auto stmt = std::make_shared<ForStmt>(start->range());
-    push();
-    try {
-        if (!match(Token::SEMICOLON)) {
-            if (check(Token::MUT, Token::IMM)) {
-                stmt->init(variableDecl());
-            }
-            else {
-                stmt->init(expressionStmt());
-            }
-        }
+    auto stmt = make<ForStmt>(range(*start));
+    enter(Construct::For, stmt, isComptime);
 
-        if (!check(Token::SEMICOLON)) {
-            stmt->condition(expression());
-        }
-        consume(Token::SEMICOLON,
-                "expecting a semicolon ';' after loop condition.");
+    if (!match(Token::SEMICOLON)) {
+        auto init = check(Token::MUT, Token::IMM) ? variableDecl()
+                                                  : expressionStmt();
+        if (init == nullptr)
+            return nullptr;
+        stmt->init(init);
+    }
 
-        if (!check(Token::RPAREN)) {
-            stmt->update(expression());
-        }
-        consume(Token::RPAREN,
-                "expecting a closing paren ')' to close for loop clauses.");
+    if (!check(Token::SEMICOLON)) {
+        auto condition = expression();
+        if (condition == nullptr)
+            return nullptr;
+        stmt->condition(condition);
+    }
+    if (!consume(Token::SEMICOLON, Diag::ExpectedForSemicolon))
+        return nullptr;
 
-        if (!match(Token::SEMICOLON)) {
-            stmt->body(statement());
-            stmt->range().extend(stmt->body()->range());
-        }
-        else {
-            stmt->range().extend(previous()->range());
-        }
-        pop();
+    if (!check(Token::RPAREN)) {
+        auto update = expression();
+        if (update == nullptr)
+            return nullptr;
+        stmt->update(update);
     }
-    catch (...) {
-        pop();
-        throw;
+    if (!consume(Token::RPAREN, Diag::ExpectedForRParen))
+        return nullptr;
+
+    if (match(Token::SEMICOLON)) {
+        stmt->range().extend(range(previous()));
+        return leave();
     }
 
-    return stmt;
+    return nullptr;
 }
 
 Stmt::Ptr Parser::variableDecl()
 {
     auto modifier = advance();
     auto name =
-        consume(Token::IDENTIFIER, "expecting the name of the variable");
-    auto nstr = name->range().toString();
+        consume(Token::IDENTIFIER, Diag::ExpectedVariableName);
+    if (!name)
+        return nullptr;
+    const auto id = name->id();
+    const auto modifierRange = range(modifier);
 
-    auto decl = std::make_shared<DeclarationStmt>(
-        nstr,
-        modifier->kind == Token::IMM,
-        modifier->range().merge(name->range()));
+    auto decl = make<DeclarationStmt>(
+        id, modifier.kind == Token::IMM, modifierRange.merge(range(*name)));
 
-    if (auto sym = table().find(nstr, 0)) {
-        error(name->range(),
-              "variable '",
-              nstr,
-              "' already defined in current scope");
+    if (table().find(id, 0)) {
+        return error(range(*name), Diag::VariableRedefined, decl->text());
     }
 
     if (match(Token::COLON)) {
-        decl->type(expressionType());
-        decl->range().extend(previous()->range());
+        auto type = expressionType();
+        if (type == nullptr)
+            return nullptr;
+        decl->type(type);
+        decl->range().extend(range(previous()));
     }
 
     if (match(Token::ASSIGN)) {
-        decl->value(expression());
-        decl->range().extend(decl->value()->range());
+        auto value = expression();
+        if (value == nullptr)
+            return nullptr;
+        decl->value(value);
+        decl->range().extend(value->range());
     }
 
     if (decl->value() == nullptr && decl->type() == builtin::autoType()) {
-        error(decl->range(),
-              "an explicit type must be assigned to an uninitialized "
-              "variable");
+        return error(decl->range(), Diag::UntypedUninitialized);
     }
 
-    if (!table().define(nstr, decl->value(), name->range(), symVariable)) {
-        error(name->range(),
-              "variable '",
-              nstr,
-              "' already defined in current scope");
+    if (!table().define(id, decl->value(), range(*name), symVariable)) {
+        return error(range(*name), Diag::VariableRedefined, decl->text());
     }
-    consume(Token::SEMICOLON,
-            "expecting a semicolon ';' after a variable declaration "
-            "expression");
+    if (!consume(Token::SEMICOLON, Diag::ExpectedDeclarationSemicolon))
+        return nullptr;
+
     return decl;
 }
 
@@ -353,422 +502,324 @@ ParameterStmt::Ptr Parser::parameter(ParameterStmt::Ptr prev)
 
     if ((prev && (prev->flags & gflIsVariadic) == gflIsVariadic)) {
         // ...param: Type ) only allowed as last parameter
-        error(prev->range(),
-              "parameter '",
-              prev->name,
-              "' cannot be a variadic parameter, it is followed by another "
-              "parameter");
+        return error(prev->range(), Diag::VariadicNotLast, prev->text());
     }
 
-    auto range = _current->range();
+    auto paramRange = range(current());
     auto isElipsis = match(Token::ELIPSIS);
 
     auto name =
-        consume(Token::IDENTIFIER, "expecting the name of the parameter");
+        consume(Token::IDENTIFIER, Diag::ExpectedParameterName);
+    if (!name)
+        return nullptr;
     if (isElipsis)
-        range.extend(name->range());
+        paramRange.extend(range(*name));
 
-    auto nstr = name->range().toString();
+    const auto id = name->id();
+    const auto nstr = Strings::get(id);
 
     if (isElipsis && (prev && prev->value())) {
         // ...param: Type ) not allowed when previous parameter has a default
         // value
-        error(range,
-              "variadiac parameter '",
-              nstr,
-              "' not allowed after parameters with default arguments");
+        return error(paramRange, Diag::VariadicAfterDefault, nstr);
     }
 
-    if (table().find(nstr, 0)) {
-        error(range,
-              "parameter '",
-              nstr,
-              "' already defined in the parameter list");
+    if (table().find(id, 0)) {
+        return error(paramRange, Diag::ParameterRedefined, nstr);
     }
 
-    consume(
-        Token::COLON,
-        "expecting a colon ':' after a parameter name and before the parameter "
-        "type");
+    if (!consume(Token::COLON, Diag::ExpectedParameterColon))
+        return nullptr;
 
-    auto param = std::make_shared<ParameterStmt>(nstr, range);
-    param->type(expressionType());
+    auto param = make<ParameterStmt>(id, paramRange);
+    auto type = expressionType();
+    if (type == nullptr)
+        return nullptr;
+    param->type(type);
 
     // TODO use type range
-    param->range().extend(previous()->range());
+    param->range().extend(range(previous()));
 
     if (match(Token::ASSIGN)) {
         // parameter default value
-        range.extend(previous()->range());
+        paramRange.extend(range(previous()));
         if (isElipsis) {
-            error(range,
-                  "default parameter arguments cannot be assigned to variadiac "
-                  "parameters");
+            return error(paramRange, Diag::VariadicWithDefault);
         }
         auto def = expression();
+        if (def == nullptr)
+            return nullptr;
         param->range().extend(def->range());
         param->value(def);
     }
     else if (prev && (prev->value() != nullptr)) {
-        error(param->range(),
-              "default argument missing for parameter '",
-              nstr,
-              "'");
+        return error(param->range(), Diag::MissingDefault, nstr);
     }
 
     if (isElipsis) {
         param->flags |= gflIsVariadic;
     }
 
-    table().define(nstr, nullptr, param->range(), symVariable);
+    table().define(id, nullptr, param->range(), symVariable);
 
     return param;
 }
 
 Type::Ptr Parser::expressionType()
 {
-    auto tok = consume(Token::IDENTIFIER, "expecting a type name");
-    if (auto type = builtin::getBuiltinType(tok->range().toString())) {
+    auto tok = consume(Token::IDENTIFIER, Diag::ExpectedTypeName);
+    if (!tok)
+        return nullptr;
+    if (auto type = builtin::getBuiltinType(Strings::get(tok->id()))) {
         return type;
     }
-    error("unknown type name (TODO support custom types)");
-}
-
-Expr::Ptr Parser::expression() { return assignment(); }
-
-Expr::Ptr Parser::assignment()
-{
-    auto expr = ternary();
-    Expr::Ptr value;
-    switch (kind()) {
-    case Token::ASSIGN:
-        advance();
-        value = assignment();
-        expr = std::make_shared<AssignmentExpr>(expr, value, expr->range());
-        expr->range().extend(value->range());
-        return expr;
-    case Token::MINUSASSIGN:
-        advance();
-        value = assignment();
-        value = std::make_shared<BinaryExpr>(
-            expr, Token::MINUS, value, value->range());
-        expr = std::make_shared<AssignmentExpr>(expr, value, expr->range());
-        expr->range().extend(value->range());
-        return expr;
-    case Token::PLUSASSGIN:
-        advance();
-        value = assignment();
-        value = std::make_shared<BinaryExpr>(
-            expr, Token::PLUS, value, value->range());
-        expr = std::make_shared<AssignmentExpr>(expr, value, expr->range());
-        expr->range().extend(value->range());
-        return expr;
-    case Token::MULTASSIGN:
-        advance();
-        value = assignment();
-        value = std::make_shared<BinaryExpr>(
-            expr, Token::MULT, value, value->range());
-        expr = std::make_shared<AssignmentExpr>(expr, value, expr->range());
-        expr->range().extend(value->range());
-        return expr;
-    case Token::DIVASSIGN:
-        advance();
-        value = assignment();
-        value = std::make_shared<BinaryExpr>(
-            expr, Token::DIV, value, value->range());
-        expr = std::make_shared<AssignmentExpr>(expr, value, expr->range());
-        expr->range().extend(value->range());
-        return expr;
-    case Token::SHLASSIGN:
-        advance();
-        value = assignment();
-        value = std::make_shared<BinaryExpr>(
-            expr, Token::SHL, value, value->range());
-        expr = std::make_shared<AssignmentExpr>(expr, value, expr->range());
-        expr->range().extend(value->range());
-        return expr;
-    case Token::SHRASSIGN:
-        advance();
-        value = assignment();
-        value = std::make_shared<BinaryExpr>(
-            expr, Token::SHR, value, value->range());
-        expr = std::make_shared<AssignmentExpr>(expr, value, expr->range());
-        expr->range().extend(value->range());
-        return expr;
-    case Token::MODASSIGN:
-        advance();
-        value = assignment();
-        value = std::make_shared<BinaryExpr>(
-            expr, Token::MOD, value, value->range());
-        expr = std::make_shared<AssignmentExpr>(expr, value, expr->range());
-        expr->range().extend(value->range());
-        return expr;
-    case Token::BITANDASSIGN:
-        advance();
-        value = assignment();
-        value = std::make_shared<BinaryExpr>(
-            expr, Token::BITAND, value, value->range());
-        expr = std::make_shared<AssignmentExpr>(expr, value, expr->range());
-        expr->range().extend(value->range());
-        return expr;
-    case Token::BITORASSIGN:
-        advance();
-        value = assignment();
-        value = std::make_shared<BinaryExpr>(
-            expr, Token::BITOR, value, value->range());
-        expr = std::make_shared<AssignmentExpr>(expr, value, expr->range());
-        expr->range().extend(value->range());
-        return expr;
-    default:
-        break;
-    }
-
-    return expr;
-}
-
-Expr::Ptr Parser::ternary()
-{
-    auto expr = coalescing();
-    if (match(Token::QUESTION)) {
-        auto ifTrue = ternary();
-        consume(Token::COLON,
-                "expecting a colon ':' to seperate a ternary expression.");
-        auto ifFalse = ternary();
-        expr = std::make_shared<TernaryExpr>(
-            expr, std::move(ifTrue), ifFalse, expr->range());
-        expr->range().extend(ifFalse->range());
-    }
-
-    return expr;
+    return error(Diag::UnknownType);
 }
 
-Expr::Ptr Parser::coalescing()
+Expr::Ptr Parser::expression()
 {
-    auto expr = lor();
-    if (match(Token::QUESTIONQUESTION)) {
-        auto rhs = lor();
-        expr =
-            std::make_shared<NullishCoalescingExpr>(expr, rhs, expr->range());
-        expr->range().extend(rhs->range());
-    }
+    const auto base = _operators.size();
+    const auto bottom = _operands.size();
 
-    return expr;
-}
-
-Expr::Ptr Parser::lor()
-{
-    auto expr = land();
-
-    while (match(Token::LOR)) {
-        auto rhs = land();
-        expr =
-            std::make_shared<BinaryExpr>(expr, Token::LOR, rhs, expr->range());
-        expr->range().extend(rhs->range());
-    }
-
-    return expr;
-}
-
-Expr::Ptr Parser::land()
-{
-    auto expr = bor();
-
-    while (match(Token::LAND)) {
-        auto rhs = bor();
-        expr =
-            std::make_shared<BinaryExpr>(expr, Token::LAND, rhs, expr->range());
-        expr->range().extend(rhs->range());
-    }
-
-    return expr;
-}
-
-Expr::Ptr Parser::bor()
-{
-    auto expr = bxor();
-
-    while (match(Token::BITOR)) {
-        auto rhs = bxor();
-        expr = std::make_shared<BinaryExpr>(
-            expr, Token::BITOR, rhs, expr->range());
-        expr->range().extend(rhs->range());
-    }
+    auto expr = prefix();
+    while (expr != nullptr) {
+        const auto prec = Token::precedence(kind());
+        const auto min = _operators.size() > base ? _operators.back().min
+                                                  : Precedence::Assignment;
+        if (prec >= min) {
+            if (infix(expr, prec))
+                expr = prefix();
+            continue;
+        }
 
-    return expr;
-}
+        if (_operators.size() == base)
+            break;
 
-Expr::Ptr Parser::bxor()
-{
-    auto expr = band();
+        // the operator on top of the stack does not bind the incoming
+        // operator, `expr` is its last operand
+        auto op = _operators.back();
+        _operators.pop_back();
 
-    while (match(Token::BITXOR)) {
-        auto rhs = band();
-        expr = std::make_shared<BinaryExpr>(
-            expr, Token::BITXOR, rhs, expr->range());
-        expr->range().extend(rhs->range());
+        switch (op.kind) {
+        case Operator::Condition:
+            if (!consume(Token::COLON, Diag::ExpectedTernaryColon)) {
+                expr = nullptr;
+                break;
+            }
+            shift({Operator::Ternary, op.op, Precedence::Ternary}, expr);
+            expr = prefix();
+            break;
+        case Operator::Grouping:
+            op.range.extend(range(current()));
+            if (!consume(Token::RPAREN, Diag::ExpectedGroupingRParen)) {
+                expr = nullptr;
+                break;
+            }
+            expr = make<GroupingExpr>(expr, op.range);
+            break;
+        case Operator::Arguments: {
+            auto arguments = cast<ExpressionList>(op.node);
+            arguments->range().extend(expr->range());
+            arguments->add(*_arena, expr);
+            if (match(Token::COMMA)) {
+                shift(op);
+                expr = prefix();
+                break;
+            }
+            auto callee = _operands.back();
+            _operands.pop_back();
+            expr = call(callee, arguments);
+            break;
+        }
+        case Operator::Parts: {
+            auto str = cast<StringExpressionExpr>(op.node);
+            str->addPart(*_arena, expr);
+            if (match(Token::RSTREXPR)) {
+                str->range().extend(range(previous()));
+                expr = str;
+                break;
+            }
+            shift(op);
+            expr = prefix();
+            break;
+        }
+        default:
+            expr = reduce(op, expr);
+            break;
+        }
     }
 
-    return expr;
-}
-
-Expr::Ptr Parser::band()
-{
-    auto expr = equality();
-
-    while (match(Token::BITAND)) {
-        auto rhs = equality();
-        expr = std::make_shared<BinaryExpr>(
-            expr, Token::BITAND, rhs, expr->range());
-        expr->range().extend(rhs->range());
-    }
+    // only an error leaves pending operators behind
+    _operators.erase(_operators.begin() + base, _operators.end());
+    _operands.erase(_operands.begin() + bottom, _operands.end());
 
     return expr;
 }
 
-Expr::Ptr Parser::call()
+Expr::Ptr Parser::prefix()
 {
-    auto expr = primary();
-
-    while (true) {
-        if (match(Token::LPAREN)) {
-            auto arguments =
-                std::make_shared<ExpressionList>(previous()->range());
-            if (!check(Token::RPAREN)) {
-                do {
-                    auto arg = expression();
-                    arguments->range().extend(arg->range());
-                    arguments->add(std::move(arg));
-                } while (match(Token::COMMA));
-            }
-
-            auto tok = consume(
-                Token::RPAREN,
-                "expecting a closing paren '(' to end function arguments");
-            arguments->range().extend(tok->range());
-
-            auto call = std::make_shared<CallExpr>(expr, expr->range());
-            call->range().extend(tok->range());
-            call->arguments(std::move(arguments));
-
-            expr = std::move(call);
+    for (;;) {
+        switch (kind()) {
+        case Token::PLUS:
+        case Token::MINUS:
+        case Token::NOT:
+        case Token::COMPLEMENT: {
+            const auto op = advance();
+            shift({Operator::Unary, op.kind, Precedence::Unary, range(op)});
+            break;
+        }
+        case Token::PLUSPLUS:
+        case Token::MINUSMINUS: {
+            const auto op = advance();
+            shift({Operator::Prefix, op.kind, Precedence::Unary, range(op)});
+            break;
         }
-        else {
+        case Token::LPAREN: {
+            const auto op = advance();
+            shift({Operator::Grouping,
+                   op.kind,
+                   Precedence::Assignment,
+                   range(op)});
             break;
         }
+        case Token::LSTREXPR: {
+            const auto op = advance();
+            auto str = make<StringExpressionExpr>(range(op));
+            if (match(Token::RSTREXPR)) {
+                str->range().extend(range(previous()));
+                return str;
+            }
+            shift({Operator::Parts, op.kind, Precedence::Assignment, {}, str});
+            break;
+        }
+        default:
+            return primary();
+        }
     }
-
-    return expr;
 }
 
-Expr::Ptr Parser::equality()
+bool Parser::infix(Expr::Ptr &lhs, Precedence prec)
 {
-    auto expr = comparison();
+    const auto op = advance();
 
-    while (match(Token::NEQ, Token::EQUAL)) {
-        auto op = previous();
-        auto right = comparison();
-        expr =
-            std::make_shared<BinaryExpr>(expr, op->kind, right, expr->range());
-        expr->range().extend(right->range());
+    switch (op.kind) {
+    case Token::LPAREN: {
+        auto arguments = make<ExpressionList>(range(op));
+        if (check(Token::RPAREN)) {
+            lhs = call(lhs, arguments);
+            return false;
+        }
+        shift({Operator::Arguments,
+               op.kind,
+               Precedence::Assignment,
+               {},
+               arguments},
+              lhs);
+        return true;
+    }
+    case Token::PLUSPLUS:
+    case Token::MINUSMINUS: {
+        auto expr = make<PostfixExpr>(op.kind, lhs, lhs->range());
+        expr->range().extend(range(op));
+        lhs = expr;
+        return false;
+    }
+    case Token::QUESTION:
+        shift({Operator::Condition, op.kind, Precedence::Ternary}, lhs);
+        return true;
+    case Token::QUESTIONQUESTION:
+        // left associative, the right operand must bind tighter
+        shift({Operator::Coalescing,
+               op.kind,
+               Precedence(std::uint8_t(prec) + 1)},
+              lhs);
+        return true;
+    default:
+        break;
     }
 
-    return expr;
-}
-
-Expr::Ptr Parser::comparison()
-{
-    auto expr = terminal();
-
-    while (match(Token::GT, Token::GTE, Token::LT, Token::LTE)) {
-        auto op = previous()->kind;
-        auto right = terminal();
-        expr = std::make_shared<BinaryExpr>(expr, op, right, expr->range());
-        expr->range().extend(right->range());
+    if (prec == Precedence::Assignment) {
+        // assignments are right associative
+        shift({Operator::Assignment, op.kind, Precedence::Assignment}, lhs);
+        return true;
     }
 
-    return expr;
+    // binary operators are left associative except for exponentiation
+    const auto min = op.kind == Token::EXPONENT
+                         ? prec
+                         : Precedence(std::uint8_t(prec) + 1);
+    shift({Operator::Binary, op.kind, min}, lhs);
+    return true;
 }
 
-Expr::Ptr Parser::terminal()
+void Parser::shift(Operator op, Expr::Ptr operand)
 {
-    auto expr = factor();
-
-    while (match(Token::MINUS, Token::PLUS)) {
-        auto op = previous()->kind;
-        auto right = factor();
-
-        expr = std::make_shared<BinaryExpr>(expr, op, right, expr->range());
-        expr->range().extend(right->range());
-    }
-
-    return expr;
+    if (operand != nullptr)
+        _operands.push_back(operand);
+    _operators.push_back(op);
 }
 
-Expr::Ptr Parser::factor()
+Expr::Ptr Parser::reduce(const Operator &op, Expr::Ptr rhs)
 {
-    auto expr = nots();
-
-    while (match(Token::DIV, Token::MULT)) {
-        auto op = previous()->kind;
-        auto right = nots();
-
-        expr = std::make_shared<BinaryExpr>(expr, op, right, expr->range());
-        expr->range().extend(right->range());
+    if (op.kind == Operator::Unary or op.kind == Operator::Prefix) {
+        Expr::Ptr expr{nullptr};
+        if (op.kind == Operator::Unary)
+            expr = make<UnaryExpr>(op.op, rhs, op.range);
+        else
+            expr = make<PrefixExpr>(op.op, rhs, op.range);
+        expr->range().extend(rhs->range());
+        return expr;
     }
 
-    return expr;
-}
-
-Expr::Ptr Parser::unary()
-{
-    if (match(Token::PLUS, Token::MINUS)) {
-        auto op = previous();
-        auto right = unary();
-
-        auto expr = std::make_shared<UnaryExpr>(op->kind, right, op->range());
-        expr->range().extend(right->range());
+    auto lhs = _operands.back();
+    _operands.pop_back();
 
+    switch (op.kind) {
+    case Operator::Ternary: {
+        auto condition = _operands.back();
+        _operands.pop_back();
+        auto expr = make<TernaryExpr>(condition, lhs, rhs, condition->range());
+        expr->range().extend(rhs->range());
         return expr;
     }
-
-    return prefix();
-}
-
-Expr::Ptr Parser::nots()
-{
-    if (match(Token::COMPLEMENT, Token::NOT)) {
-        auto op = previous();
-        auto right = nots();
-
-        auto expr = std::make_shared<UnaryExpr>(op->kind, right, op->range());
-        expr->range().extend(right->range());
-
+    case Operator::Coalescing: {
+        auto expr = make<NullishCoalescingExpr>(lhs, rhs, lhs->range());
+        expr->range().extend(rhs->range());
         return expr;
     }
-
-    return unary();
+    case Operator::Assignment: {
+        // compound assignments are desugared into `lhs = lhs op value`
+        auto value = rhs;
+        if (op.op != Token::ASSIGN) {
+            value = make<BinaryExpr>(
+                lhs, Token::compoundOperator(op.op), value, value->range());
+        }
+        auto expr = make<AssignmentExpr>(lhs, value, lhs->range());
+        expr->range().extend(value->range());
+        return expr;
+    }
+    default: {
+        csAssert(op.kind == Operator::Binary);
+        auto expr = make<BinaryExpr>(lhs, op.op, rhs, lhs->range());
+        expr->range().extend(rhs->range());
+        return expr;
+    }
+    }
 }
 
-Expr::Ptr Parser::prefix()
+Expr::Ptr Parser::call(Expr::Ptr callee, ExpressionList::Ptr arguments)
 {
-    if (match(Token::MINUSMINUS, Token::PLUSPLUS)) {
-        auto op = previous();
-        auto right = prefix();
-
-        auto expr = std::make_shared<PrefixExpr>(op->kind, right, op->range());
-        expr->range().extend(right->range());
-
-        return expr;
-    }
+    auto tok =
+        consume(Token::RPAREN, Diag::ExpectedArgumentsRParen);
+    if (!tok)
+        return nullptr;
+    arguments->range().extend(range(*tok));
 
-    auto expr = call();
-    while (match(Token::PLUSPLUS, Token::MINUSMINUS)) {
-        auto op = previous();
-        expr = std::make_shared<PostfixExpr>(op->kind, expr, expr->range());
-        expr->range().extend(op->range());
-    }
+    auto call = make<CallExpr>(callee, callee->range());
+    call->range().extend(range(*tok));
+    call->arguments(arguments);
 
-    return expr;
+    return call;
 }
 
 Expr::Ptr Parser::primary()
@@ -778,58 +829,33 @@ Expr::Ptr Parser::primary()
         return expr;
     }
 
-    if (match(Token::LSTREXPR)) {
-        auto expr = std::make_shared<StringExpressionExpr>(previous()->range());
-        while (!match(Token::RSTREXPR)) {
-            auto node = expression();
-            expr->addPart(node);
-        }
-        expr->range().extend(previous()->range());
-        return expr;
-    }
-
     if (check(Token::IDENTIFIER)) {
-        auto &tok = *advance();
-        auto sym = table().find(tok.range().toString());
-        if (!sym) {
-            error(tok.range(),
-                  "accessing an undefined variable '",
-                  tok.range().toString(),
-                  "'");
+        auto tok = advance();
+        if (!table().find(tok.id())) {
+            return error(
+                range(tok), Diag::UndefinedVariable, Strings::get(tok.id()));
         }
-        return std::make_shared<VariableExpr>(tok.range().toString(),
-                                              tok.range());
+        return make<VariableExpr>(tok.id(), range(tok));
     }
 
-    auto range = _current->range();
-    if (match(Token::LPAREN)) {
-        auto expr = expression();
-        range.extend(_current->range());
-
-        consume(Token::RPAREN, "expecting a closing ')' after expression.");
-        return std::make_shared<GroupingExpr>(expr, range);
-    }
-
-    error("unexpected token, expecting an expression");
+    return error(Diag::ExpectedExpression);
 }
 
 LiteralExpr::Ptr Parser::literal()
 {
-    auto tok = _current;
-    switch (tok->kind) {
+    auto tok = current();
+    switch (tok.kind) {
     case Token::TRUE:
     case Token::FALSE:
-        return std::make_shared<BoolExpr>(tok->value<bool>(), tok->range());
+        return make<BoolExpr>(tok.value<bool>(), range(tok));
     case Token::CHAR:
-        return std::make_shared<CharExpr>(tok->value<uint32_t>(), tok->range());
+        return make<CharExpr>(tok.value<uint32_t>(), range(tok));
     case Token::INTEGER:
-        return std::make_shared<IntegerExpr>(tok->value<uint64_t>(),
-                                             tok->range());
+        return make<IntegerExpr>(tok.value<uint64_t>(), range(tok));
     case Token::FLOAT:
-        return std::make_shared<FloatExpr>(tok->value<double>(), tok->range());
+        return make<FloatExpr>(tok.value<double>(), range(tok));
     case Token::STRING:
-        return std::make_shared<StringExpr>(tok->value<std::string_view>(),
-                                            tok->range());
+        return make<StringExpr>(tok.value<std::string_view>(), range(tok));
     default:
         return nullptr;
     }
@@ -837,9 +863,10 @@ LiteralExpr::Ptr Parser::literal()
 
 VariableExpr::Ptr Parser::variable()
 {
-    auto var = consume(Token::IDENTIFIER, "expecting an identifier");
+    auto var = consume(Token::IDENTIFIER, Diag::ExpectedIdentifier);
+    if (!var)
+        return nullptr;
 
-    return std::make_shared<VariableExpr>(var->range().toString(),
-                                          var->range());
+    return make<VariableExpr>(var->id(), range(*var));
 }
 } // namespace cstar
\ No newline at end of file
@@ -0,0 +1,183 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-12
+ */
+
+#include "compiler/qbe.hpp"
+
+#include "compiler/log.hpp"
+
+#include <charconv>
+#include <span>
+
+namespace cstar {
+
+namespace {
+
+char name(ir::Cls cls) { return "wlsd"[unsigned(cls)]; }
+
+} // namespace
+
+QbeCodegen::QbeCodegen(CodeWriter &out) : _out{out}
+{
+    _out << "# Generated code\n\n";
+}
+
+void QbeCodegen::operand(const ir::Module &m, const ir::Ref &ref)
+{
+    char buf[32];
+    switch (ref.kind) {
+    case ir::Ref::TEMP:
+        _out << "%t" << ref.id;
+        break;
+    case ir::Ref::INTEGER:
+        _out << ref.integer;
+        break;
+    case ir::Ref::FLOAT: {
+        // the shortest representation that reads back as the same number
+        auto single = ref.cls == ir::Cls::S;
+        auto end =
+            single ? std::to_chars(buf, buf + sizeof(buf), float(ref.real)).ptr
+                   : std::to_chars(buf, buf + sizeof(buf), ref.real).ptr;
+        _out << (single ? "s_" : "d_")
+             << std::string_view{buf, std::size_t(end - buf)};
+        break;
+    }
+    case ir::Ref::SYMBOL:
+        _out << '$' << m[ref.id].name;
+        break;
+    default:
+        csAssert(false, "writing an empty operand");
+    }
+}
+
+void QbeCodegen::data(const ir::Module &m, const ir::Data &data)
+{
+    // printable characters are quoted, the others are written as bytes
+    _out << (data.exported ? "export data $" : "data $")
+         << m[data.symbol].name << " = { ";
+    auto first = true;
+    for (auto &item : data.items) {
+        auto str = item.bytes;
+        while (!str.empty()) {
+            std::size_t n = 0;
+            while (n < str.size() and str[n] >= ' ' and str[n] <= '~' and
+                   str[n] != '"' and str[n] != '\\')
+                n++;
+            _out << (first ? "" : ", ");
+            if (n != 0)
+                _out << "b \"" << str.substr(0, n) << '"';
+            else
+                _out << "b " << unsigned(std::uint8_t(str[n++]));
+            str.remove_prefix(n);
+            first = false;
+        }
+        if (item.value.kind == ir::Ref::NONE)
+            continue;
+        _out << (first ? "" : ", ") << item.type << ' ';
+        if (item.type == 'z')
+            _out << item.value.integer;
+        else
+            operand(m, item.value);
+        first = false;
+    }
+    _out << " }\n\n";
+}
+
+void QbeCodegen::function(const ir::Module &m, const ir::Function &func)
+{
+    _out << (func.exported ? "export function " : "function ");
+    if (func.returns)
+        _out << name(func.ret) << ' ';
+    _out << '$' << m[func.symbol].name << '(';
+    for (std::uint32_t i = 0; i < func.params.size(); i++)
+        _out << (i == 0 ? "" : ", ") << name(func.params[i]) << " %t" << i + 1;
+    _out << ") {\n";
+
+    // the slots are allocated in the start block
+    auto code = std::span<const ir::Instr>{func.code};
+    csAssert(!code.empty() and code[0].op == ir::Op::Label,
+             "function without a start block");
+    instruction(m, func, code[0]);
+    for (auto &slot : func.slots) {
+        _out << "    %t" << slot.temp << " =l alloc" << slot.align << ' '
+             << slot.size << '\n';
+    }
+    for (auto &instr : code.subspan(1))
+        instruction(m, func, instr);
+    _out << "}\n\n";
+}
+
+void QbeCodegen::instruction(const ir::Module &m,
+                             const ir::Function &func,
+                             const ir::Instr &instr)
+{
+    using ir::Op;
+    switch (instr.op) {
+    case Op::Label:
+        _out << "@L" << instr.aux[0] << '\n';
+        return;
+    case Op::Jmp:
+        _out << "    jmp @L" << instr.aux[0] << '\n';
+        return;
+    case Op::Jnz:
+        _out << "    jnz ";
+        operand(m, instr.args[0]);
+        _out << ", @L" << instr.aux[0] << ", @L" << instr.aux[1] << '\n';
+        return;
+    case Op::Ret:
+        _out << "    ret";
+        if (instr.args[0].kind != ir::Ref::NONE) {
+            _out << ' ';
+            operand(m, instr.args[0]);
+        }
+        _out << '\n';
+        return;
+    case Op::Call: {
+        _out << "    ";
+        if (instr.dst != 0)
+            _out << "%t" << instr.dst << " =" << name(instr.cls) << ' ';
+        _out << "call ";
+        operand(m, instr.args[0]);
+        _out << '(';
+        auto args =
+            std::span{func.callArgs}.subspan(instr.aux[0], instr.aux[1]);
+        for (std::size_t i = 0; i < args.size(); i++) {
+            _out << (i == 0 ? "" : ", ") << name(args[i].cls) << ' ';
+            operand(m, args[i]);
+        }
+        _out << ")\n";
+        return;
+    }
+    default:
+        break;
+    }
+
+    // comparisons are suffixed with the class of their operands, which is
+    // the class of the instruction, and produce a word
+    _out << "    ";
+    if (ir::isComparison(instr.op)) {
+        _out << "%t" << instr.dst << " =w " << ir::toString(instr.op)
+             << name(instr.cls) << ' ';
+    }
+    else if (!ir::isStore(instr.op)) {
+        _out << "%t" << instr.dst << " =" << name(instr.cls) << ' '
+             << ir::toString(instr.op) << ' ';
+    }
+    else {
+        _out << ir::toString(instr.op) << ' ';
+    }
+    operand(m, instr.args[0]);
+    if (instr.args[1].kind != ir::Ref::NONE) {
+        _out << ", ";
+        operand(m, instr.args[1]);
+    }
+    _out << '\n';
+}
+
+} // namespace cstar
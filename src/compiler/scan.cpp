@@ -0,0 +1,294 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-03
+ */
+
+#include "compiler/scan.hpp"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#define CSTAR_SCAN_X86 1
+#endif
+
+namespace {
+
+using cstar::scan::Isa;
+
+typedef enum {
+    clsWhitespace,
+    clsIdentifier,
+    clsDigit,
+    clsStringBreak,
+    clsCommentBreak,
+    clsNewline
+} CharClass;
+
+using Kernel = std::uint32_t (*)(const char *, std::uint32_t, std::uint32_t);
+
+struct Kernels {
+    Isa isa;
+    Kernel whitespace;
+    Kernel identifier;
+    Kernel digits;
+    Kernel stringBreak;
+    Kernel commentBreak;
+    Kernel lineEnd;
+};
+
+inline bool inRange(std::uint8_t c, char lo, char hi)
+{
+    return std::uint8_t(c - lo) <= std::uint8_t(hi - lo);
+}
+
+template <CharClass C>
+inline bool matches(std::uint8_t c)
+{
+    if constexpr (C == clsWhitespace)
+        return c == ' ' or inRange(c, '\t', '\r');
+    else if constexpr (C == clsIdentifier)
+        return inRange(c | 0x20, 'a', 'z') or inRange(c, '0', '9') or
+               c == '_' or c == '$';
+    else if constexpr (C == clsDigit)
+        return inRange(c, '0', '9');
+    else if constexpr (C == clsStringBreak)
+        return c == '"' or c == '\\' or c == '$' or c == '\n';
+    else if constexpr (C == clsCommentBreak)
+        return c == '*' or c == '/';
+    else
+        return c == '\n';
+}
+
+/**
+ * Scans forward until the first byte whose membership in class `C`
+ * equals `Stop`, i.e `Stop = false` skips a run of `C` characters and
+ * `Stop = true` searches for the next `C` character
+ */
+template <CharClass C, bool Stop>
+std::uint32_t scalarScan(const char *src, std::uint32_t idx, std::uint32_t end)
+{
+    while (idx < end and matches<C>(std::uint8_t(src[idx])) != Stop)
+        idx++;
+    return idx;
+}
+
+#ifdef CSTAR_SCAN_X86
+
+inline __m128i inRange(__m128i x, char lo, char hi)
+{
+    auto t = _mm_sub_epi8(x, _mm_set1_epi8(lo));
+    return _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8(char(hi - lo))), t);
+}
+
+inline __m128i equals(__m128i x, char c)
+{
+    return _mm_cmpeq_epi8(x, _mm_set1_epi8(c));
+}
+
+template <CharClass C>
+inline __m128i classify(__m128i x)
+{
+    if constexpr (C == clsWhitespace)
+        return _mm_or_si128(equals(x, ' '), inRange(x, '\t', '\r'));
+    else if constexpr (C == clsIdentifier) {
+        auto alpha = inRange(_mm_or_si128(x, _mm_set1_epi8(0x20)), 'a', 'z');
+        auto digit = inRange(x, '0', '9');
+        auto other = _mm_or_si128(equals(x, '_'), equals(x, '$'));
+        return _mm_or_si128(_mm_or_si128(alpha, digit), other);
+    }
+    else if constexpr (C == clsDigit)
+        return inRange(x, '0', '9');
+    else if constexpr (C == clsStringBreak)
+        return _mm_or_si128(_mm_or_si128(equals(x, '"'), equals(x, '\\')),
+                            _mm_or_si128(equals(x, '$'), equals(x, '\n')));
+    else if constexpr (C == clsCommentBreak)
+        return _mm_or_si128(equals(x, '*'), equals(x, '/'));
+    else
+        return equals(x, '\n');
+}
+
+template <CharClass C, bool Stop>
+std::uint32_t sse2Scan(const char *src, std::uint32_t idx, std::uint32_t end)
+{
+    while (std::uint64_t(idx) + 16 <= end) {
+        auto x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + idx));
+        auto mask = std::uint32_t(_mm_movemask_epi8(classify<C>(x)));
+        if constexpr (!Stop)
+            mask = ~mask & 0xFFFFu;
+        if (mask)
+            return idx + __builtin_ctz(mask);
+        idx += 16;
+    }
+    return scalarScan<C, Stop>(src, idx, end);
+}
+
+__attribute__((target("avx2"))) inline __m256i inRange(__m256i x,
+                                                       char lo,
+                                                       char hi)
+{
+    auto t = _mm256_sub_epi8(x, _mm256_set1_epi8(lo));
+    return _mm256_cmpeq_epi8(
+        _mm256_min_epu8(t, _mm256_set1_epi8(char(hi - lo))), t);
+}
+
+__attribute__((target("avx2"))) inline __m256i equals(__m256i x, char c)
+{
+    return _mm256_cmpeq_epi8(x, _mm256_set1_epi8(c));
+}
+
+template <CharClass C>
+__attribute__((target("avx2"))) inline __m256i classify(__m256i x)
+{
+    if constexpr (C == clsWhitespace)
+        return _mm256_or_si256(equals(x, ' '), inRange(x, '\t', '\r'));
+    else if constexpr (C == clsIdentifier) {
+        auto alpha =
+            inRange(_mm256_or_si256(x, _mm256_set1_epi8(0x20)), 'a', 'z');
+        auto digit = inRange(x, '0', '9');
+        auto other = _mm256_or_si256(equals(x, '_'), equals(x, '$'));
+        return _mm256_or_si256(_mm256_or_si256(alpha, digit), other);
+    }
+    else if constexpr (C == clsDigit)
+        return inRange(x, '0', '9');
+    else if constexpr (C == clsStringBreak)
+        return _mm256_or_si256(
+            _mm256_or_si256(equals(x, '"'), equals(x, '\\')),
+            _mm256_or_si256(equals(x, '$'), equals(x, '\n')));
+    else if constexpr (C == clsCommentBreak)
+        return _mm256_or_si256(equals(x, '*'), equals(x, '/'));
+    else
+        return equals(x, '\n');
+}
+
+template <CharClass C, bool Stop>
+__attribute__((target("avx2"))) std::uint32_t avx2Scan(const char *src,
+                                                       std::uint32_t idx,
+                                                       std::uint32_t end)
+{
+    while (std::uint64_t(idx) + 32 <= end) {
+        auto x =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + idx));
+        auto mask = std::uint32_t(_mm256_movemask_epi8(classify<C>(x)));
+        if constexpr (!Stop)
+            mask = ~mask;
+        if (mask)
+            return idx + __builtin_ctz(mask);
+        idx += 32;
+    }
+    return sse2Scan<C, Stop>(src, idx, end);
+}
+
+#endif
+
+#define CSTAR_SCAN_KERNELS(ISA, SCAN)                                          \
+    Kernels                                                                    \
+    {                                                                          \
+        ISA, SCAN<clsWhitespace, false>, SCAN<clsIdentifier, false>,           \
+            SCAN<clsDigit, false>, SCAN<clsStringBreak, true>,                 \
+            SCAN<clsCommentBreak, true>, SCAN<clsNewline, true>                \
+    }
+
+const Kernels sScalarKernels = CSTAR_SCAN_KERNELS(cstar::scan::isaScalar,
+                                                  scalarScan);
+#ifdef CSTAR_SCAN_X86
+const Kernels sSse2Kernels = CSTAR_SCAN_KERNELS(cstar::scan::isaSse2,
+                                                sse2Scan);
+const Kernels sAvx2Kernels = CSTAR_SCAN_KERNELS(cstar::scan::isaAvx2,
+                                                avx2Scan);
+#endif
+
+#undef CSTAR_SCAN_KERNELS
+
+Isa bestIsa()
+{
+#ifdef CSTAR_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return cstar::scan::isaAvx2;
+    if (__builtin_cpu_supports("sse2"))
+        return cstar::scan::isaSse2;
+#endif
+    return cstar::scan::isaScalar;
+}
+
+const Kernels *kernelsFor(Isa isa)
+{
+    switch (isa) {
+#ifdef CSTAR_SCAN_X86
+    case cstar::scan::isaAvx2:
+        return &sAvx2Kernels;
+    case cstar::scan::isaSse2:
+        return &sSse2Kernels;
+#endif
+    default:
+        return &sScalarKernels;
+    }
+}
+
+const Kernels *sKernels = kernelsFor(bestIsa());
+
+} // namespace
+
+namespace cstar::scan {
+
+Isa isa() { return sKernels->isa; }
+
+Isa use(Isa isa)
+{
+    sKernels = kernelsFor(std::min(isa, bestIsa()));
+    return sKernels->isa;
+}
+
+std::string_view toString(Isa isa)
+{
+    switch (isa) {
+    case isaAvx2:
+        return "avx2";
+    case isaSse2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
+
+std::uint32_t whitespace(const char *src, std::uint32_t idx, std::uint32_t end)
+{
+    return sKernels->whitespace(src, idx, end);
+}
+
+std::uint32_t identifier(const char *src, std::uint32_t idx, std::uint32_t end)
+{
+    return sKernels->identifier(src, idx, end);
+}
+
+std::uint32_t digits(const char *src, std::uint32_t idx, std::uint32_t end)
+{
+    return sKernels->digits(src, idx, end);
+}
+
+std::uint32_t stringBreak(const char *src,
+                          std::uint32_t idx,
+                          std::uint32_t end)
+{
+    return sKernels->stringBreak(src, idx, end);
+}
+
+std::uint32_t commentBreak(const char *src,
+                           std::uint32_t idx,
+                           std::uint32_t end)
+{
+    return sKernels->commentBreak(src, idx, end);
+}
+
+std::uint32_t lineEnd(const char *src, std::uint32_t idx, std::uint32_t end)
+{
+    return sKernels->lineEnd(src, idx, end);
+}
+
+} // namespace cstar::scan
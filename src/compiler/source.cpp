@@ -11,13 +11,173 @@
 #include "compiler/source.hpp"
 
 #include "compiler/log.hpp"
-#include <fstream>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace cstar {
 
-Source::Source(Log &L, std::filesystem::path file)
-    : _contents(readFile(L, file)), _name{file.string()}
+SourceManager &SourceManager::get()
+{
+    static SourceManager manager{};
+    return manager;
+}
+
+SourceManager::Slice *SourceManager::slice(SourceLocation loc)
+{
+    // slices are appended in increasing base order
+    auto it = std::upper_bound(
+        _slices.begin(), _slices.end(), loc, [](auto value, auto &slice) {
+            return value < slice.base;
+        });
+    if (it == _slices.begin())
+        return nullptr;
+    --it;
+    return (loc - it->base) <= it->size ? &*it : nullptr;
+}
+
+const Source *SourceManager::find(SourceLocation loc)
 {
+    auto &self = get();
+    const std::shared_lock guard{self._lock};
+    auto slice = self.slice(loc);
+    return slice ? slice->source : nullptr;
+}
+
+SourceLocation SourceManager::add(const Source &src)
+{
+    auto &self = get();
+    const std::unique_lock guard{self._lock};
+    auto base = self._next;
+    csAssert(src.size() < std::numeric_limits<SourceLocation>::max() - base,
+             "the sources do not fit in the location space");
+    self._next = base + SourceLocation(src.size()) + 1;
+    self._slices.push_back({base, uint32_t(src.size()), &src});
+    return base;
+}
+
+void SourceManager::move(SourceLocation base, const Source &src)
+{
+    auto &self = get();
+    const std::unique_lock guard{self._lock};
+    auto slice = self.slice(base);
+    csAssert(slice and slice->base == base);
+    slice->source = &src;
+}
+
+void SourceManager::remove(SourceLocation base)
+{
+    auto &self = get();
+    const std::unique_lock guard{self._lock};
+    auto slice = self.slice(base);
+    csAssert(slice and slice->base == base);
+    slice->source = nullptr;
+}
+
+Source::Source() : _buffer(PADDING, SENTINEL)
+{
+    _contents = {_buffer.data(), 0};
+}
+
+Source::Source(std::string name, std::string contents)
+    : _name{std::move(name)}, _buffer{std::move(contents)}
+{
+    auto size = _buffer.size();
+    _buffer.append(PADDING, SENTINEL);
+    _contents = {_buffer.data(), size};
+    indexLines();
+    _base = SourceManager::add(*this);
+}
+
+Source::Source(Log &L, std::filesystem::path file) : _name{file.string()}
+{
+    readFile(L, file);
+    indexLines();
+    _base = SourceManager::add(*this);
+}
+
+Source::Source(Source &&other) noexcept { *this = std::move(other); }
+
+Source &Source::operator=(Source &&other) noexcept
+{
+    if (this != &other) {
+        unmap();
+        if (_base)
+            SourceManager::remove(_base);
+        auto size = other._contents.size();
+        _name = std::move(other._name);
+        _buffer = std::move(other._buffer);
+        _mapped = std::exchange(other._mapped, nullptr);
+        _mappedSize = std::exchange(other._mappedSize, 0);
+        _contents = {_mapped ? static_cast<const char *>(_mapped)
+                             : _buffer.data(),
+                     size};
+        _lines = std::move(other._lines);
+        other._contents = {};
+        // the locations handed out for the other source now refer to this
+        _base = std::exchange(other._base, 0);
+        if (_base)
+            SourceManager::move(_base, *this);
+    }
+    return *this;
+}
+
+Source::~Source()
+{
+    unmap();
+    if (_base)
+        SourceManager::remove(_base);
+}
+
+void Source::unmap()
+{
+    if (_mapped) {
+        munmap(_mapped, _mappedSize);
+        _mapped = nullptr;
+        _mappedSize = 0;
+    }
+}
+
+void Source::indexLines()
+{
+    // memchr is vectorized by the C library, so this runs at close to
+    // memory bandwidth even on very large sources
+    const char *begin = _contents.data();
+    const char *end = begin + _contents.size();
+    _lines.assign(1, 0);
+    _lines.reserve(_contents.size() / 32 + 1);
+    for (auto p = begin; p < end;) {
+        auto nl = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        if (nl == nullptr)
+            break;
+        p = nl + 1;
+        _lines.push_back(uint32_t(p - begin));
+    }
+}
+
+LineColumn Source::lineColumn(uint32_t offset) const
+{
+    auto it = std::upper_bound(_lines.begin(), _lines.end(), offset);
+    auto line = uint32_t(std::distance(_lines.begin(), it) - 1);
+    return {line, offset - _lines[line]};
+}
+
+std::pair<uint32_t, uint32_t> Source::lineBounds(uint32_t line) const
+{
+    csAssert(line < _lines.size());
+    auto start = _lines[line];
+    auto end = (line + 1 < _lines.size()) ? _lines[line + 1] - 1
+                                          : uint32_t(_contents.size());
+    return {start, end};
 }
 
 const char &Source::operator[](uint32_t index) const
@@ -32,24 +192,79 @@ const char *Source::at(uint32_t index) const
     return _contents.data() + std::min(index, uint32_t(_contents.size()));
 }
 
-std::string Source::readFile(Log &L, const std::filesystem::path &fname)
+void Source::readFile(Log &L, const std::filesystem::path &fname)
 {
-    std::ifstream f;
-    f.open(fname);
-    if (!f) {
-        L.error({}, "could not open file '", fname, "'");
+    auto fd = ::open(fname.c_str(), O_RDONLY);
+    struct stat st {};
+    if (fd < 0 or ::fstat(fd, &st) != 0) {
+        if (fd >= 0)
+            ::close(fd);
+        L.error({}, Diag::CannotOpenFile, fname.string());
         abortCompiler(L);
     }
 
-    f.seekg(0, std::ios::end);
-    std::string contents;
-    contents.reserve(f.tellg());
-    f.seekg(0, std::ios::beg);
-    contents.assign(std::istreambuf_iterator<char>(f),
-                    std::istreambuf_iterator<char>());
-    f.close();
+    auto size = std::size_t(st.st_size);
+    if (size >= MMAP_THRESHOLD and mapFile(fd, size)) {
+        ::close(fd);
+        return;
+    }
+
+    _buffer.resize(size + PADDING, SENTINEL);
+    std::size_t offset = 0;
+    while (offset < size) {
+        auto n = ::read(fd, _buffer.data() + offset, size - offset);
+        if (n < 0 and errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        offset += n;
+    }
+    ::close(fd);
+
+    if (offset != size) {
+        L.error({}, Diag::CannotReadFile, fname.string());
+        abortCompiler(L);
+    }
+    _contents = {_buffer.data(), size};
+}
+
+bool Source::mapFile(int fd, std::size_t size)
+{
+    auto page = std::size_t(::sysconf(_SC_PAGESIZE));
+    auto fileSize = (size + page - 1) & ~(page - 1);
+    auto total = (size + PADDING + page - 1) & ~(page - 1);
+
+    // reserve room for the file and its padding then map the file over the
+    // start of the reservation, the padding either lands in the zero filled
+    // tail of the file's last page or in the anonymous pages after it
+    auto base = ::mmap(nullptr,
+                       total,
+                       PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS,
+                       -1,
+                       0);
+    if (base == MAP_FAILED)
+        return false;
+
+    auto flags = MAP_PRIVATE | MAP_FIXED;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;
+#endif
+    if (::mmap(base, fileSize, PROT_READ | PROT_WRITE, flags, fd, 0) ==
+        MAP_FAILED) {
+        ::munmap(base, total);
+        return false;
+    }
+    ::madvise(base, fileSize, MADV_SEQUENTIAL);
+
+    auto data = static_cast<char *>(base);
+    std::memset(data + size, SENTINEL, PADDING);
+    ::mprotect(base, total, PROT_READ);
 
-    return contents;
+    _mapped = base;
+    _mappedSize = total;
+    _contents = {data, size};
+    return true;
 }
 
 } // namespace cstar
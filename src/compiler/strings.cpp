@@ -1,28 +1,170 @@
 /**
- * Copyright (c) 2022 suilteam, Carter 
+ * Copyright (c) 2022 suilteam, Carter
  *
  * This library is free software; you can redistribute it and/or modify it
  * under the terms of the MIT license. See LICENSE for details.
- * 
+ *
  * @author Mpho Mbotho
  * @date 2022-11-26
  */
 
 #include "compiler/strings.hpp"
 
+#include "compiler/arena.hpp"
+#include "compiler/log.hpp"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <functional>
+#include <mutex>
+#include <vector>
+
 namespace cstar {
 
-    Strings::StringsImpl Strings::_impl{};
+namespace {
+
+constexpr unsigned SHARD_BITS = 4;
+constexpr unsigned INDEX_BITS = 32 - SHARD_BITS;
+constexpr std::uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+
+/**
+ * Entries live in pages which double in size, the first page holds
+ * 2^FIRST_PAGE_BITS entries and there are enough pages for every index
+ */
+constexpr unsigned FIRST_PAGE_BITS = 10;
+constexpr unsigned PAGES = INDEX_BITS - FIRST_PAGE_BITS + 1;
+
+constexpr std::uint32_t EMPTY = ~std::uint32_t(0);
+constexpr std::uint32_t INITIAL_SLOTS = 1024;
 
-    std::string_view Strings::StringsImpl::intern(std::string str)
+struct Entry {
+    const char *data;
+    std::uint32_t size;
+    std::uint32_t hash;
+};
+
+struct Location {
+    unsigned page;
+    std::uint32_t offset;
+};
+
+inline Location locate(std::uint32_t index)
+{
+    const auto biased = index + (1u << FIRST_PAGE_BITS);
+    const auto page = unsigned(std::bit_width(biased)) - 1;
+    return {page - FIRST_PAGE_BITS, biased - (1u << page)};
+}
+
+class Shard {
+public:
+    Shard() : _slots(INITIAL_SLOTS) {}
+
+    std::uint32_t insert(std::string_view str, std::uint32_t hash)
     {
-        auto key = std::string_view{str};
-        auto it = _strings.emplace(key, std::move(str));
-        return it.first->second;
+        const std::lock_guard guard{_lock};
+        auto mask = std::uint32_t(_slots.size() - 1);
+        auto i = hash & mask;
+        for (; _slots[i].index != EMPTY; i = (i + 1) & mask) {
+            auto &slot = _slots[i];
+            if (slot.hash == hash) {
+                auto &entry = at(slot.index);
+                if (std::string_view{entry.data, entry.size} == str)
+                    return slot.index;
+            }
+        }
+
+        csAssert(_count < INDEX_MASK, "too many interned strings");
+        const auto index = _count++;
+        auto [page, offset] = locate(index);
+        auto entries = _pages[page].load(std::memory_order_relaxed);
+        if (entries == nullptr) {
+            const auto size = std::size_t(1) << (page + FIRST_PAGE_BITS);
+            entries = static_cast<Entry *>(
+                _bytes.allocate(size * sizeof(Entry), alignof(Entry)));
+            _pages[page].store(entries, std::memory_order_release);
+        }
+        entries[offset] = {
+            _bytes.copy(str).data(), std::uint32_t(str.size()), hash};
+
+        _slots[i] = {hash, index};
+        if (_count * 4 > _slots.size() * 3)
+            grow();
+
+        return index;
     }
 
-    std::string_view Strings::StringsImpl::intern(std::string_view str)
+    const Entry &at(std::uint32_t index) const
     {
-        return intern(std::string{str});
+        auto [page, offset] = locate(index);
+        return _pages[page].load(std::memory_order_acquire)[offset];
     }
-}
\ No newline at end of file
+
+private:
+    struct Slot {
+        std::uint32_t hash{0};
+        std::uint32_t index{EMPTY};
+    };
+
+    void grow()
+    {
+        std::vector<Slot> slots(_slots.size() * 2);
+        const auto mask = std::uint32_t(slots.size() - 1);
+        for (auto &slot : _slots) {
+            if (slot.index == EMPTY)
+                continue;
+            auto i = slot.hash & mask;
+            while (slots[i].index != EMPTY)
+                i = (i + 1) & mask;
+            slots[i] = slot;
+        }
+        _slots = std::move(slots);
+    }
+
+    std::mutex _lock{};
+    /** the bytes of the strings and the pages of entries */
+    Arena _bytes{};
+    std::array<std::atomic<Entry *>, PAGES> _pages{};
+    std::vector<Slot> _slots;
+    std::uint32_t _count{0};
+};
+
+/**
+ * Constructed on first use, the interner can be used while other static
+ * objects are initialized
+ */
+std::array<Shard, 1u << SHARD_BITS> &shards()
+{
+    static std::array<Shard, 1u << SHARD_BITS> shards{};
+    return shards;
+}
+
+} // namespace
+
+std::uint32_t Strings::hash(std::string_view str)
+{
+    const auto hash = std::hash<std::string_view>{}(str);
+    return std::uint32_t(hash ^ (std::uint64_t(hash) >> 32));
+}
+
+Strings::Id Strings::id(std::string_view str)
+{
+    // the top bits of the hash pick the shard and the bottom bits the
+    // slot within it
+    const auto hash = Strings::hash(str);
+    const auto shard = hash >> INDEX_BITS;
+    return (shard << INDEX_BITS) | shards()[shard].insert(str, hash);
+}
+
+std::string_view Strings::get(Id id)
+{
+    auto &entry = shards()[id >> INDEX_BITS].at(id & INDEX_MASK);
+    return {entry.data, entry.size};
+}
+
+std::uint32_t Strings::hash(Id id)
+{
+    return shards()[id >> INDEX_BITS].at(id & INDEX_MASK).hash;
+}
+
+} // namespace cstar
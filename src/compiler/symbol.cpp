@@ -13,60 +13,129 @@
 
 namespace cstar {
 
-bool SymbolTable::define(std::string_view name,
+namespace {
+constexpr std::uint32_t INITIAL_SLOTS = 64;
+
+/** fibonacci hashing, spreads the sequential interned ids over the slots */
+inline std::uint32_t hash(Strings::Id name)
+{
+    return std::uint32_t((std::uint64_t(name) * 0x9E3779B97F4A7C15ull) >> 32);
+}
+} // namespace
+
+SymbolTable::SymbolTable() : _slots(INITIAL_SLOTS) {}
+
+std::uint32_t SymbolTable::binding(Strings::Id name) const
+{
+    const auto mask = std::uint32_t(_slots.size() - 1);
+    for (auto i = hash(name) & mask;; i = (i + 1) & mask) {
+        auto &slot = _slots[i];
+        if (slot.name == name)
+            return slot.binding;
+        if (slot.name == NONE)
+            return NONE;
+    }
+}
+
+SymbolTable::Slot &SymbolTable::slot(Strings::Id name)
+{
+    const auto mask = std::uint32_t(_slots.size() - 1);
+    for (auto i = hash(name) & mask;; i = (i + 1) & mask) {
+        auto &slot = _slots[i];
+        if (slot.name == name)
+            return slot;
+        if (slot.name == NONE) {
+            // names are never removed, their slot is kept for the next
+            // binding
+            slot.name = name;
+            _used++;
+            return slot;
+        }
+    }
+}
+
+void SymbolTable::grow()
+{
+    auto slots = std::exchange(_slots, std::vector<Slot>(_slots.size() * 2));
+    const auto mask = std::uint32_t(_slots.size() - 1);
+    for (auto &old : slots) {
+        if (old.name == NONE)
+            continue;
+        auto i = hash(old.name) & mask;
+        while (_slots[i].name != NONE)
+            i = (i + 1) & mask;
+        _slots[i] = old;
+    }
+}
+
+bool SymbolTable::define(Strings::Id name,
                          Node::Ptr sym,
                          Range range,
                          SymbolKind kind)
 {
-    auto it = _symbols.find(name);
-    if (it == _symbols.end()) {
-        _symbols.emplace(
-            name, Symbol<>{kind, std::move(range), std::move(sym), this});
-        return true;
-    }
-    return false;
+    if ((_used + 1) * 4 > _slots.size() * 3)
+        grow();
+
+    auto &slot = this->slot(name);
+    if (slot.binding != NONE and
+        _bindings[slot.binding].symbol.scope == depth())
+        return false;
+
+    _bindings.push_back(
+        {Symbol<>{kind, std::move(range), sym, depth()}, name, slot.binding});
+    slot.binding = std::uint32_t(_bindings.size() - 1);
+    return true;
 }
 
-Symbol<> SymbolTable::find(std::string_view name, int depth)
+const Symbol<> *SymbolTable::find(Strings::Id name, int depth) const
 {
     if (depth < 0)
-        return {};
-    auto it = _symbols.find(name);
-    if (it != _symbols.end())
-        return it->second;
-    if (_enclosing)
-        return _enclosing->find(name, depth - 1);
-
-    return {};
+        return nullptr;
+
+    auto index = binding(name);
+    if (index == NONE)
+        return nullptr;
+
+    // the innermost binding shadows all the others, if it is out of
+    // reach so are they
+    auto &symbol = _bindings[index].symbol;
+    if (symbol.scope + std::uint32_t(depth) < this->depth())
+        return nullptr;
+    return &symbol;
 }
 
-bool SymbolTable::assign(std::string_view name, Node::Ptr value)
+bool SymbolTable::assign(Strings::Id name, Node::Ptr value)
 {
-    auto scope = this;
-    for (auto i = 0; ((i <= MAX_LOOKUP_DEPTH) && (scope != nullptr)); i++) {
-        auto it = scope->_symbols.find(name);
-        if (it != scope->_symbols.end()) {
-            it->second.value = std::move(value);
-            return true;
-        }
-    }
-    return false;
+    auto index = binding(name);
+    if (index == NONE)
+        return false;
+
+    _bindings[index].symbol.value = value;
+    return true;
 }
 
-SymbolTableScope::SymbolTableScope(SymbolTable::Ptr root)
-    : _table{std::move(root)}
+void SymbolTable::push()
 {
+    _scopes.push_back(std::uint32_t(_bindings.size()));
 }
 
-void SymbolTableScope::push()
+void SymbolTable::pop()
 {
-    _table = std::make_shared<SymbolTable>(_table);
+    csAssert(!_scopes.empty(), "Popping to unknown scope");
+    const auto mark = _scopes.back();
+    _scopes.pop_back();
+
+    // replay the undo log, restoring the bindings shadowed by the scope
+    while (_bindings.size() > mark) {
+        auto &binding = _bindings.back();
+        slot(binding.name).binding = binding.shadowed;
+        _bindings.pop_back();
+    }
 }
 
-void SymbolTableScope::pop()
+SymbolTableScope::SymbolTableScope(SymbolTable::Ptr root)
+    : _table{std::move(root)}
 {
-    _table = _table->enclosing();
-    csAssert(_table, "Popping to unknown scope");
 }
 
 SymbolTable &SymbolTableScope::table()
@@ -74,4 +143,4 @@ SymbolTable &SymbolTableScope::table()
     csAssert(_table);
     return *_table;
 }
-} // namespace cstar
\ No newline at end of file
+} // namespace cstar
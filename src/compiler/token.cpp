@@ -18,19 +18,11 @@ namespace cstar {
 
     Token Token::split(Kind thisKind, Kind nextKind)
     {
-        csAssert(_range.size() >= 2);
+        csAssert(_length >= 2);
         kind = thisKind;
-        auto nextEnd = _range.end;
-        auto nextPos = _range.position;
-        _range.end = _range.start+1;
-        if (_range.source()[_range.end] == '\n') {
-            nextPos.line++;
-        }
-        else {
-            nextPos.column++;
-        }
-
-        return {nextKind, Range(_range.source(), _range.start + 1, nextEnd, nextPos)};
+        auto nextLength = std::uint32_t(_length - 1);
+        _length = 1;
+        return {nextKind, start + 1, nextLength};
     }
 
     bool Token::isComptimeLiteral(Kind kind)
@@ -127,7 +119,7 @@ std::ostream& operator<<(std::ostream& os, const cstar::Token& tok)
             os << "<string: " << tok.value<std::string_view>() << ">";
             break;
         case cstar::Token::IDENTIFIER:
-            os << "<ident: " << tok.range().toString() << ">";
+            os << "<ident: " << tok.value<std::string_view>() << ">";
             break;
         default:
             os << tok.toString();
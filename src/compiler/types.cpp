@@ -14,6 +14,6 @@ namespace cstar {
 
     bool Type::isAssignable(const Type::Ptr from)
     {
-        return this == from.get();
+        return this == from;
     }
 }
\ No newline at end of file
@@ -0,0 +1,159 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-10
+ */
+
+#include "compiler/writer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+
+#include <limits.h>
+#include <sys/uio.h>
+
+namespace cstar {
+
+namespace {
+
+#ifdef IOV_MAX
+constexpr std::size_t MAX_IOVECS = IOV_MAX;
+#else
+constexpr std::size_t MAX_IOVECS = 1024;
+#endif
+
+constexpr auto Spaces = [] {
+    std::array<char, CodeWriter::MAX_INDENT> spaces{};
+    spaces.fill(' ');
+    return spaces;
+}();
+
+} // namespace
+
+CodeWriter &CodeWriter::indent(std::size_t n)
+{
+    for (; n > MAX_INDENT; n -= MAX_INDENT)
+        *this << std::string_view{Spaces.data(), MAX_INDENT};
+    return *this << std::string_view{Spaces.data(), n};
+}
+
+CodeWriter &CodeWriter::operator<<(const CodeWriter &other)
+{
+    for (std::size_t i = 0; i < other._used; i++)
+        append(other.chunk(i));
+    return *this;
+}
+
+CodeWriter &CodeWriter::append(std::string_view str)
+{
+    // fill the current chunk up to its end, chunks are always full
+    // except for the last one
+    for (;;) {
+        auto n = std::min(str.size(), std::size_t(_end - _cursor));
+        std::memcpy(_cursor, str.data(), n);
+        _cursor += n;
+        str.remove_prefix(n);
+        if (str.empty())
+            return *this;
+        grow();
+    }
+}
+
+void CodeWriter::grow()
+{
+    if (_used == _chunks.size())
+        _chunks.push_back(std::make_unique<char[]>(CHUNK_SIZE));
+    _cursor = _chunks[_used++].get();
+    _end = _cursor + CHUNK_SIZE;
+}
+
+std::size_t CodeWriter::size() const
+{
+    return (_used - 1) * CHUNK_SIZE +
+           std::size_t(_cursor - _chunks[_used - 1].get());
+}
+
+std::string_view CodeWriter::chunk(std::size_t i) const
+{
+    auto size = (i + 1 == _used) ? std::size_t(_cursor - _chunks[i].get())
+                                 : CHUNK_SIZE;
+    return {_chunks[i].get(), size};
+}
+
+bool CodeWriter::flush(int fd)
+{
+    std::vector<iovec> iovs;
+    iovs.reserve(_used);
+    for (std::size_t i = 0; i < _used; i++) {
+        auto data = chunk(i);
+        iovs.push_back({const_cast<char *>(data.data()), data.size()});
+    }
+    clear();
+
+    auto iov = iovs.data();
+    auto count = iovs.size();
+    while (count) {
+        auto n = ::writev(fd, iov, int(std::min(count, MAX_IOVECS)));
+        if (n < 0 and errno == EINTR)
+            continue;
+        if (n < 0)
+            return false;
+
+        // skip what was written, the last buffer can be partially written
+        auto written = std::size_t(n);
+        while (count and written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count) {
+            iov->iov_base = static_cast<char *>(iov->iov_base) + written;
+            iov->iov_len -= written;
+        }
+    }
+    return true;
+}
+
+bool CodeWriter::flush(std::FILE *file)
+{
+    auto ok = true;
+    for (std::size_t i = 0; ok and i < _used; i++) {
+        auto data = chunk(i);
+        ok = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    }
+    clear();
+    return ok;
+}
+
+void CodeWriter::flush(std::ostream &os)
+{
+    for (std::size_t i = 0; os and i < _used; i++) {
+        auto data = chunk(i);
+        os.write(data.data(), std::streamsize(data.size()));
+    }
+    clear();
+}
+
+std::string CodeWriter::str() const
+{
+    std::string str;
+    str.reserve(size());
+    for (std::size_t i = 0; i < _used; i++)
+        str.append(chunk(i));
+    return str;
+}
+
+void CodeWriter::clear()
+{
+    // the chunks are kept, and still hold what was written, until they
+    // are written again
+    _used = 0;
+    grow();
+}
+
+} // namespace cstar
@@ -0,0 +1,1415 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-13
+ */
+
+#include "compiler/x86.hpp"
+
+#include "compiler/log.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <span>
+
+namespace cstar {
+
+namespace {
+
+using ir::Cls;
+using ir::Op;
+using ir::Ref;
+
+/**
+ * The registers, numbered as they are encoded. XMM registers are numbered
+ * from 16 so that the low 4 bits are their number.
+ */
+enum Reg : std::uint8_t {
+    RAX,
+    RCX,
+    RDX,
+    RBX,
+    RSP,
+    RBP,
+    RSI,
+    RDI,
+    R8,
+    R9,
+    R10,
+    R11,
+    R12,
+    R13,
+    R14,
+    R15,
+    XMM0,
+    XMM14 = XMM0 + 14,
+    XMM15,
+    NO_REG = 0xFF
+};
+
+/** the conditions of `jcc` and `setcc` */
+enum Cond : std::uint8_t {
+    CC_B = 0x2,
+    CC_AE = 0x3,
+    CC_E = 0x4,
+    CC_NE = 0x5,
+    CC_BE = 0x6,
+    CC_A = 0x7,
+    CC_S = 0x8,
+    CC_P = 0xA,
+    CC_NP = 0xB,
+    CC_L = 0xC,
+    CC_GE = 0xD,
+    CC_LE = 0xE,
+    CC_G = 0xF
+};
+
+/**
+ * RAX, RCX, RDX and R11 are the scratch registers of instructions, as
+ * are XMM14 and XMM15, none of them is allocated
+ */
+constexpr Reg CALLER_SAVED[] = {RSI, RDI, R8, R9, R10};
+constexpr Reg CALLEE_SAVED[] = {RBX, R12, R13, R14, R15};
+constexpr unsigned FLOAT_REGS = 14;
+
+constexpr Reg INT_ARGS[] = {RDI, RSI, RDX, RCX, R8, R9};
+constexpr unsigned FLOAT_ARGS = 8;
+
+constexpr std::uint32_t NO_SYMBOL = ~std::uint32_t(0);
+constexpr std::uint32_t NONE = ~std::uint32_t(0);
+
+bool isXmm(Reg reg) { return reg >= XMM0 and reg != NO_REG; }
+
+bool isCalleeSaved(Reg reg)
+{
+    return std::find(std::begin(CALLEE_SAVED), std::end(CALLEE_SAVED), reg) !=
+           std::end(CALLEE_SAVED);
+}
+
+/** the prefix selecting the scalar single or double form of SSE */
+std::uint8_t sse(Cls cls) { return cls == Cls::S ? 0xF3 : 0xF2; }
+
+std::uint64_t bits(const Ref &ref)
+{
+    if (ref.cls == Cls::S)
+        return std::bit_cast<std::uint32_t>(float(ref.real));
+    return std::bit_cast<std::uint64_t>(ref.real);
+}
+
+/**
+ * An operand in memory: a displacement from a base register, or the
+ * address of a symbol relative to the instruction pointer
+ */
+struct Mem {
+    Reg base{RBP};
+    std::int32_t disp{0};
+    /** the symbol of the module, `NO_SYMBOL` for a base register */
+    std::uint32_t symbol{NO_SYMBOL};
+};
+
+/**
+ * Encodes instructions, see the Intel SDM volume 2 for their formats.
+ * Opcodes are given as a number whose bytes are written in order, the
+ * registers of the ModRM byte either as registers or as the extension of
+ * the opcode.
+ */
+class Assembler {
+public:
+    struct Relocation {
+        std::size_t offset{0};
+        std::uint32_t symbol{0};
+        ElfObject::Relocation type{ElfObject::R_X86_64_PC32};
+    };
+
+    explicit Assembler(std::vector<std::uint8_t> &code) : _code{code} {}
+
+    std::size_t offset() const { return _code.size(); }
+    void byte(std::uint8_t b) { _code.push_back(b); }
+
+    void u32(std::uint32_t value)
+    {
+        for (int i = 0; i < 4; i++, value >>= 8)
+            byte(std::uint8_t(value));
+    }
+
+    void u64(std::uint64_t value)
+    {
+        u32(std::uint32_t(value));
+        u32(std::uint32_t(value >> 32));
+    }
+
+    void patch32(std::size_t at, std::uint32_t value)
+    {
+        for (int i = 0; i < 4; i++, value >>= 8)
+            _code[at + i] = std::uint8_t(value);
+    }
+
+    /**
+     * Makes the 32-bit relative jump at `at` jump to `target`
+     */
+    void link(std::size_t at, std::size_t target)
+    {
+        patch32(at, std::uint32_t(std::int64_t(target) - std::int64_t(at + 4)));
+    }
+
+    /**
+     * An instruction with two register operands, `bytes` when it uses the
+     * low byte of its registers
+     */
+    void rr(std::uint8_t prefix,
+            bool wide,
+            std::uint32_t opcode,
+            unsigned reg,
+            unsigned rm,
+            bool bytes = false)
+    {
+        prefixes(prefix, wide, reg, rm, bytes);
+        op(opcode);
+        byte(std::uint8_t(0xC0 | (reg & 7) << 3 | (rm & 7)));
+    }
+
+    /**
+     * An instruction with a register and a memory operand
+     */
+    void rm(std::uint8_t prefix,
+            bool wide,
+            std::uint32_t opcode,
+            unsigned reg,
+            const Mem &mem,
+            bool bytes = false)
+    {
+        if (mem.symbol != NO_SYMBOL) {
+            prefixes(prefix, wide, reg, 0, bytes);
+            op(opcode);
+            byte(std::uint8_t((reg & 7) << 3 | 5));
+            relocations.push_back({offset(), mem.symbol});
+            u32(0);
+            return;
+        }
+
+        prefixes(prefix, wide, reg, mem.base, bytes);
+        op(opcode);
+        const auto small = mem.disp >= -128 and mem.disp <= 127;
+        byte(std::uint8_t((small ? 0x40 : 0x80) | (reg & 7) << 3 |
+                          (mem.base & 7)));
+        if ((mem.base & 7) == RSP)
+            byte(0x24);
+        if (small)
+            byte(std::uint8_t(mem.disp));
+        else
+            u32(std::uint32_t(mem.disp));
+    }
+
+    void mov(Reg reg, bool wide, std::int64_t value)
+    {
+        if (!wide or (value >= 0 and value <= 0xFFFFFFFF)) {
+            // writing the low half zeroes the high one
+            prefixes(0, false, 0, reg, false);
+            byte(std::uint8_t(0xB8 + (reg & 7)));
+            u32(std::uint32_t(value));
+        }
+        else if (value >= INT32_MIN and value <= INT32_MAX) {
+            rr(0, true, 0xC7, 0, reg);
+            u32(std::uint32_t(value));
+        }
+        else {
+            prefixes(0, true, 0, reg, false);
+            byte(std::uint8_t(0xB8 + (reg & 7)));
+            u64(std::uint64_t(value));
+        }
+    }
+
+    void push(Reg reg)
+    {
+        prefixes(0, false, 0, reg, false);
+        byte(std::uint8_t(0x50 + (reg & 7)));
+    }
+
+    void pop(Reg reg)
+    {
+        prefixes(0, false, 0, reg, false);
+        byte(std::uint8_t(0x58 + (reg & 7)));
+    }
+
+    /**
+     * @return the offset of the displacement to link
+     */
+    std::size_t jmp()
+    {
+        byte(0xE9);
+        u32(0);
+        return offset() - 4;
+    }
+
+    std::size_t jcc(Cond cond)
+    {
+        byte(0x0F);
+        byte(0x80 | cond);
+        u32(0);
+        return offset() - 4;
+    }
+
+    void call(std::uint32_t symbol)
+    {
+        byte(0xE8);
+        relocations.push_back(
+            {offset(), symbol, ElfObject::R_X86_64_PLT32});
+        u32(0);
+    }
+
+    std::vector<Relocation> relocations{};
+
+private:
+    void prefixes(std::uint8_t prefix,
+                  bool wide,
+                  unsigned reg,
+                  unsigned base,
+                  bool bytes)
+    {
+        if (prefix)
+            byte(prefix);
+        // a REX prefix is also needed for the low byte of RSP to RDI
+        auto rex = std::uint8_t(0x40 | wide << 3 | (reg & 8) >> 1 |
+                                (base & 8) >> 3);
+        if (rex != 0x40 or
+            (bytes and ((reg & 15) >= 4 or (base & 15) >= 4)))
+            byte(rex);
+    }
+
+    void op(std::uint32_t opcode)
+    {
+        if (opcode > 0xFF)
+            byte(std::uint8_t(opcode >> 8));
+        byte(std::uint8_t(opcode));
+    }
+
+    std::vector<std::uint8_t> &_code;
+};
+
+} // namespace
+
+class X86Codegen::Compiler {
+public:
+    explicit Compiler(X86Codegen &codegen)
+        : _codegen{codegen}, _as{codegen._object.text()}
+    {
+    }
+
+    void compile(const ir::Module &m, const ir::Function &func);
+
+private:
+    /** what a temporary holds */
+    typedef enum : std::uint8_t { VALUE, SLOT, PARAM } Kind;
+
+    struct Block {
+        std::uint32_t first{0};
+        std::uint32_t last{0};
+        std::array<std::uint32_t, 2> succ{NONE, NONE};
+    };
+
+    struct Interval {
+        std::uint32_t temp{0};
+        std::uint32_t start{0};
+        std::uint32_t end{0};
+        bool crossesCall{false};
+    };
+
+    /**
+     * A temporary lives in a register or in the frame, at an offset from
+     * RBP. The temporaries of slots are the address of their slot.
+     */
+    struct Location {
+        Reg reg{NO_REG};
+        bool address{false};
+        std::int32_t offset{0};
+    };
+
+    template <typename F>
+    void uses(const ir::Instr &instr, F f) const;
+
+    void analyze();
+    void liveness();
+    void intervals();
+    void allocate();
+    void layout();
+
+    void prologue();
+    void epilogue();
+    void instruction(std::size_t i);
+    void call(const ir::Instr &instr);
+    /**
+     * @return true if the given label starts the block after instruction i
+     */
+    bool follows(std::size_t i, std::uint32_t label) const;
+    void jump(std::size_t i, std::uint32_t label);
+
+    /**
+     * Loads an operand of the given class to a register
+     */
+    void load(const Ref &ref, Reg reg, Cls cls);
+    /**
+     * Moves a register to the location of a temporary
+     */
+    void store(std::uint32_t temp, Reg reg, Cls cls);
+    /**
+     * @return the register of the given temporary, or the scratch register
+     * of its class when it lives in the frame
+     */
+    Reg target(std::uint32_t temp, Cls cls) const;
+    /**
+     * @return the memory at the address in the given operand, R11 holds
+     * addresses computed at run time
+     */
+    Mem address(const Ref &ref);
+
+    void move(Cls cls, Reg dst, Reg src);
+    void load(Cls cls, Reg reg, const Mem &mem);
+    void store(Cls cls, const Mem &mem, Reg reg);
+    void setcc(Cond cond, Reg reg = RAX);
+
+    void arithmetic(const ir::Instr &instr);
+    void compare(const ir::Instr &instr);
+    void convert(const ir::Instr &instr);
+    void memory(const ir::Instr &instr);
+
+    X86Codegen &_codegen;
+    Assembler _as;
+    const ir::Module *_m{nullptr};
+    const ir::Function *_fn{nullptr};
+
+    std::vector<Kind> _kinds{};
+    std::vector<Block> _blocks{};
+    std::vector<std::uint32_t> _labelBlocks{};
+    /** the index of the temporaries live across blocks, NONE for others */
+    std::vector<std::uint32_t> _globals{};
+    std::uint32_t _globalCount{0};
+    std::size_t _words{0};
+    std::vector<std::uint64_t> _use{}, _def{}, _in{}, _out{};
+    /** the number of calls before each instruction */
+    std::vector<std::uint32_t> _calls{};
+
+    std::vector<Interval> _intervals{};
+    std::vector<Location> _locations{};
+    std::vector<std::uint32_t> _spilled{};
+    std::vector<Reg> _saved{};
+    std::uint32_t _frame{0};
+    std::uint32_t _outgoing{0};
+
+    std::vector<std::size_t> _labels{};
+    /** the jumps to link to labels, with their label */
+    std::vector<std::pair<std::size_t, std::uint32_t>> _jumps{};
+};
+
+template <typename F>
+void X86Codegen::Compiler::uses(const ir::Instr &instr, F f) const
+{
+    // only the values are allocated, slots and parameters have a fixed
+    // place in the frame
+    auto use = [&](const Ref &ref) {
+        if (ref.kind == Ref::TEMP and _kinds[ref.id] == VALUE)
+            f(ref.id);
+    };
+    if (instr.op == Op::Call) {
+        for (auto &arg :
+             std::span{_fn->callArgs}.subspan(instr.aux[0], instr.aux[1]))
+            use(arg);
+        return;
+    }
+    use(instr.args[0]);
+    use(instr.args[1]);
+}
+
+void X86Codegen::Compiler::compile(const ir::Module &m,
+                                   const ir::Function &func)
+{
+    _m = &m;
+    _fn = &func;
+    analyze();
+    liveness();
+    intervals();
+    allocate();
+    layout();
+
+    // functions are aligned like the C compiler aligns them, the padding
+    // is never executed
+    auto &text = _codegen._object.text();
+    while (text.size() % 16)
+        text.push_back(0xCC);
+    const auto start = _as.offset();
+
+    _labels.assign(func.labels, 0);
+    _jumps.clear();
+    _as.relocations.clear();
+    prologue();
+    for (std::size_t i = 0; i < func.code.size(); i++)
+        instruction(i);
+
+    for (auto [at, label] : _jumps)
+        _as.link(at, _labels[label]);
+    for (auto &rel : _as.relocations) {
+        // displacements are relative to the end of the instruction, which
+        // is always the end of the displacement
+        _codegen._object.relocate(ElfObject::Section::Text,
+                                  rel.offset,
+                                  _codegen.symbol(m, rel.symbol),
+                                  rel.type,
+                                  -4);
+    }
+    _codegen._object.define(_codegen.symbol(m, func.symbol),
+                            ElfObject::Section::Text,
+                            start,
+                            _as.offset() - start,
+                            func.exported,
+                            true);
+}
+
+void X86Codegen::Compiler::analyze()
+{
+    auto &code = _fn->code;
+    const auto temps = _fn->temps.size();
+    _kinds.assign(temps, VALUE);
+    for (std::size_t t = 1; t <= _fn->params.size(); t++)
+        _kinds[t] = PARAM;
+    for (auto &slot : _fn->slots)
+        _kinds[slot.temp] = SLOT;
+
+    // blocks start at labels, the first instruction is always one
+    _blocks.clear();
+    _labelBlocks.assign(_fn->labels, NONE);
+    _calls.resize(code.size() + 1);
+    _calls[0] = 0;
+    _outgoing = 0;
+    for (std::uint32_t i = 0; i < code.size(); i++) {
+        auto &instr = code[i];
+        if (instr.op == Op::Label) {
+            if (!_blocks.empty())
+                _blocks.back().last = i - 1;
+            _labelBlocks[instr.aux[0]] = std::uint32_t(_blocks.size());
+            _blocks.push_back({i, i});
+        }
+        _calls[i + 1] = _calls[i] + (instr.op == Op::Call);
+        if (instr.op == Op::Call)
+            _outgoing = std::max(_outgoing, instr.aux[1] * 8);
+    }
+    csAssert(!_blocks.empty(), "function without a start block");
+    _blocks.back().last = std::uint32_t(code.size() - 1);
+
+    for (std::uint32_t b = 0; b < _blocks.size(); b++) {
+        auto &block = _blocks[b];
+        auto &last = code[block.last];
+        if (last.op == Op::Jmp)
+            block.succ = {_labelBlocks[last.aux[0]], NONE};
+        else if (last.op == Op::Jnz)
+            block.succ = {_labelBlocks[last.aux[0]], _labelBlocks[last.aux[1]]};
+        else if (last.op != Op::Ret and b + 1 < _blocks.size())
+            block.succ = {b + 1, NONE};
+    }
+
+    // most temporaries are used in the block defining them, only those
+    // used in another block need their liveness computed
+    _globals.assign(temps, NONE);
+    _globalCount = 0;
+    std::vector<std::uint32_t> defined(temps, NONE);
+    for (std::uint32_t b = 0; b < _blocks.size(); b++) {
+        for (auto i = _blocks[b].first; i <= _blocks[b].last; i++) {
+            uses(code[i], [&](std::uint32_t t) {
+                if (defined[t] != b and _globals[t] == NONE)
+                    _globals[t] = _globalCount++;
+            });
+            if (code[i].dst != 0)
+                defined[code[i].dst] = b;
+        }
+    }
+}
+
+void X86Codegen::Compiler::liveness()
+{
+    auto &code = _fn->code;
+    const auto blocks = _blocks.size();
+    _words = (_globalCount + 63) / 64;
+    _use.assign(blocks * _words, 0);
+    _def.assign(blocks * _words, 0);
+    _in.assign(blocks * _words, 0);
+    _out.assign(blocks * _words, 0);
+    if (_words == 0)
+        return;
+
+    auto set = [&](std::vector<std::uint64_t> &bits, std::size_t b, auto i) {
+        bits[b * _words + i / 64] |= std::uint64_t(1) << (i % 64);
+    };
+    auto test = [&](std::vector<std::uint64_t> &bits, std::size_t b, auto i) {
+        return (bits[b * _words + i / 64] >> (i % 64)) & 1;
+    };
+
+    for (std::size_t b = 0; b < blocks; b++) {
+        for (auto i = _blocks[b].first; i <= _blocks[b].last; i++) {
+            uses(code[i], [&](std::uint32_t t) {
+                if (auto g = _globals[t]; g != NONE and !test(_def, b, g))
+                    set(_use, b, g);
+            });
+            if (auto g = _globals[code[i].dst]; code[i].dst and g != NONE)
+                set(_def, b, g);
+        }
+    }
+
+    // live in = use | (live out & ~def), live out is the union of the
+    // live in of the successors, until nothing changes
+    for (auto changed = true; changed;) {
+        changed = false;
+        for (auto b = blocks; b-- > 0;) {
+            auto out = &_out[b * _words];
+            auto in = &_in[b * _words];
+            for (auto s : _blocks[b].succ) {
+                if (s == NONE)
+                    continue;
+                auto succ = &_in[s * _words];
+                for (std::size_t w = 0; w < _words; w++)
+                    out[w] |= succ[w];
+            }
+            for (std::size_t w = 0; w < _words; w++) {
+                auto live =
+                    _use[b * _words + w] | (out[w] & ~_def[b * _words + w]);
+                if (live != in[w]) {
+                    in[w] = live;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+void X86Codegen::Compiler::intervals()
+{
+    // an interval covers the first to the last instruction a temporary is
+    // live at, with the holes in between. Temporaries live out of a block
+    // live past its last instruction, which might define another one.
+    auto &code = _fn->code;
+    std::vector<std::uint32_t> dense(_globalCount);
+    for (std::uint32_t t = 0; t < _globals.size(); t++) {
+        if (_globals[t] != NONE)
+            dense[_globals[t]] = t;
+    }
+
+    _intervals.clear();
+    std::vector<std::uint32_t> index(_fn->temps.size(), NONE);
+    auto extend = [&](std::uint32_t t, std::uint32_t pos) {
+        if (index[t] == NONE) {
+            index[t] = std::uint32_t(_intervals.size());
+            _intervals.push_back({t, pos, pos});
+            return;
+        }
+        auto &interval = _intervals[index[t]];
+        interval.start = std::min(interval.start, pos);
+        interval.end = std::max(interval.end, pos);
+    };
+
+    for (std::size_t b = 0; b < _blocks.size(); b++) {
+        auto &block = _blocks[b];
+        for (std::size_t w = 0; w < _words; w++) {
+            for (auto live = _in[b * _words + w]; live; live &= live - 1)
+                extend(dense[w * 64 + std::countr_zero(live)], block.first);
+            for (auto live = _out[b * _words + w]; live; live &= live - 1)
+                extend(dense[w * 64 + std::countr_zero(live)],
+                       block.last + 1);
+        }
+        for (auto i = block.first; i <= block.last; i++) {
+            uses(code[i], [&](std::uint32_t t) { extend(t, i); });
+            if (code[i].dst != 0 and _kinds[code[i].dst] == VALUE)
+                extend(code[i].dst, i);
+        }
+    }
+
+    // a call clobbers the registers not saved by the callee, the values
+    // defined or last used by the call do not live across it
+    for (auto &interval : _intervals) {
+        interval.crossesCall =
+            interval.end > interval.start + 1 and
+            _calls[interval.end] - _calls[interval.start + 1] > 0;
+    }
+    std::sort(_intervals.begin(),
+              _intervals.end(),
+              [](const Interval &a, const Interval &b) {
+                  return a.start < b.start or
+                         (a.start == b.start and a.temp < b.temp);
+              });
+}
+
+void X86Codegen::Compiler::allocate()
+{
+    _locations.assign(_fn->temps.size(), {});
+    _spilled.clear();
+    _saved.clear();
+    std::array<bool, 32> free{};
+    for (auto reg : CALLER_SAVED)
+        free[reg] = true;
+    for (auto reg : CALLEE_SAVED)
+        free[reg] = true;
+    for (unsigned i = 0; i < FLOAT_REGS; i++)
+        free[XMM0 + i] = true;
+
+    auto pick = [&](bool isFloat, bool crossesCall) {
+        if (isFloat) {
+            for (unsigned i = 0; !crossesCall and i < FLOAT_REGS; i++) {
+                if (free[XMM0 + i])
+                    return Reg(XMM0 + i);
+            }
+            return NO_REG;
+        }
+        for (auto reg : CALLER_SAVED) {
+            if (!crossesCall and free[reg])
+                return reg;
+        }
+        for (auto reg : CALLEE_SAVED) {
+            if (free[reg])
+                return reg;
+        }
+        return NO_REG;
+    };
+
+    // the active intervals hold a register, an interval ending where
+    // another starts gives it its register, operands are read before the
+    // result is written
+    std::vector<std::uint32_t> active;
+    for (std::uint32_t i = 0; i < _intervals.size(); i++) {
+        auto &current = _intervals[i];
+        std::erase_if(active, [&](std::uint32_t a) {
+            if (_intervals[a].end > current.start)
+                return false;
+            free[_locations[_intervals[a].temp].reg] = true;
+            return true;
+        });
+
+        const auto isFloat = ir::isFloat(_fn->temps[current.temp]);
+        auto reg = pick(isFloat, current.crossesCall);
+        if (reg == NO_REG) {
+            // spills the interval ending last, which might be this one
+            auto victim = active.end();
+            for (auto it = active.begin(); it != active.end(); it++) {
+                auto r = _locations[_intervals[*it].temp].reg;
+                if (isXmm(r) != isFloat or
+                    (current.crossesCall and !isCalleeSaved(r)))
+                    continue;
+                if (victim == active.end() or
+                    _intervals[*it].end > _intervals[*victim].end)
+                    victim = it;
+            }
+            if (victim == active.end() or
+                _intervals[*victim].end <= current.end) {
+                _spilled.push_back(current.temp);
+                continue;
+            }
+            auto &location = _locations[_intervals[*victim].temp];
+            reg = location.reg;
+            location.reg = NO_REG;
+            _spilled.push_back(_intervals[*victim].temp);
+            active.erase(victim);
+        }
+
+        _locations[current.temp].reg = reg;
+        free[reg] = false;
+        active.push_back(i);
+        if (isCalleeSaved(reg) and
+            std::find(_saved.begin(), _saved.end(), reg) == _saved.end())
+            _saved.push_back(reg);
+    }
+}
+
+void X86Codegen::Compiler::layout()
+{
+    // below the saved registers are the slots, the spilled temporaries and
+    // the parameters passed in registers, then the arguments of calls
+    auto align = [](std::uint32_t n, std::uint32_t a) {
+        return (n + a - 1) & ~(a - 1);
+    };
+    std::uint32_t size = std::uint32_t(_saved.size() * 8);
+    for (auto &slot : _fn->slots) {
+        size = align(size + slot.size, std::max(slot.align, 1u));
+        _locations[slot.temp] = {NO_REG, true, -std::int32_t(size)};
+    }
+
+    unsigned ints = 0, floats = 0, stack = 0;
+    for (std::uint32_t t = 1; t <= _fn->params.size(); t++) {
+        auto isFloat = ir::isFloat(_fn->params[t - 1]);
+        if (isFloat ? floats++ < FLOAT_ARGS : ints++ < std::size(INT_ARGS)) {
+            size += 8;
+            _locations[t].offset = -std::int32_t(size);
+        }
+        else {
+            _locations[t].offset = std::int32_t(16 + 8 * stack++);
+        }
+    }
+    for (auto t : _spilled) {
+        size += 8;
+        _locations[t].offset = -std::int32_t(size);
+    }
+
+    // RSP is aligned to 16 bytes at calls
+    _frame = align(size + _outgoing, 16) - std::uint32_t(_saved.size() * 8);
+}
+
+void X86Codegen::Compiler::prologue()
+{
+    _as.push(RBP);
+    _as.rr(0, true, 0x89, RSP, RBP);
+    for (auto reg : _saved)
+        _as.push(reg);
+    if (_frame != 0) {
+        _as.rr(0, true, 0x81, 5, RSP);
+        _as.u32(_frame);
+    }
+
+    unsigned ints = 0, floats = 0;
+    for (std::uint32_t t = 1; t <= _fn->params.size(); t++) {
+        auto cls = _fn->params[t - 1];
+        auto mem = Mem{RBP, _locations[t].offset};
+        if (ir::isFloat(cls) and floats < FLOAT_ARGS)
+            store(cls, mem, Reg(XMM0 + floats++));
+        else if (!ir::isFloat(cls) and ints < std::size(INT_ARGS))
+            store(cls, mem, INT_ARGS[ints++]);
+    }
+}
+
+void X86Codegen::Compiler::epilogue()
+{
+    // RSP is restored from RBP, the frame can have any size
+    if (_saved.empty()) {
+        _as.rr(0, true, 0x89, RBP, RSP);
+    }
+    else {
+        _as.rm(0,
+               true,
+               0x8D,
+               RSP,
+               Mem{RBP, -std::int32_t(_saved.size() * 8)});
+        for (auto it = _saved.rbegin(); it != _saved.rend(); it++)
+            _as.pop(*it);
+    }
+    _as.pop(RBP);
+    _as.byte(0xC3);
+}
+
+void X86Codegen::Compiler::move(Cls cls, Reg dst, Reg src)
+{
+    if (dst == src)
+        return;
+    if (ir::isFloat(cls))
+        _as.rr(0, false, 0x0F28, dst, src);
+    else
+        _as.rr(0, cls == Cls::L, 0x89, src, dst);
+}
+
+void X86Codegen::Compiler::load(Cls cls, Reg reg, const Mem &mem)
+{
+    if (ir::isFloat(cls))
+        _as.rm(sse(cls), false, 0x0F10, reg, mem);
+    else
+        _as.rm(0, cls == Cls::L, 0x8B, reg, mem);
+}
+
+void X86Codegen::Compiler::store(Cls cls, const Mem &mem, Reg reg)
+{
+    if (ir::isFloat(cls))
+        _as.rm(sse(cls), false, 0x0F11, reg, mem);
+    else
+        _as.rm(0, cls == Cls::L, 0x89, reg, mem);
+}
+
+void X86Codegen::Compiler::setcc(Cond cond, Reg reg)
+{
+    _as.rr(0, false, 0x0F90 | cond, 0, reg, true);
+}
+
+void X86Codegen::Compiler::load(const Ref &ref, Reg reg, Cls cls)
+{
+    switch (ref.kind) {
+    case Ref::TEMP: {
+        auto &location = _locations[ref.id];
+        if (location.address)
+            _as.rm(0, true, 0x8D, reg, Mem{RBP, location.offset});
+        else if (location.reg != NO_REG)
+            move(cls, reg, location.reg);
+        else
+            load(cls, reg, Mem{RBP, location.offset});
+        break;
+    }
+    case Ref::INTEGER:
+        _as.mov(reg, cls == Cls::L, ref.integer);
+        break;
+    case Ref::FLOAT:
+        if (auto value = bits(ref); value == 0) {
+            _as.rr(0, false, 0x0F57, reg, reg);
+        }
+        else {
+            _as.mov(R11, true, std::int64_t(value));
+            _as.rr(0x66, true, 0x0F6E, reg, R11);
+        }
+        break;
+    case Ref::SYMBOL:
+        _as.rm(0, true, 0x8D, reg, Mem{RBP, 0, ref.id});
+        break;
+    default:
+        csAssert(false, "loading an empty operand");
+    }
+}
+
+void X86Codegen::Compiler::store(std::uint32_t temp, Reg reg, Cls cls)
+{
+    auto &location = _locations[temp];
+    if (location.reg != NO_REG)
+        move(cls, location.reg, reg);
+    else
+        store(cls, Mem{RBP, location.offset}, reg);
+}
+
+Reg X86Codegen::Compiler::target(std::uint32_t temp, Cls cls) const
+{
+    if (auto reg = _locations[temp].reg; reg != NO_REG)
+        return reg;
+    return ir::isFloat(cls) ? XMM15 : RAX;
+}
+
+Mem X86Codegen::Compiler::address(const Ref &ref)
+{
+    if (ref.kind == Ref::SYMBOL)
+        return {RBP, 0, ref.id};
+    if (ref.kind == Ref::TEMP and _locations[ref.id].address)
+        return {RBP, _locations[ref.id].offset};
+    load(ref, R11, Cls::L);
+    return {R11, 0};
+}
+
+bool X86Codegen::Compiler::follows(std::size_t i, std::uint32_t label) const
+{
+    auto &code = _fn->code;
+    return i + 1 < code.size() and code[i + 1].op == Op::Label and
+           code[i + 1].aux[0] == label;
+}
+
+void X86Codegen::Compiler::jump(std::size_t i, std::uint32_t label)
+{
+    // falls through to the next block when it is the target
+    if (!follows(i, label))
+        _jumps.emplace_back(_as.jmp(), label);
+}
+
+void X86Codegen::Compiler::instruction(std::size_t i)
+{
+    auto &instr = _fn->code[i];
+    switch (instr.op) {
+    case Op::Label:
+        _labels[instr.aux[0]] = _as.offset();
+        break;
+    case Op::Jmp:
+        jump(i, instr.aux[0]);
+        break;
+    case Op::Jnz: {
+        auto &cond = instr.args[0];
+        auto reg = cond.kind == Ref::TEMP ? _locations[cond.id].reg : NO_REG;
+        if (reg == NO_REG) {
+            load(cond, RAX, Cls::W);
+            reg = RAX;
+        }
+        _as.rr(0, false, 0x85, reg, reg);
+        if (follows(i, instr.aux[0])) {
+            _jumps.emplace_back(_as.jcc(CC_E), instr.aux[1]);
+            break;
+        }
+        _jumps.emplace_back(_as.jcc(CC_NE), instr.aux[0]);
+        jump(i, instr.aux[1]);
+        break;
+    }
+    case Op::Ret:
+        if (instr.args[0].kind != Ref::NONE) {
+            load(instr.args[0],
+                 ir::isFloat(_fn->ret) ? XMM0 : RAX,
+                 _fn->ret);
+        }
+        epilogue();
+        break;
+    case Op::Call:
+        call(instr);
+        break;
+    case Op::Copy: {
+        auto reg = target(instr.dst, instr.cls);
+        load(instr.args[0], reg, instr.cls);
+        store(instr.dst, reg, instr.cls);
+        break;
+    }
+    default:
+        if (ir::isComparison(instr.op))
+            compare(instr);
+        else if (ir::isLoad(instr.op) or ir::isStore(instr.op))
+            memory(instr);
+        else if (instr.op >= Op::Extsb and instr.op <= Op::Dtoui)
+            convert(instr);
+        else
+            arithmetic(instr);
+        break;
+    }
+}
+
+void X86Codegen::Compiler::arithmetic(const ir::Instr &instr)
+{
+    const auto cls = instr.cls;
+    const auto wide = cls == Cls::L;
+    if (ir::isFloat(cls)) {
+        load(instr.args[0], XMM15, cls);
+        if (instr.op == Op::Neg) {
+            // flips the sign bit, which 0 - x does not do for zeroes
+            _as.mov(R11,
+                    true,
+                    cls == Cls::S ? 0x80000000
+                                  : std::int64_t(0x8000000000000000ull));
+            _as.rr(0x66, true, 0x0F6E, XMM14, R11);
+            _as.rr(0, false, 0x0F57, XMM15, XMM14);
+        }
+        else {
+            load(instr.args[1], XMM14, cls);
+            std::uint32_t opcode = 0;
+            switch (instr.op) {
+            case Op::Add:
+                opcode = 0x0F58;
+                break;
+            case Op::Sub:
+                opcode = 0x0F5C;
+                break;
+            case Op::Mul:
+                opcode = 0x0F59;
+                break;
+            case Op::Div:
+                opcode = 0x0F5E;
+                break;
+            default:
+                csAssert(false, "invalid floating point operation");
+            }
+            _as.rr(sse(cls), false, opcode, XMM15, XMM14);
+        }
+        store(instr.dst, XMM15, cls);
+        return;
+    }
+
+    load(instr.args[0], RAX, cls);
+    if (instr.args[1].kind != Ref::NONE) {
+        // shift counts are words
+        auto isShift = instr.op == Op::Shl or instr.op == Op::Sar or
+                       instr.op == Op::Shr;
+        load(instr.args[1], RCX, isShift ? Cls::W : cls);
+    }
+
+    auto result = RAX;
+    switch (instr.op) {
+    case Op::Add:
+        _as.rr(0, wide, 0x01, RCX, RAX);
+        break;
+    case Op::Sub:
+        _as.rr(0, wide, 0x29, RCX, RAX);
+        break;
+    case Op::And:
+        _as.rr(0, wide, 0x21, RCX, RAX);
+        break;
+    case Op::Or:
+        _as.rr(0, wide, 0x09, RCX, RAX);
+        break;
+    case Op::Xor:
+        _as.rr(0, wide, 0x31, RCX, RAX);
+        break;
+    case Op::Mul:
+        _as.rr(0, wide, 0x0FAF, RAX, RCX);
+        break;
+    case Op::Neg:
+        _as.rr(0, wide, 0xF7, 3, RAX);
+        break;
+    case Op::Div:
+    case Op::Rem:
+        // sign extends RAX to RDX:RAX with cdq or cqo
+        if (wide)
+            _as.byte(0x48);
+        _as.byte(0x99);
+        _as.rr(0, wide, 0xF7, 7, RCX);
+        result = instr.op == Op::Rem ? RDX : RAX;
+        break;
+    case Op::Udiv:
+    case Op::Urem:
+        _as.rr(0, false, 0x31, RDX, RDX);
+        _as.rr(0, wide, 0xF7, 6, RCX);
+        result = instr.op == Op::Urem ? RDX : RAX;
+        break;
+    case Op::Shl:
+        _as.rr(0, wide, 0xD3, 4, RAX);
+        break;
+    case Op::Sar:
+        _as.rr(0, wide, 0xD3, 7, RAX);
+        break;
+    case Op::Shr:
+        _as.rr(0, wide, 0xD3, 5, RAX);
+        break;
+    default:
+        csAssert(false, "invalid integer operation");
+    }
+    store(instr.dst, result, cls);
+}
+
+void X86Codegen::Compiler::compare(const ir::Instr &instr)
+{
+    const auto cls = instr.cls;
+    if (ir::isFloat(cls)) {
+        // unordered operands set ZF, PF and CF, the conditions are chosen
+        // so that comparisons with NaN are false, except for cne
+        load(instr.args[0], XMM15, cls);
+        load(instr.args[1], XMM14, cls);
+        const auto swap = instr.op == Op::Clt or instr.op == Op::Cle;
+        const std::uint8_t prefix = cls == Cls::D ? 0x66 : 0;
+        _as.rr(prefix,
+               false,
+               0x0F2E,
+               swap ? XMM14 : XMM15,
+               swap ? XMM15 : XMM14);
+        switch (instr.op) {
+        case Op::Ceq:
+            setcc(CC_E);
+            setcc(CC_NP, RCX);
+            _as.rr(0, false, 0x20, RCX, RAX, true);
+            break;
+        case Op::Cne:
+            setcc(CC_NE);
+            setcc(CC_P, RCX);
+            _as.rr(0, false, 0x08, RCX, RAX, true);
+            break;
+        case Op::Clt:
+        case Op::Cgt:
+            setcc(CC_A);
+            break;
+        default:
+            setcc(CC_AE);
+            break;
+        }
+    }
+    else {
+        load(instr.args[0], RAX, cls);
+        load(instr.args[1], RCX, cls);
+        _as.rr(0, cls == Cls::L, 0x39, RCX, RAX);
+        Cond cond = CC_E;
+        switch (instr.op) {
+        case Op::Ceq:
+            cond = CC_E;
+            break;
+        case Op::Cne:
+            cond = CC_NE;
+            break;
+        case Op::Cslt:
+            cond = CC_L;
+            break;
+        case Op::Csle:
+            cond = CC_LE;
+            break;
+        case Op::Csgt:
+            cond = CC_G;
+            break;
+        case Op::Csge:
+            cond = CC_GE;
+            break;
+        case Op::Cult:
+            cond = CC_B;
+            break;
+        case Op::Cule:
+            cond = CC_BE;
+            break;
+        case Op::Cugt:
+            cond = CC_A;
+            break;
+        default:
+            cond = CC_AE;
+            break;
+        }
+        setcc(cond);
+    }
+    _as.rr(0, false, 0x0FB6, RAX, RAX, true);
+    store(instr.dst, RAX, Cls::W);
+}
+
+void X86Codegen::Compiler::convert(const ir::Instr &instr)
+{
+    const auto cls = instr.cls;
+    const auto wide = cls == Cls::L;
+    const auto &arg = instr.args[0];
+    switch (instr.op) {
+    case Op::Extsb:
+    case Op::Extub:
+    case Op::Extsh:
+    case Op::Extuh: {
+        static constexpr std::uint32_t opcodes[] = {
+            0x0FBE, 0x0FB6, 0x0FBF, 0x0FB7};
+        load(arg, RAX, Cls::W);
+        _as.rr(0,
+               wide,
+               opcodes[unsigned(instr.op) - unsigned(Op::Extsb)],
+               RAX,
+               RAX,
+               true);
+        break;
+    }
+    case Op::Extsw:
+        load(arg, RAX, Cls::W);
+        _as.rr(0, true, 0x63, RAX, RAX);
+        break;
+    case Op::Extuw:
+        // writing a word zeroes the high half of the register
+        load(arg, RAX, Cls::W);
+        _as.rr(0, false, 0x89, RAX, RAX);
+        break;
+    case Op::Exts:
+    case Op::Truncd: {
+        auto from = instr.op == Op::Exts ? Cls::S : Cls::D;
+        load(arg, XMM15, from);
+        _as.rr(sse(from), false, 0x0F5A, XMM15, XMM15);
+        store(instr.dst, XMM15, cls);
+        return;
+    }
+    case Op::Swtof:
+    case Op::Sltof:
+    case Op::Uwtof: {
+        // unsigned words are zero extended to a signed long
+        auto from = instr.op == Op::Swtof ? Cls::W : Cls::L;
+        load(arg, RAX, instr.op == Op::Sltof ? Cls::L : Cls::W);
+        _as.rr(sse(cls), from == Cls::L, 0x0F2A, XMM15, RAX);
+        store(instr.dst, XMM15, cls);
+        return;
+    }
+    case Op::Ultof: {
+        // longs with the top bit set are halved, keeping the low bit for
+        // the rounding, converted and doubled
+        load(arg, RAX, Cls::L);
+        _as.rr(0, true, 0x85, RAX, RAX);
+        auto big = _as.jcc(CC_S);
+        _as.rr(sse(cls), true, 0x0F2A, XMM15, RAX);
+        auto done = _as.jmp();
+        _as.link(big, _as.offset());
+        _as.rr(0, true, 0x89, RAX, RCX);
+        _as.rr(0, false, 0x83, 4, RCX);
+        _as.byte(1);
+        _as.rr(0, true, 0xD1, 5, RAX);
+        _as.rr(0, true, 0x09, RCX, RAX);
+        _as.rr(sse(cls), true, 0x0F2A, XMM15, RAX);
+        _as.rr(sse(cls), false, 0x0F58, XMM15, XMM15);
+        _as.link(done, _as.offset());
+        store(instr.dst, XMM15, cls);
+        return;
+    }
+    case Op::Stosi:
+    case Op::Dtosi:
+    case Op::Stoui:
+    case Op::Dtoui: {
+        const auto from =
+            instr.op == Op::Stosi or instr.op == Op::Stoui ? Cls::S : Cls::D;
+        const auto isUnsigned = instr.op == Op::Stoui or instr.op == Op::Dtoui;
+        load(arg, XMM15, from);
+        if (!isUnsigned or !wide) {
+            // unsigned words are the low half of a signed long
+            _as.rr(sse(from), wide or isUnsigned, 0x0F2C, RAX, XMM15);
+            break;
+        }
+
+        // numbers from 2^63 are reduced by 2^63 before the conversion, and
+        // the top bit set after it
+        _as.mov(R11,
+                true,
+                from == Cls::S ? 0x5F000000 : 0x43E0000000000000);
+        _as.rr(0x66, true, 0x0F6E, XMM14, R11);
+        _as.rr(from == Cls::D ? 0x66 : 0, false, 0x0F2E, XMM15, XMM14);
+        auto big = _as.jcc(CC_AE);
+        _as.rr(sse(from), true, 0x0F2C, RAX, XMM15);
+        auto done = _as.jmp();
+        _as.link(big, _as.offset());
+        _as.rr(sse(from), false, 0x0F5C, XMM15, XMM14);
+        _as.rr(sse(from), true, 0x0F2C, RAX, XMM15);
+        _as.mov(R11, true, std::int64_t(0x8000000000000000ull));
+        _as.rr(0, true, 0x31, R11, RAX);
+        _as.link(done, _as.offset());
+        break;
+    }
+    default:
+        csAssert(false, "invalid conversion");
+    }
+    store(instr.dst, RAX, cls);
+}
+
+void X86Codegen::Compiler::memory(const ir::Instr &instr)
+{
+    if (ir::isStore(instr.op)) {
+        // the value is loaded first, the address might need R11
+        static constexpr Cls classes[] = {
+            Cls::W, Cls::W, Cls::W, Cls::L, Cls::S, Cls::D};
+        const auto cls =
+            classes[unsigned(instr.op) - unsigned(Op::Storeb)];
+        const auto reg = ir::isFloat(cls) ? XMM15 : RAX;
+        load(instr.args[0], reg, cls);
+        auto mem = address(instr.args[1]);
+        switch (instr.op) {
+        case Op::Storeb:
+            _as.rm(0, false, 0x88, RAX, mem, true);
+            break;
+        case Op::Storeh:
+            _as.rm(0x66, false, 0x89, RAX, mem);
+            break;
+        default:
+            store(cls, mem, reg);
+            break;
+        }
+        return;
+    }
+
+    const auto cls = instr.cls;
+    const auto reg = target(instr.dst, cls);
+    auto mem = address(instr.args[0]);
+    switch (instr.op) {
+    case Op::Loadsb:
+        _as.rm(0, cls == Cls::L, 0x0FBE, reg, mem);
+        break;
+    case Op::Loadub:
+        _as.rm(0, cls == Cls::L, 0x0FB6, reg, mem);
+        break;
+    case Op::Loadsh:
+        _as.rm(0, cls == Cls::L, 0x0FBF, reg, mem);
+        break;
+    case Op::Loaduh:
+        _as.rm(0, cls == Cls::L, 0x0FB7, reg, mem);
+        break;
+    case Op::Loadw:
+        if (cls == Cls::L)
+            _as.rm(0, true, 0x63, reg, mem);
+        else
+            load(Cls::W, reg, mem);
+        break;
+    default:
+        load(cls, reg, mem);
+        break;
+    }
+    store(instr.dst, reg, cls);
+}
+
+void X86Codegen::Compiler::call(const ir::Instr &instr)
+{
+    // the arguments are all written to the stack first, those passed in
+    // registers are then loaded, so that no argument overwrites another
+    auto args = std::span{_fn->callArgs}.subspan(instr.aux[0], instr.aux[1]);
+    unsigned ints = 0, floats = 0, stack = 0;
+    for (auto &arg : args) {
+        if (ir::isFloat(arg.cls) ? floats < FLOAT_ARGS
+                                 : ints < std::size(INT_ARGS))
+            ir::isFloat(arg.cls) ? floats++ : ints++;
+        else
+            stack++;
+    }
+
+    std::array<Reg, std::size(INT_ARGS) + FLOAT_ARGS> regs{};
+    unsigned staged = 0, pushed = 0;
+    ints = floats = 0;
+    for (auto &arg : args) {
+        const auto isFloat = ir::isFloat(arg.cls);
+        const auto reg = isFloat ? XMM15 : RAX;
+        load(arg, reg, arg.cls);
+        Mem mem{RSP};
+        if (isFloat ? floats < FLOAT_ARGS : ints < std::size(INT_ARGS)) {
+            regs[staged] = isFloat ? Reg(XMM0 + floats++) : INT_ARGS[ints++];
+            mem.disp = std::int32_t(8 * (stack + staged++));
+        }
+        else {
+            mem.disp = std::int32_t(8 * pushed++);
+        }
+        store(isFloat ? Cls::D : Cls::L, mem, reg);
+    }
+    for (unsigned i = 0; i < staged; i++) {
+        load(isXmm(regs[i]) ? Cls::D : Cls::L,
+             regs[i],
+             Mem{RSP, std::int32_t(8 * (stack + i))});
+    }
+
+    // variadic functions expect the number of vector registers in AL
+    _as.mov(RAX, false, floats);
+    _as.call(instr.args[0].id);
+    if (instr.dst != 0)
+        store(instr.dst, ir::isFloat(instr.cls) ? XMM0 : RAX, instr.cls);
+}
+
+X86Codegen::X86Codegen(ElfObject &object)
+    : _object{object}, _compiler{std::make_unique<Compiler>(*this)}
+{
+}
+
+X86Codegen::~X86Codegen() = default;
+
+std::uint32_t X86Codegen::symbol(const ir::Module &m, std::uint32_t id)
+{
+    if (_symbols.size() <= id)
+        _symbols.resize(m.size(), 0);
+    if (_symbols[id] == 0)
+        _symbols[id] = _object.symbol(m[id].name) + 1;
+    return _symbols[id] - 1;
+}
+
+void X86Codegen::data(const ir::Module &m, const ir::Data &data)
+{
+    // data is aligned like QBE aligns it
+    auto &bytes = _object.data();
+    bytes.resize((bytes.size() + 7) & ~std::size_t(7), 0);
+    const auto start = bytes.size();
+    for (auto &item : data.items) {
+        bytes.insert(bytes.end(), item.bytes.begin(), item.bytes.end());
+        auto &value = item.value;
+        if (value.kind == Ref::NONE)
+            continue;
+
+        std::size_t size = 0;
+        switch (item.type) {
+        case 'z':
+            bytes.resize(bytes.size() + std::size_t(value.integer), 0);
+            continue;
+        case 'b':
+            size = 1;
+            break;
+        case 'h':
+            size = 2;
+            break;
+        case 'w':
+        case 's':
+            size = 4;
+            break;
+        default:
+            size = 8;
+            break;
+        }
+
+        auto number = std::uint64_t(value.integer);
+        if (value.kind == Ref::FLOAT) {
+            number = bits(value);
+        }
+        else if (value.kind == Ref::SYMBOL) {
+            _object.relocate(ElfObject::Section::Data,
+                             bytes.size(),
+                             symbol(m, value.id),
+                             ElfObject::R_X86_64_64,
+                             0);
+            number = 0;
+        }
+        for (std::size_t i = 0; i < size; i++, number >>= 8)
+            bytes.push_back(std::uint8_t(number));
+    }
+    _object.define(symbol(m, data.symbol),
+                   ElfObject::Section::Data,
+                   start,
+                   bytes.size() - start,
+                   data.exported,
+                   false);
+}
+
+void X86Codegen::function(const ir::Module &m, const ir::Function &func)
+{
+    _compiler->compile(m, func);
+}
+
+} // namespace cstar
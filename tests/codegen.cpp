@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-16
+ */
+
+#include "catch2/catch.hpp"
+
+#include "compiler/codegen.hpp"
+#include "compiler/fold.hpp"
+#include "compiler/lexer.hpp"
+#include "compiler/parser.hpp"
+#include "compiler/source.hpp"
+#include "compiler/symbol.hpp"
+
+#include <string>
+
+using namespace cstar;
+
+namespace {
+
+/**
+ * @return the C code of the given program, folded like the driver does
+ */
+std::string c(Log &L, std::string code)
+{
+    Source src{"codegen.cstr", std::move(code)};
+    Lexer lexer{L, src, gflLexerSkipComments};
+    Parser parser(L, lexer, std::make_shared<SymbolTable>());
+    Program program;
+    if (!parser.parse(program))
+        return {};
+
+    Folding folding{L};
+    if (!folding.fold(program))
+        return {};
+
+    CodeWriter out;
+    Codegen codegen{out};
+    codegen.generate(program);
+    return out.str();
+}
+
+bool contains(const std::string &code, std::string_view str)
+{
+    return code.find(str) != std::string::npos;
+}
+
+} // namespace
+
+TEST_CASE("C code is generated from the folded literals", "[codegen]")
+{
+    Log L;
+    auto code = c(L,
+                  "imm k: i64 = 2 + 3;\n"
+                  "imm u: u64 = 0;\n"
+                  "func f() {\n"
+                  "  mut a = k * 4;\n"
+                  "  mut b = u - 1;\n"
+                  "  mut x = 1.0 / 3.0;\n"
+                  "  mut y = 1.5 * 2.0;\n"
+                  "}\n");
+    INFO(L.toString());
+    REQUIRE_FALSE(L.hasErrors());
+    CHECK(contains(code, "auto a = 20;"));
+    CHECK(contains(code, "auto b = 18446744073709551615u;"));
+    CHECK(contains(code, "auto x = 0.3333333333333333;"));
+    CHECK(contains(code, "auto y = 3.0;"));
+}
+
+TEST_CASE("C code leaves out the statements that cannot run", "[codegen]")
+{
+    Log L;
+    auto code = c(L,
+                  "mut a = 1;\n"
+                  "func f() {\n"
+                  "  if (false) { a = 5; } else a = 2;\n"
+                  "  while (1 > 2) a = 3;\n"
+                  "  if (a) a = 4;\n"
+                  "}\n");
+    INFO(L.toString());
+    REQUIRE_FALSE(L.hasErrors());
+    CHECK_FALSE(contains(code, "a = 5;"));
+    CHECK_FALSE(contains(code, "while"));
+    CHECK(contains(code, "a = 2;"));
+    CHECK(contains(code, "if (a)"));
+}
+
+TEST_CASE("C code is not generated for assignments of immutables",
+          "[codegen]")
+{
+    Log L;
+    auto code = c(L,
+                  "imm k: i64 = 2 + 3;\n"
+                  "func f() { k = 9; if (false) { k = 1; } }\n");
+    CHECK(L.hasErrors());
+    CHECK(code.empty());
+}
@@ -0,0 +1,148 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-09
+ */
+
+#include "compiler/codegen.hpp"
+#include "compiler/fold.hpp"
+#include "compiler/lexer.hpp"
+#include "compiler/lower.hpp"
+#include "compiler/parser.hpp"
+#include "compiler/qbe.hpp"
+#include "compiler/source.hpp"
+#include "compiler/symbol.hpp"
+
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+
+#include <pthread.h>
+
+using namespace cstar;
+
+namespace {
+
+/** deeply nested programs must compile on a thread with this stack */
+constexpr std::size_t STACK_SIZE = 1024 * 1024;
+constexpr std::uint32_t NESTING_DEPTH = 100000;
+
+std::string repeat(std::string_view str, std::uint32_t count)
+{
+    std::string result;
+    result.reserve(str.size() * count);
+    for (auto i = 0u; i < count; i++)
+        result += str;
+    return result;
+}
+
+/**
+ * Compiles the given program to C and to QBE IL
+ *
+ * @return the diagnostics of the compilation
+ */
+std::string compile(const std::string &name, std::string code)
+{
+    Log L;
+    Source src{name, std::move(code)};
+    Lexer lexer{L, src, gflLexerSkipComments};
+    Parser parser(L, lexer, std::make_shared<SymbolTable>());
+    Program program;
+    if (parser.parse(program)) {
+        CodeWriter c, il;
+        Codegen codegen{c};
+        codegen.generate(program);
+
+        Folding folding{L};
+        QbeCodegen qbe{il};
+        Lowering lowering{L, qbe};
+        if (folding.fold(program))
+            lowering.lower(program);
+    }
+    return L.toString();
+}
+
+/**
+ * Runs the given function on a thread with a small stack, overflowing it
+ * crashes the test
+ */
+void run(std::function<void()> fn)
+{
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, STACK_SIZE);
+    pthread_t thread;
+    auto start = [](void *arg) -> void * {
+        (*static_cast<std::function<void()> *>(arg))();
+        return nullptr;
+    };
+    if (pthread_create(&thread, &attr, start, &fn) != 0) {
+        std::cerr << "cannot create a thread\n";
+        std::exit(EXIT_FAILURE);
+    }
+    pthread_join(thread, nullptr);
+    pthread_attr_destroy(&attr);
+}
+
+bool check(const std::string &name, std::string code)
+{
+    std::string diagnostics;
+    run([&] { diagnostics = compile(name, std::move(code)); });
+
+    auto ok = diagnostics.empty();
+    std::cout << (ok ? "ok   " : "FAIL ") << name << std::endl;
+    if (!ok)
+        std::cout << diagnostics.substr(0, 512) << std::endl;
+    return ok;
+}
+
+} // namespace
+
+int main()
+{
+    const auto n = NESTING_DEPTH;
+    auto ok = true;
+
+    ok &= check("blocks",
+                "mut a = 1;\nfunc f() " + repeat("{ a += 1; ", n) +
+                    repeat("}", n) + "\n");
+    ok &= check("if",
+                "mut a = 1;\nfunc f() {\n" + repeat("if (a) ", n) +
+                    "a = 2;\n}\n");
+    ok &= check("if else",
+                "mut a = 1;\nfunc f() {\n" +
+                    repeat("if (a) a = 1; else { ", n) + "a = 2;" +
+                    repeat(" }", n) + "\n}\n");
+    ok &= check("while",
+                "mut a = 1;\nfunc f() {\n" + repeat("while (a) ", n) +
+                    "a = 2;\n}\n");
+    ok &= check("for",
+                "func f() {\n" +
+                    repeat("for (mut i = 0; i < 2; i++) ", n) +
+                    "i = 2;\n}\n");
+    ok &= check("else if",
+                "mut a = 1;\nfunc f() {\n" +
+                    repeat("if (a) a = 1; else ", n) + "a = 2;\n}\n");
+    ok &= check("parens",
+                "func f() { mut a = " + repeat("(", n) + "1" +
+                    repeat(")", n) + "; }\n");
+    ok &= check("prefix",
+                "func f() { mut a = " + repeat("- ", n) + "1; }\n");
+    ok &= check("binary",
+                "func f() { mut a = 1" + repeat(" + 1", n) + "; }\n");
+    ok &= check("ternary",
+                "mut a = 1;\nfunc f() { mut b = " + repeat("a ? 1 : ", n) +
+                    "2; }\n");
+    ok &= check("blocks, while and for",
+                "mut a = 1;\nfunc f() {\n" +
+                    repeat("{ while (a) for (mut i = 0; i < a; i++) { ",
+                           n / 2) +
+                    "a = 2;" + repeat(" } }", n / 2) + "\n}\n");
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -29,10 +29,7 @@ int main(int argc, char *argv[])
     Log L;
     Source src{L, testScript};
     Lexer lexer{L, src, cstar::gflLexerSkipComments};
-    if (!lexer.tokenize())
-        abortCompiler(L);
-
-    Parser parser(L, lexer.tange(), std::make_shared<SymbolTable>());
+    Parser parser(L, lexer, std::make_shared<SymbolTable>());
     cstar::Program program;
     if (!parser.parse(program)) {
         abortCompiler(L);
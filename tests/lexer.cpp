@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-06
+ */
+
+#include "catch2/catch.hpp"
+
+#include "compiler/lexer.hpp"
+#include "compiler/source.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace cstar;
+
+namespace {
+
+/**
+ * Statements whose tokens span several lines, so that the chunks of the
+ * parallel lexer start inside comments and string expressions
+ */
+constexpr std::string_view LINES[] = {
+    "var a = 10; // a \"line\" comment with f\"${ in it\n",
+    "/* a block comment\n"
+    "   with \"quotes and f\"${ unbalanced\n"
+    "   string expressions */ var b = a * 2;\n",
+    "var s = \"a string with /* no comment */ in it\";\n",
+    "var f = f\"sum ${\n"
+    "    a +\n"
+    "    b\n"
+    "} and ${ a * b } done\";\n",
+    "/*\n"
+    " * a long comment that chunks are likely to start in\n"
+    " * var x = \"not a string\";\n"
+    " * var y = f\"not ${a} string expression\n"
+    " * }\n"
+    " */\n",
+    "func add(x: i32, y: i32) { return x + y; }\n",
+    "var c = 'c'; var h = 0xFF; var d = 1.5e3;\n",
+};
+
+std::string corpus(std::size_t size)
+{
+    std::string code;
+    code.reserve(size + 256);
+    for (std::size_t i = 0; code.size() < size; i++) {
+        // vary the statement order so that every statement ends up
+        // straddling a chunk boundary
+        code += LINES[(i * 7 + i / 13) % std::size(LINES)];
+    }
+    return code;
+}
+
+void requireSame(const std::vector<Token> &expected,
+                 const std::vector<Token> &actual)
+{
+    REQUIRE(expected.size() == actual.size());
+    auto same = [](const Token &a, const Token &b) {
+        if (a.kind != b.kind or a.start != b.start or a.length() != b.length())
+            return false;
+        return a.kind != Token::STRING or
+               a.value<std::string_view>() == b.value<std::string_view>();
+    };
+    auto mismatch =
+        std::mismatch(expected.begin(), expected.end(), actual.begin(), same);
+    INFO("token " << (mismatch.first - expected.begin()));
+    REQUIRE(mismatch.first == expected.end());
+}
+
+} // namespace
+
+TEST_CASE("Parallel lexing matches sequential lexing", "[lexer]")
+{
+    auto flags = GENERATE(GenericFlags{gflNone},
+                          GenericFlags{gflLexerSkipComments});
+    auto jobs = GENERATE(2, 3, 8);
+
+    Log L;
+    Source src{"chunks.cstr", corpus(8 * 1024 * 1024 + 123)};
+    Lexer sequential{L, src, flags}, parallel{L, src, flags};
+    REQUIRE(sequential.tokenize());
+    REQUIRE(parallel.tokenizeParallel(jobs));
+    REQUIRE(!L.hasErrors());
+    requireSame(sequential.tokens(), parallel.tokens());
+}
+
+TEST_CASE("Parallel lexing reports the errors of sequential lexing",
+          "[lexer]")
+{
+    auto code = corpus(4 * 1024 * 1024);
+    code += "var bad = \"unterminated\n";
+    code += corpus(4 * 1024 * 1024);
+
+    Log sequential, parallel;
+    Source src{"errors.cstr", code};
+    Lexer a{sequential, src}, b{parallel, src};
+    CHECK(a.tokenize() == b.tokenizeParallel(4));
+    CHECK(sequential.errors() == 1);
+    CHECK(parallel.errors() == sequential.errors());
+    requireSame(a.tokens(), b.tokens());
+}
+
+TEST_CASE("Small sources are lexed on the calling thread", "[lexer]")
+{
+    Log L;
+    Source src{"small.cstr", std::string{LINES[3]}};
+    Lexer sequential{L, src}, parallel{L, src};
+    REQUIRE(sequential.tokenize());
+    REQUIRE(parallel.tokenizeParallel(16));
+    REQUIRE(!L.hasErrors());
+    requireSame(sequential.tokens(), parallel.tokens());
+}
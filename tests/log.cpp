@@ -0,0 +1,187 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-10
+ */
+
+#include "catch2/catch.hpp"
+
+#include "compiler/lexer.hpp"
+#include "compiler/log.hpp"
+#include "compiler/parser.hpp"
+#include "compiler/source.hpp"
+#include "compiler/symbol.hpp"
+
+#include <string>
+
+using namespace cstar;
+
+namespace {
+
+/**
+ * @return a source with the given number of unterminated strings, each
+ * on its own line
+ */
+std::string unterminated(std::size_t count)
+{
+    std::string code;
+    for (std::size_t i = 0; i < count; i++)
+        code += "mut s" + std::to_string(i) + " = \"unterminated;\n";
+    return code;
+}
+
+std::size_t count(const Log &L, Diag id)
+{
+    std::size_t n = 0;
+    for (auto &diagnostic : L.diagnostics())
+        n += diagnostic.id == id;
+    return n;
+}
+
+} // namespace
+
+TEST_CASE("Log stops recording errors at its limit", "[log]")
+{
+    Log L{3};
+    Source src{"limit.cstr", std::string(64, ' ')};
+    for (std::uint32_t i = 0; i < 10; i++)
+        L.error({src, i, i + 1}, Diag::UnknownToken);
+
+    CHECK(L.errors() == 3);
+    CHECK(L.limitReached());
+    REQUIRE(L.diagnostics().size() == 4);
+    CHECK(L.diagnostics().back().id == Diag::TooManyErrors);
+
+    // warnings are dropped as well once the limit is reached
+    L.warning({src, 20, 21}, Diag::UnknownToken);
+    CHECK(L.diagnostics().size() == 4);
+}
+
+TEST_CASE("Log without a limit records every error", "[log]")
+{
+    Log L{0};
+    Source src{"unlimited.cstr", std::string(256, ' ')};
+    for (std::uint32_t i = 0; i < 200; i++)
+        L.error({src, i, i + 1}, Diag::UnknownToken);
+
+    CHECK(L.errors() == 200);
+    CHECK(L.errorLimit() == 0);
+    CHECK_FALSE(L.limitReached());
+    CHECK(count(L, Diag::TooManyErrors) == 0);
+}
+
+TEST_CASE("Log has no limit unless one is set", "[log]")
+{
+    Log L;
+    Source src{"default.cstr", std::string(64, ' ')};
+    for (std::uint32_t i = 0; i < 50; i++)
+        L.error({src, i, i + 1}, Diag::UnknownToken);
+
+    CHECK(L.errorLimit() == 0);
+    CHECK(L.errors() == 50);
+    CHECK_FALSE(L.limitReached());
+}
+
+TEST_CASE("Log warnings do not count towards the limit", "[log]")
+{
+    Log L{2};
+    Source src{"warnings.cstr", std::string(64, ' ')};
+    for (std::uint32_t i = 0; i < 10; i++)
+        L.warning({src, i, i + 1}, Diag::UnknownToken);
+
+    CHECK_FALSE(L.hasErrors());
+    CHECK_FALSE(L.limitReached());
+    CHECK(L.diagnostics().size() == 10);
+    CHECK(L.diagnostics().front().kind == Diagnostic::WARNING);
+}
+
+TEST_CASE("Log drops errors cascading from the previous error", "[log]")
+{
+    Log L;
+    Source src{"cascade.cstr", std::string(64, ' ')};
+    L.error({src, 5, 6}, Diag::UnknownToken);
+    L.error({src, 5, 9}, Diag::UnterminatedString);
+    L.error({src, 7, 9}, Diag::UnterminatedString);
+
+    CHECK(L.errors() == 2);
+    REQUIRE(L.diagnostics().size() == 2);
+    CHECK(L.diagnostics()[0].id == Diag::UnknownToken);
+    CHECK(L.diagnostics()[1].id == Diag::UnterminatedString);
+}
+
+TEST_CASE("Log formats messages when they are printed", "[log]")
+{
+    Log L;
+    Source src{"format.cstr", std::string(64, ' ')};
+    std::string name = "shortlived";
+    L.error({src, 1, 2}, Diag::InvalidOctalDigit, '9');
+    L.error({src, 2, 3}, Diag::TokenTooLong, 42u);
+    L.error({src, 3, 4}, Diag::InvalidConversion, name, "i32");
+    name.assign(name.size(), '?');
+
+    REQUIRE(L.diagnostics().size() == 3);
+    CHECK(L.diagnostics()[0].message() == "'9' is not a valid octal digit");
+    CHECK(L.diagnostics()[1].message() ==
+          "token too long, tokens are limited to 42 bytes");
+    CHECK(L.diagnostics()[2].message() ==
+          "cannot convert a value of type 'shortlived' to 'i32'");
+}
+
+TEST_CASE("Log appends diagnostics up to its limit", "[log]")
+{
+    Source src{"append.cstr", std::string(64, ' ')};
+    Log L{4}, other{0};
+    L.error({src, 0, 1}, Diag::UnknownToken);
+    for (std::uint32_t i = 1; i < 10; i++)
+        other.error({src, i, i + 1}, Diag::UnknownToken);
+
+    L.append(std::move(other));
+    CHECK(L.errors() == 4);
+    CHECK(count(L, Diag::TooManyErrors) == 1);
+    CHECK(other.diagnostics().empty());
+    CHECK_FALSE(other.hasErrors());
+}
+
+TEST_CASE("Lexing stops at the error limit", "[log]")
+{
+    Log L{5};
+    Source src{"lexer.cstr", unterminated(100)};
+    Lexer lexer{L, src};
+    CHECK_FALSE(lexer.tokenize());
+    CHECK(L.errors() == 5);
+    CHECK(count(L, Diag::UnterminatedString) == 5);
+    CHECK(count(L, Diag::TooManyErrors) == 1);
+
+    // the lexer did not go past the fifth error
+    CHECK(lexer.tokens().back().start < src.size() / 10);
+}
+
+TEST_CASE("Parallel lexing stops at the error limit", "[log]")
+{
+    Log L{5};
+    Source src{"chunks.cstr", unterminated(200000)};
+    Lexer lexer{L, src};
+    CHECK_FALSE(lexer.tokenizeParallel(4));
+    CHECK(L.errors() == 5);
+    CHECK(count(L, Diag::TooManyErrors) == 1);
+}
+
+TEST_CASE("Parsing stops at the error limit", "[log]")
+{
+    std::string code;
+    for (auto i = 0; i < 100; i++)
+        code += "func f" + std::to_string(i) + "( { }\n";
+
+    Log L{7};
+    Source src{"parser.cstr", code};
+    Lexer lexer{L, src, gflLexerSkipComments};
+    Parser parser(L, lexer, std::make_shared<SymbolTable>());
+    Program program;
+    CHECK_FALSE(parser.parse(program));
+    CHECK(L.errors() == 7);
+    CHECK(count(L, Diag::TooManyErrors) == 1);
+}
@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-04
+ */
+
+#include "catch2/catch.hpp"
+
+#include "compiler/builtin.hpp"
+#include "compiler/phash.hpp"
+#include "compiler/token.hpp"
+
+#include <string>
+
+using namespace cstar;
+
+namespace {
+
+#define YY(TOK, NAME) {NAME, Token::TOK},
+#define ZZ(TOK, NAME, ALIAS) {NAME, Token::ALIAS},
+#define XX(_, ___)
+#define BB(TOK, NAME) {NAME, Token::TOK},
+constexpr PerfectHashEntry<Token::Kind> KEYWORDS[] = {
+    TOKEN_LIST(XX, YY, ZZ, BB)};
+#undef BB
+#undef XX
+#undef ZZ
+#undef YY
+
+constexpr auto KEYWORD_TABLE = makePerfectHash<Token::Kind>(KEYWORDS);
+
+} // namespace
+
+TEST_CASE("PerfectHash finds every key", "[phash]")
+{
+    for (auto &entry : KEYWORDS) {
+        INFO(entry.key);
+        auto value = KEYWORD_TABLE.find(entry.key);
+        REQUIRE(value != nullptr);
+        CHECK(*value == entry.value);
+    }
+    CHECK(*KEYWORD_TABLE.find("and") == Token::LAND);
+    CHECK(*KEYWORD_TABLE.find("or") == Token::LOR);
+}
+
+TEST_CASE("PerfectHash rejects keys not in the table", "[phash]")
+{
+    // same length, first, middle and last characters as keywords
+    for (auto key : {"", "i", "fo", "fur", "whole", "imp", "returns",
+                     "retur", "eturn", "Func", "whilE", "move", "@mov"}) {
+        INFO(key);
+        CHECK(KEYWORD_TABLE.find(key) == nullptr);
+    }
+
+    for (auto &entry : KEYWORDS) {
+        auto key = std::string{entry.key};
+        CHECK(KEYWORD_TABLE.find(key + "_") == nullptr);
+        key[key.size() / 2] = '$';
+        CHECK(KEYWORD_TABLE.find(key) == nullptr);
+    }
+}
+
+TEST_CASE("PerfectHash is usable in constant expressions", "[phash]")
+{
+    constexpr auto table =
+        makePerfectHash<int>({{"one", 1}, {"two", 2}, {"three", 3}});
+    static_assert(*table.find("two") == 2);
+    static_assert(table.find("four") == nullptr);
+    CHECK(*table.find("three") == 3);
+}
+
+TEST_CASE("Builtin types are found by name", "[phash]")
+{
+    for (auto name : {"void", "auto", "null", "bool", "char", "i8", "u8",
+                      "i16", "u16", "i32", "u32", "i64", "u64", "f32",
+                      "f64", "string"}) {
+        INFO(name);
+        auto type = builtin::getBuiltinType(name);
+        REQUIRE(type != nullptr);
+        CHECK(type->name() == name);
+    }
+    CHECK(builtin::getBuiltinType("i128") == nullptr);
+    CHECK(builtin::getBuiltinType("int") == nullptr);
+    CHECK(builtin::getBuiltinType("") == nullptr);
+}
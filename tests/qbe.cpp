@@ -0,0 +1,182 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-12
+ */
+
+#include "catch2/catch.hpp"
+
+#include "compiler/fold.hpp"
+#include "compiler/lexer.hpp"
+#include "compiler/lower.hpp"
+#include "compiler/parser.hpp"
+#include "compiler/qbe.hpp"
+#include "compiler/source.hpp"
+#include "compiler/symbol.hpp"
+
+#include <sstream>
+#include <string>
+
+using namespace cstar;
+
+namespace {
+
+/**
+ * @return the QBE IL of the given program, folded like the driver does
+ */
+std::string qbe(Log &L, std::string code)
+{
+    Source src{"qbe.cstr", std::move(code)};
+    Lexer lexer{L, src, gflLexerSkipComments};
+    Parser parser(L, lexer, std::make_shared<SymbolTable>());
+    Program program;
+    if (!parser.parse(program))
+        return {};
+
+    Folding folding{L};
+    if (!folding.fold(program))
+        return {};
+
+    CodeWriter out;
+    QbeCodegen codegen{out};
+    Lowering lowering{L, codegen};
+    lowering.lower(program);
+
+    std::ostringstream os;
+    out.flush(os);
+    return os.str();
+}
+
+bool contains(const std::string &il, std::string_view str)
+{
+    return il.find(str) != std::string::npos;
+}
+
+std::size_t count(const Log &L, Diag id)
+{
+    std::size_t n = 0;
+    for (auto &diagnostic : L.diagnostics())
+        n += diagnostic.id == id;
+    return n;
+}
+
+} // namespace
+
+TEST_CASE("QBE globals are data definitions", "[qbe]")
+{
+    Log L;
+    auto il = qbe(L,
+                  "mut g: i32 = 3;\n"
+                  "mut r: i64;\n"
+                  "mut d: f64 = -1.5;\n");
+    INFO(L.toString());
+    REQUIRE_FALSE(L.hasErrors());
+    CHECK(contains(il, "export data $g = { w 3 }"));
+    CHECK(contains(il, "export data $r = { z 8 }"));
+    CHECK(contains(il, "export data $d = { d d_-1.5 }"));
+}
+
+TEST_CASE("QBE parameters are copied to stack slots", "[qbe]")
+{
+    Log L;
+    auto il = qbe(L,
+                  "mut r: i64 = 0;\n"
+                  "func add(a: i32, b: i64) { r = a + b; }\n");
+    INFO(L.toString());
+    REQUIRE_FALSE(L.hasErrors());
+    INFO(il);
+    CHECK(contains(il, "export function $add(w %t1, l %t2) {"));
+    CHECK(contains(il, "    %t3 =l alloc4 4\n"
+                       "    %t4 =l alloc8 8\n"
+                       "    storew %t1, %t3\n"
+                       "    storel %t2, %t4\n"));
+    // the narrower operand is extended before the addition
+    CHECK(contains(il, "    %t7 =l extsw %t5\n"
+                       "    %t8 =l add %t7, %t6\n"
+                       "    storel %t8, $r\n"));
+    CHECK(contains(il, "    ret\n}"));
+}
+
+TEST_CASE("QBE main returns 0 and constants are folded", "[qbe]")
+{
+    Log L;
+    auto il = qbe(L,
+                  "mut r: i64 = 0;\n"
+                  "func main() { r = 5 / 2 + 2 ** 3; }\n");
+    INFO(L.toString());
+    REQUIRE_FALSE(L.hasErrors());
+    INFO(il);
+    CHECK(contains(il, "export function w $main() {"));
+    CHECK(contains(il, "    storel 10, $r\n"
+                       "    ret 0\n"));
+}
+
+TEST_CASE("QBE loops branch on their condition", "[qbe]")
+{
+    Log L;
+    auto il = qbe(L,
+                  "mut g: i32 = 3;\n"
+                  "func f() { while (g) g--; }\n");
+    INFO(L.toString());
+    REQUIRE_FALSE(L.hasErrors());
+    INFO(il);
+    CHECK(contains(il, "@L1\n"
+                       "    %t1 =w loadw $g\n"
+                       "    %t2 =w cnew %t1, 0\n"
+                       "    jnz %t2, @L2, @L3\n"));
+    CHECK(contains(il, "    storew %t4, $g\n"
+                       "    jmp @L1\n"
+                       "@L3\n"));
+}
+
+TEST_CASE("QBE inner variables hide the outer ones", "[qbe]")
+{
+    Log L;
+    auto il = qbe(L,
+                  "mut r: i64 = 0;\n"
+                  "func f() {\n"
+                  "    mut x: i32 = 1;\n"
+                  "    { mut x: i64 = 2; r = x; }\n"
+                  "    r = x;\n"
+                  "}\n");
+    INFO(L.toString());
+    REQUIRE_FALSE(L.hasErrors());
+    INFO(il);
+    CHECK(contains(il, "    %t3 =l loadl %t2\n"
+                       "    storel %t3, $r\n"
+                       "    %t4 =w loadw %t1\n"));
+}
+
+TEST_CASE("QBE rejects shifts of floating point values", "[qbe]")
+{
+    Log L;
+    qbe(L,
+        "mut d: f64 = 1.0;\n"
+        "mut w: i32 = 1;\n"
+        "func f() { d = d << 2; w = w >> 1.5; d <<= w; }\n");
+    CHECK(count(L, Diag::InvalidOperation) == 3);
+    CHECK(contains(L.toString(), "operator '<<' cannot be applied to values "
+                                 "of type 'f64'"));
+}
+
+TEST_CASE("QBE folds the innermost immutable variable", "[qbe]")
+{
+    Log L;
+    auto il = qbe(L,
+                  "imm x: i64 = 1;\n"
+                  "mut r: i64 = 0;\n"
+                  "func f() {\n"
+                  "    { imm x: i64 = 2; r = x; }\n"
+                  "    { mut x: i64 = 3; x = 4; r = x; }\n"
+                  "    r = x;\n"
+                  "}\n");
+    INFO(L.toString());
+    REQUIRE_FALSE(L.hasErrors());
+    INFO(il);
+    CHECK(contains(il, "    storel 2, $r\n"));
+    CHECK(contains(il, "    storel 1, $r\n"));
+}
@@ -0,0 +1,106 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-08
+ */
+
+#include "catch2/catch.hpp"
+
+#include "compiler/strings.hpp"
+
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace cstar;
+
+TEST_CASE("Strings are interned once", "[strings]")
+{
+    std::string a = "interned", b = "interned";
+    auto id = Strings::id(a);
+    CHECK(Strings::id(b) == id);
+    CHECK(Strings::get(id) == "interned");
+
+    // the interned copy does not depend on the original
+    CHECK(Strings::intern(a).data() == Strings::intern(b).data());
+    CHECK(Strings::intern(a).data() != a.data());
+    a.assign(a.size(), 'x');
+    CHECK(Strings::get(id) == "interned");
+}
+
+TEST_CASE("Distinct strings have distinct ids", "[strings]")
+{
+    CHECK(Strings::id("abc") != Strings::id("abd"));
+    CHECK(Strings::id("abc") != Strings::id("ab"));
+    CHECK(Strings::id("") != Strings::id(std::string_view{"\0", 1}));
+    CHECK(Strings::get(Strings::id("")).empty());
+    CHECK(Strings::get(Strings::id(std::string_view{"\0", 1})).size() == 1);
+}
+
+TEST_CASE("Interned strings keep their hash", "[strings]")
+{
+    for (auto str : {"", "a", "hash", "a somewhat longer string"}) {
+        auto id = Strings::id(str);
+        CHECK(Strings::hash(id) == Strings::hash(std::string_view{str}));
+    }
+}
+
+TEST_CASE("Interned strings stay valid as the interner grows", "[strings]")
+{
+    constexpr auto COUNT = 200000;
+    std::vector<Strings::Id> ids;
+    std::vector<std::string_view> views;
+    for (auto i = 0; i < COUNT; i++) {
+        auto str = "grow-" + std::to_string(i);
+        ids.push_back(Strings::id(str));
+        views.push_back(Strings::get(ids.back()));
+    }
+
+    std::set<Strings::Id> unique(ids.begin(), ids.end());
+    CHECK(unique.size() == COUNT);
+    for (auto i = 0; i < COUNT; i++) {
+        auto str = "grow-" + std::to_string(i);
+        REQUIRE(Strings::id(str) == ids[i]);
+        REQUIRE(Strings::get(ids[i]).data() == views[i].data());
+        REQUIRE(views[i] == str);
+    }
+}
+
+TEST_CASE("Strings can be interned from several threads", "[strings]")
+{
+    constexpr auto THREADS = 8, COUNT = 20000;
+
+    // every thread interns the same strings in a different order, and
+    // strings of its own
+    std::vector<std::vector<Strings::Id>> shared(THREADS);
+    std::vector<std::thread> threads;
+    for (auto t = 0; t < THREADS; t++) {
+        threads.emplace_back([t, &shared] {
+            auto &ids = shared[t];
+            ids.resize(COUNT);
+            for (auto n = 0; n < COUNT; n++) {
+                auto i = (n * 7919 + t * 1031) % COUNT;
+                ids[i] = Strings::id("shared-" + std::to_string(i));
+                Strings::id("own-" + std::to_string(t) + "-" +
+                            std::to_string(n));
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    for (auto t = 1; t < THREADS; t++)
+        REQUIRE(shared[t] == shared[0]);
+    for (auto i = 0; i < COUNT; i++) {
+        REQUIRE(Strings::get(shared[0][i]) == "shared-" + std::to_string(i));
+    }
+    for (auto t = 0; t < THREADS; t++) {
+        auto own = "own-" + std::to_string(t) + "-" + std::to_string(COUNT - 1);
+        REQUIRE(Strings::get(Strings::id(own)) == own);
+    }
+}
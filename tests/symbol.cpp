@@ -0,0 +1,161 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-08
+ */
+
+#include "catch2/catch.hpp"
+
+#include "compiler/ast.hpp"
+#include "compiler/symbol.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace cstar;
+
+namespace {
+
+/**
+ * Distinct nodes to bind, symbols are told apart by their value
+ */
+struct Values {
+    Node::Ptr operator[](std::size_t i)
+    {
+        while (nodes.size() <= i)
+            nodes.push_back(arena.make<Block>(Range{}));
+        return nodes[i];
+    }
+
+    AstArena arena{};
+    std::vector<Node::Ptr> nodes{};
+};
+
+Node::Ptr value(const SymbolTable &table, Strings::Id name, int depth = -1)
+{
+    auto sym = depth < 0 ? table.find(name) : table.find(name, depth);
+    return sym ? sym->value : nullptr;
+}
+
+} // namespace
+
+TEST_CASE("SymbolTable restores shadowed bindings on pop", "[symbol]")
+{
+    Values v;
+    SymbolTable table;
+    auto a = Strings::id("a"), b = Strings::id("b");
+
+    REQUIRE(table.define(a, v[0], {}, symVariable));
+    CHECK(table.depth() == 0);
+
+    table.push();
+    REQUIRE(table.define(a, v[1], {}, symVariable));
+    REQUIRE(table.define(b, v[2], {}, symVariable));
+    CHECK(value(table, a) == v[1]);
+    CHECK(table.find(a)->scope == 1);
+
+    table.push();
+    REQUIRE(table.define(a, v[3], {}, symFunc));
+    CHECK(value(table, a) == v[3]);
+    CHECK(table.find(a)->kind == symFunc);
+    CHECK(value(table, b) == v[2]);
+
+    table.pop();
+    CHECK(value(table, a) == v[1]);
+    CHECK(table.find(a)->kind == symVariable);
+    CHECK(value(table, b) == v[2]);
+
+    table.pop();
+    CHECK(value(table, a) == v[0]);
+    CHECK(table.find(b) == nullptr);
+    CHECK(table.depth() == 0);
+}
+
+TEST_CASE("SymbolTable rejects redefinitions in the same scope", "[symbol]")
+{
+    Values v;
+    SymbolTable table;
+    auto x = Strings::id("x");
+
+    REQUIRE(table.define(x, v[0], {}, symVariable));
+    CHECK_FALSE(table.define(x, v[1], {}, symVariable));
+    CHECK(value(table, x) == v[0]);
+
+    table.push();
+    CHECK(table.define(x, v[1], {}, symVariable));
+    CHECK_FALSE(table.define(x, v[2], {}, symVariable));
+    table.pop();
+
+    // the binding popped with its scope can be defined again
+    table.push();
+    CHECK(table.define(x, v[3], {}, symVariable));
+    CHECK(value(table, x) == v[3]);
+    table.pop();
+}
+
+TEST_CASE("SymbolTable lookups are limited to the given depth", "[symbol]")
+{
+    Values v;
+    SymbolTable table;
+    auto outer = Strings::id("outer"), inner = Strings::id("inner");
+
+    REQUIRE(table.define(outer, v[0], {}, symVariable));
+    for (auto i = 0; i < 3; i++)
+        table.push();
+    REQUIRE(table.define(inner, v[1], {}, symVariable));
+
+    CHECK(value(table, inner, 0) == v[1]);
+    CHECK(value(table, outer, 0) == nullptr);
+    CHECK(value(table, outer, 2) == nullptr);
+    CHECK(value(table, outer, 3) == v[0]);
+    CHECK(value(table, outer) == v[0]);
+    CHECK(table.find(inner, -1) == nullptr);
+
+    for (auto i = 0; i < 3; i++)
+        table.pop();
+}
+
+TEST_CASE("SymbolTable assigns the innermost binding", "[symbol]")
+{
+    Values v;
+    SymbolTable table;
+    auto y = Strings::id("y");
+
+    CHECK_FALSE(table.assign(y, v[0]));
+    REQUIRE(table.define(y, v[0], {}, symVariable));
+    table.push();
+    REQUIRE(table.define(y, v[1], {}, symVariable));
+    CHECK(table.assign(y, v[2]));
+    CHECK(value(table, y) == v[2]);
+    table.pop();
+    CHECK(value(table, y) == v[0]);
+}
+
+TEST_CASE("SymbolTable keeps its bindings when it grows", "[symbol]")
+{
+    Values v;
+    SymbolTable table;
+    std::vector<Strings::Id> names;
+    for (auto i = 0; i < 1000; i++)
+        names.push_back(Strings::id("grow" + std::to_string(i)));
+
+    // every name is defined globally and shadowed in a scope, the table
+    // grows while the scope is open
+    for (std::size_t i = 0; i < 500; i++)
+        REQUIRE(table.define(names[i], v[i], {}, symVariable));
+    table.push();
+    for (std::size_t i = 0; i < names.size(); i++)
+        REQUIRE(table.define(names[i], v[1000 + i], {}, symVariable));
+    for (std::size_t i = 0; i < names.size(); i++)
+        REQUIRE(value(table, names[i]) == v[1000 + i]);
+
+    table.pop();
+    for (std::size_t i = 0; i < names.size(); i++) {
+        INFO(i);
+        REQUIRE(value(table, names[i]) == (i < 500 ? v[i] : nullptr));
+    }
+}
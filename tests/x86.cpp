@@ -0,0 +1,288 @@
+/**
+ * Copyright (c) 2022 suilteam, Carter
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Mpho Mbotho
+ * @date 2022-12-14
+ */
+
+#include "catch2/catch.hpp"
+
+#include "compiler/fold.hpp"
+#include "compiler/lexer.hpp"
+#include "compiler/lower.hpp"
+#include "compiler/parser.hpp"
+#include "compiler/source.hpp"
+#include "compiler/symbol.hpp"
+#include "compiler/x86.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace cstar;
+
+namespace {
+
+/**
+ * Compiles the given program to the given object, folded like the driver
+ * does
+ *
+ * @return false on errors
+ */
+bool compile(Log &L, std::string code, ElfObject &object)
+{
+    Source src{"x86.cstr", std::move(code)};
+    Lexer lexer{L, src, gflLexerSkipComments};
+    Parser parser(L, lexer, std::make_shared<SymbolTable>());
+    Program program;
+    if (!parser.parse(program))
+        return false;
+
+    Folding folding{L};
+    if (!folding.fold(program))
+        return false;
+
+    X86Codegen codegen{object};
+    Lowering lowering{L, codegen};
+    return lowering.lower(program);
+}
+
+/**
+ * @return the machine code of the given program
+ */
+std::vector<std::uint8_t> text(Log &L, std::string code)
+{
+    ElfObject object;
+    compile(L, std::move(code), object);
+    return object.text();
+}
+
+/**
+ * Links the object of the given program with a C harness defining `main`
+ * and runs it. CC in the environment overrides the C compiler, as it does
+ * for the driver.
+ *
+ * @return what the harness printed
+ */
+std::string run(Log &L, std::string code, std::string_view harness)
+{
+    ElfObject object;
+    if (!compile(L, std::move(code), object))
+        return {};
+
+    auto dir = (std::filesystem::temp_directory_path() / "cstar-x86-XXXXXX")
+                   .string();
+    if (mkdtemp(dir.data()) == nullptr)
+        return {};
+    std::filesystem::path path{dir};
+    {
+        CodeWriter out;
+        object.write(out);
+        std::ofstream os{path / "object.o", std::ios::binary};
+        out.flush(os);
+        std::ofstream{path / "harness.c"} << harness;
+    }
+
+    auto cc = std::getenv("CC");
+    auto command = std::string{cc ? cc : "cc"} + " -o " +
+                   (path / "run").string() + " " +
+                   (path / "harness.c").string() + " " +
+                   (path / "object.o").string() + " && " +
+                   (path / "run").string();
+    std::string output;
+    if (auto pipe = popen(command.c_str(), "r")) {
+        char buf[256];
+        while (auto n = std::fread(buf, 1, sizeof(buf), pipe))
+            output.append(buf, n);
+        if (pclose(pipe) != 0)
+            output += "<failed>";
+    }
+    std::filesystem::remove_all(path);
+    return output;
+}
+
+/**
+ * @return a function summing enough nested globals to spill temporaries
+ */
+std::string spilling()
+{
+    std::string code, sum = "g0";
+    for (int i = 0; i < 24; i++)
+        code += "mut g" + std::to_string(i) + ": i64 = 0;\n";
+    for (int i = 1; i < 24; i++)
+        sum = "g" + std::to_string(i) + " + (" + sum + ")";
+    return code + "mut res: i64 = 0;\nfunc big() { res = " + sum + "; }\n";
+}
+
+constexpr std::string_view EIGHT =
+    "func eight(a: i64, b: i64, c: i64, d: i64,\n"
+    "           e: i64, f: i64, g: i64, h: i64) { res = g * 10 + h; }\n";
+
+} // namespace
+
+TEST_CASE("x86 functions do not inherit the spills of previous ones",
+          "[x86]")
+{
+    Log L;
+    auto alone = text(L, "mut res: i64 = 0;\n" + std::string{EIGHT});
+    auto after = text(L, spilling() + std::string{EIGHT});
+    INFO(L.toString());
+    REQUIRE_FALSE(L.hasErrors());
+    REQUIRE(after.size() > alone.size());
+
+    // eight reads g and h from the stack at the same offsets, with the
+    // same frame, whether or not a spilling function comes before it
+    std::vector<std::uint8_t> tail{after.end() - alone.size(), after.end()};
+    CHECK(tail == alone);
+}
+
+TEST_CASE("x86 narrow and unsigned values wrap like C", "[x86]")
+{
+    Log L;
+    auto output = run(L,
+                      "mut n: i8 = 0;\n"
+                      "mut b: u8 = 0;\n"
+                      "mut w: u32 = 0;\n"
+                      "mut q: u64 = 0;\n"
+                      "func wrap(x: i8, y: u8, z: u32, d: u64) {\n"
+                      "    n = x + 1;\n"
+                      "    b = y + 1;\n"
+                      "    w = z * 2;\n"
+                      "    q = d / 3;\n"
+                      "}\n",
+                      R"(#include <stdint.h>
+#include <stdio.h>
+extern int8_t n;
+extern uint8_t b;
+extern uint32_t w;
+extern uint64_t q;
+void wrap(int8_t, uint8_t, uint32_t, uint64_t);
+int main(void)
+{
+    wrap(127, 255, 0x80000001u, UINT64_MAX);
+    printf("%d %u %u %llu\n", n, b, w, (unsigned long long)q);
+    return 0;
+}
+)");
+    INFO(L.toString());
+    REQUIRE_FALSE(L.hasErrors());
+    CHECK(output == "-128 0 2 6148914691236517205\n");
+}
+
+TEST_CASE("x86 arguments past the registers are passed on the stack",
+          "[x86]")
+{
+    Log L;
+    auto output = run(
+        L,
+        "mut r: i64 = 0;\n"
+        "mut f: f64 = 0.0;\n"
+        "mut s: f32 = 0.0;\n"
+        "func ints(a: i64, b: i32, c: i16, d: i8, e: u64,\n"
+        "          g: u32, h: u16, i: u8, j: i64) {\n"
+        "    r = a + b * 10 + c * 100 + d * 1000 + e * 10000 +\n"
+        "        g * 100000 + h * 1000000 + i * 10000000 + j * 100000000;\n"
+        "}\n"
+        "func floats(a: f64, b: f64, c: f64, d: f64, e: f64, g: f32,\n"
+        "            h: f64, i: f64, j: f64, k: f32, n: i32) {\n"
+        "    f = a + b * 2.0 + c * 3.0 + d * 4.0 + e * 5.0 + g * 6.0 +\n"
+        "        h * 7.0 + i * 8.0 + j * 9.0 + k * 10.0 + n;\n"
+        "    s = g + k;\n"
+        "}\n",
+        R"(#include <stdint.h>
+#include <stdio.h>
+extern int64_t r;
+extern double f;
+extern float s;
+void ints(int64_t, int32_t, int16_t, int8_t, uint64_t,
+          uint32_t, uint16_t, uint8_t, int64_t);
+void floats(double, double, double, double, double, float,
+            double, double, double, float, int32_t);
+int main(void)
+{
+    ints(1, 2, 3, 4, 5, 6, 7, 8, 9);
+    floats(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11);
+    printf("%lld %g %g\n", (long long)r, f, s);
+    return 0;
+}
+)");
+    INFO(L.toString());
+    REQUIRE_FALSE(L.hasErrors());
+    CHECK(output == "987654321 396 16\n");
+}
+
+TEST_CASE("x86 functions can call themselves", "[x86]")
+{
+    Log L;
+    auto output = run(L,
+                      "mut r: i64 = 0;\n"
+                      "func fib(n: i64) {\n"
+                      "    if (n < 2)\n"
+                      "        r = r + n;\n"
+                      "    else {\n"
+                      "        fib(n - 1);\n"
+                      "        fib(n - 2);\n"
+                      "    }\n"
+                      "}\n",
+                      R"(#include <stdint.h>
+#include <stdio.h>
+extern int64_t r;
+void fib(int64_t);
+int main(void)
+{
+    fib(20);
+    printf("%lld\n", (long long)r);
+    return 0;
+}
+)");
+    INFO(L.toString());
+    REQUIRE_FALSE(L.hasErrors());
+    CHECK(output == "6765\n");
+}
+
+TEST_CASE("x86 logical and conditional operators short-circuit", "[x86]")
+{
+    Log L;
+    // dividing by zero traps if the right operand is evaluated
+    auto output = run(L,
+                      "mut r: i64 = 0;\n"
+                      "mut f: f64 = 0.0;\n"
+                      "func logical(a: i64) {\n"
+                      "    r = (a != 0 && 10 / a > 2) * 10 +\n"
+                      "        (a == 0 || 10 / a > 2);\n"
+                      "}\n"
+                      "func ternary(a: i64, x: f64) {\n"
+                      "    r = a != 0 ? 10 / a : a - 1;\n"
+                      "    f = a > 0 ? x : x * 0.5;\n"
+                      "}\n",
+                      R"(#include <stdint.h>
+#include <stdio.h>
+extern int64_t r;
+extern double f;
+void logical(int64_t);
+void ternary(int64_t, double);
+int main(void)
+{
+    logical(0);
+    printf("%lld ", (long long)r);
+    logical(3);
+    printf("%lld ", (long long)r);
+    logical(5);
+    printf("%lld\n", (long long)r);
+    ternary(4, 3.0);
+    printf("%lld %g ", (long long)r, f);
+    ternary(0, 3.0);
+    printf("%lld %g\n", (long long)r, f);
+    return 0;
+}
+)");
+    INFO(L.toString());
+    REQUIRE_FALSE(L.hasErrors());
+    CHECK(output == "1 11 0\n2 3 -1 1.5\n");
+}